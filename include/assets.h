@@ -0,0 +1,137 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================
+// ASSET PARTITION
+// Fonts, icons and glyph atlases live in the "assets" flash partition
+// instead of the app image: the partition is mapped into the data
+// cache at boot and every asset is a pointer into it, read in place.
+// New fonts or icons only need the partition reflashed (the image is
+// built by src/host/asset_pack.cpp). Plain C++, no Arduino.
+// =================================================================
+
+// Formato (little endian):
+//   header 16 byte | directory 32 byte [count] | blob allineati a 4 byte
+#define ASSETS_MAGIC "TBA1"
+#define ASSETS_VERSION 1
+#define ASSETS_MAX 64
+#define ASSET_NAME_MAX 20
+
+// 1 = Arial14 e le icone restano anche nel firmware, usati se la
+// partizione manca; 0 = solo System5x7, il resto viene dalla partizione
+#ifndef ASSETS_BUILTIN
+#define ASSETS_BUILTIN 1
+#endif
+
+enum AssetType : uint8_t {
+  ASSET_FONT_DMD = 1, // Font DMD originale (colonne, LSB in alto)
+  ASSET_BITMAP = 2,   // AssetBitmapHeader + righe MSB first
+  ASSET_FONT_PACKED = 3, // Glyph atlas a righe di word (packed_font.h)
+};
+
+struct AssetsHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t count;
+  uint32_t size; // Immagine intera, header compreso
+  uint32_t crc;  // CRC-32 di tutto ciò che segue l'header
+};
+
+struct AssetEntry {
+  char name[ASSET_NAME_MAX]; // Terminato da NUL
+  uint8_t type;
+  uint8_t reserved[3];
+  uint32_t offset; // Dall'inizio dell'immagine
+  uint32_t size;
+};
+
+struct AssetBitmapHeader {
+  uint16_t width;
+  uint16_t height;
+};
+
+static_assert(sizeof(AssetsHeader) == 16, "assets header layout");
+static_assert(sizeof(AssetEntry) == 32, "asset entry layout");
+
+/**
+ * @brief A 1-bpp bitmap in the drawBitmap() layout: rows of
+ * (width + 7) / 8 bytes, MSB is the leftmost pixel.
+ */
+struct AssetBitmap {
+  uint16_t width;
+  uint16_t height;
+  const uint8_t *bits;
+};
+
+class AssetStore {
+public:
+  AssetStore();
+
+  /**
+   * @brief Validates an image (magic, version, size, CRC, entry bounds)
+   * and uses it in place: data must outlive the store.
+   */
+  bool attach(const uint8_t *data, size_t size);
+
+  bool valid() const { return base != nullptr; }
+  uint16_t count() const { return entryCount; }
+
+  /**
+   * @brief Finds an asset by name and type.
+   * @return Pointer to its blob, nullptr if missing.
+   */
+  const uint8_t *find(const char *name, AssetType type,
+                      size_t *size = nullptr) const;
+
+  bool bitmap(const char *name, AssetBitmap &out) const;
+
+private:
+  const uint8_t *base;
+  const AssetEntry *entries;
+  uint16_t entryCount;
+};
+
+/**
+ * @brief Collects blobs and writes an image (the host packer).
+ */
+class AssetImageBuilder {
+public:
+  AssetImageBuilder();
+
+  /**
+   * @return false if the directory is full or the name too long.
+   */
+  bool add(const char *name, AssetType type, const uint8_t *data,
+           size_t size);
+  bool addBitmap(const char *name, const uint8_t *bits, uint16_t width,
+                 uint16_t height);
+
+  size_t imageSize() const;
+
+  /**
+   * @return Image length, 0 if out is too small.
+   */
+  size_t write(uint8_t *out, size_t size) const;
+
+private:
+  struct Pending {
+    AssetEntry entry;
+    const uint8_t *data;
+    AssetBitmapHeader bitmap; // Solo per ASSET_BITMAP, precede data
+  };
+  Pending pending[ASSETS_MAX];
+  uint16_t pendingCount;
+};
+
+#ifndef NATIVE_BUILD
+/**
+ * @brief The asset partition, mapped once. Invalid (count 0) if the
+ * partition is missing or not flashed.
+ */
+const AssetStore &assetsFlash();
+#endif
+
+#endif
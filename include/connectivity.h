@@ -0,0 +1,49 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <stdint.h>
+
+// =================================================================
+// CONNECTIVITY MANAGER
+// Wi-Fi is driven entirely by events: disconnects schedule a background
+// reconnect with exponential backoff, nothing ever blocks the loop.
+// =================================================================
+
+enum ConnState {
+  CONN_DOWN,       // Nessun link, riconnessione programmata
+  CONN_CONNECTING, // Associazione o DHCP in corso
+  CONN_UP          // Link attivo con indirizzo IP
+};
+
+#define CONN_BACKOFF_MIN_MS 1000
+#define CONN_BACKOFF_MAX_MS 60000
+// Dopo questo tempo senza rete si riavvia la scheda
+#define CONN_RESTART_AFTER_MS (15UL * 60 * 1000)
+
+/**
+ * @brief Registers the Wi-Fi event handlers and starts connecting.
+ * Returns immediately.
+ */
+void connectivityBegin(const char *ssid, const char *password,
+                       const char *hostname);
+
+/**
+ * @brief Loop-side housekeeping: starts the reconnect attempt the
+ * backoff timer asked for and restarts the board after a very long
+ * outage. Never blocks.
+ */
+void connectivityPoll();
+
+ConnState connectivityState();
+
+inline bool connectivityUp() { return connectivityState() == CONN_UP; }
+
+/**
+ * @brief Incremented on every transition to CONN_UP, so callers can
+ * detect a reconnect since they last looked.
+ */
+uint32_t connectivityGeneration();
+
+void connectivityDumpStats();
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef DATA_FEED_H
+#define DATA_FEED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "data_provider.h"
+#include "fetch_scheduler.h"
+#include "snapshot.h"
+
+// =================================================================
+// DATA FEEDS
+// One feed per part of the snapshot (departures, weather, station
+// name), each with its own TTL, its own FetchScheduler (phase, jitter,
+// backoff, server hints) and a cached copy of its last good data. The
+// feeds that are due and share a provider go out as one request that
+// asks only for their parts; the display shows merge() of the caches.
+// Plain C++, also built for the host simulator.
+// =================================================================
+
+// TTL "una volta per boot": dopo il primo successo il feed non scade
+// più, gli errori riprovano con il backoff fino a questo intervallo
+#define DATA_FEED_ONCE 0
+#define DATA_FEED_ONCE_RETRY_MS (60 * 60 * 1000UL)
+// I feed dello stesso provider che scadono entro questa finestra
+// partono con la richiesta già in uscita
+#define DATA_FEED_COALESCE_MS 60000
+#define DATA_FEED_MAX 4
+
+class DataFeed {
+public:
+  /**
+   * @param field The SnapshotField this feed keeps (one bit).
+   * @param ttlMs Refresh period, or DATA_FEED_ONCE.
+   * @param jitterMs Random shift of each period, see FetchScheduler.
+   */
+  DataFeed(const char *name, DataProvider &provider, uint8_t field,
+           uint32_t ttlMs, uint32_t jitterMs);
+
+  const char *name() const { return label; }
+  DataProvider &provider() const { return source; }
+  uint8_t field() const { return part; }
+
+  bool due(uint32_t nowMs) const {
+    return !(once && valid) && scheduler.due(nowMs);
+  }
+  uint32_t nextFetchMs() const { return scheduler.nextFetchMs(); }
+  uint32_t phaseMs() const { return scheduler.phaseMs(); }
+
+  // Dati in cache, validi dal primo successo
+  bool hasData() const { return valid; }
+  const Snapshot &cached() const { return cache; }
+  uint32_t refreshedMs() const { return lastOkMs; }
+
+  uint32_t refreshes() const { return okCount; }
+  uint32_t failures() const { return failCount; }
+
+private:
+  friend class DataFeeds;
+
+  void begin(uint32_t nowMs, uint64_t deviceId, uint32_t seed);
+  void onSuccess(uint32_t nowMs, const FetchHints &hints,
+                 const Snapshot &snap);
+  void onFailure(uint32_t nowMs, const FetchHints &hints);
+
+  const char *label;
+  DataProvider &source;
+  uint8_t part;
+  bool once;
+  bool valid;
+  FetchScheduler scheduler;
+  Snapshot cache;
+  uint32_t lastOkMs;
+  uint32_t okCount;
+  uint32_t failCount;
+};
+
+class DataFeeds {
+public:
+  DataFeeds();
+
+  /**
+   * @return false if DATA_FEED_MAX feeds are already registered.
+   */
+  bool add(DataFeed &feed);
+
+  /**
+   * @brief Starts every feed's scheduler. The feeds share deviceId, so
+   * they are all due together right after boot (one request for all).
+   */
+  void begin(uint32_t nowMs, uint64_t deviceId, uint32_t seed);
+
+  /**
+   * @param only SnapshotField mask of the feeds to consider.
+   */
+  bool due(uint32_t nowMs, uint8_t only = SNAPSHOT_ALL) const;
+
+  /**
+   * @return The earliest deadline among the feeds in only that still
+   * expire.
+   */
+  uint32_t nextFetchMs(uint32_t nowMs, uint8_t only = SNAPSHOT_ALL) const;
+
+  /**
+   * @brief Runs one request: the most overdue feed, plus the feeds of
+   * the same provider due within DATA_FEED_COALESCE_MS. Each of them is
+   * rescheduled from the result.
+   * @param snap Scratch for the parsed parts (those in refreshed).
+   * @param refreshed SnapshotField mask of the feeds refreshed, 0 on
+   * failure or if nothing was due.
+   * @param only SnapshotField mask of the feeds that may take part
+   * (e.g. without one held for the display, see FetchAligner).
+   */
+  FetchResult fetch(uint32_t nowMs, Snapshot &snap, uint8_t &refreshed,
+                    int64_t (*monoUs)(),
+                    void (*tap)(const uint8_t *, size_t),
+                    uint8_t only = SNAPSHOT_ALL);
+
+  /**
+   * @brief Builds the snapshot to show from the feeds' caches; the parts
+   * of the feeds without data yet stay empty.
+   */
+  void merge(Snapshot &snap) const;
+
+  size_t size() const { return count; }
+  const DataFeed &feed(size_t i) const { return *feeds[i]; }
+
+  // Provider dell'ultima richiesta, per i messaggi di errore
+  const DataProvider *lastProvider() const { return last; }
+
+  // Richieste e byte di body dal boot, per stimare il costo al giorno
+  uint32_t requests() const { return requestCount; }
+  uint64_t bodyBytes() const { return byteCount; }
+
+private:
+  DataFeed *feeds[DATA_FEED_MAX];
+  size_t count;
+  const DataProvider *last;
+  uint32_t requestCount;
+  uint64_t byteCount;
+};
+
+/**
+ * @brief Copies the parts in fields (a SnapshotField mask) from src.
+ */
+void snapshotCopyParts(Snapshot &dst, const Snapshot &src, uint8_t fields);
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef DATA_PROVIDER_H
+#define DATA_PROVIDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gtfs_rt.h"
+#include "http_fetch.h"
+#include "snapshot.h"
+
+// =================================================================
+// DATA PROVIDERS
+// Where the data feeds (data_feed.h) get the snapshot parts from: one
+// GET through httpFetch(), parsed as it streams into a Snapshot. A
+// provider fills only the SnapshotFields it is asked for. The JSON
+// proxy API has all three; a GTFS-Realtime TripUpdates feed (e.g. on
+// the LAN) can replace it for the departures. Plain C++, no Arduino.
+// =================================================================
+
+class DataProvider {
+public:
+  virtual ~DataProvider() {}
+
+  /**
+   * @brief Short name for the log and the error shown on the panel.
+   */
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief SnapshotField mask of what this source can fill.
+   */
+  virtual uint8_t fields() const = 0;
+
+  /**
+   * @brief Fetches and parses fresh data into snap (cleared first).
+   * An empty stationName means the source did not send one.
+   * @param fields SnapshotField mask to fill, a subset of fields().
+   * @param tap Optional body tap, see BodyReader::setTap().
+   * @return code 0 if the parts were filled without a request.
+   */
+  virtual FetchResult fetch(Snapshot &snap, uint8_t fields,
+                            int64_t (*monoUs)(),
+                            void (*tap)(const uint8_t *, size_t)) = 0;
+
+  /**
+   * @brief Opens the connection the next fetch(fields) will use, see
+   * HttpTransport::prewarm().
+   */
+  virtual bool prewarm(uint8_t fields, uint32_t timeoutMs) {
+    (void)fields;
+    (void)timeoutMs;
+    return false;
+  }
+};
+
+/**
+ * @brief The departures JSON proxy (weather and station name included),
+ * parsed by DeparturesParser, which skips the parts not asked for.
+ */
+class JsonApiProvider : public DataProvider {
+public:
+  /**
+   * @param metaUrl Used when the departures are not wanted, e.g. the
+   * same request with limit=0; nullptr = always url.
+   */
+  JsonApiProvider(HttpTransport &transport, const char *url,
+                  const char *metaUrl);
+
+  const char *name() const override { return "JSON"; }
+  uint8_t fields() const override { return SNAPSHOT_ALL; }
+  FetchResult fetch(Snapshot &snap, uint8_t fields, int64_t (*monoUs)(),
+                    void (*tap)(const uint8_t *, size_t)) override;
+  bool prewarm(uint8_t fields, uint32_t timeoutMs) override;
+
+private:
+  static bool parse(BodyReader &body, void *context);
+
+  HttpTransport &transport;
+  const char *url;
+  const char *metaUrl;
+  uint8_t wanted; // Durante fetch()
+  Snapshot *target;
+};
+
+/**
+ * @brief A GTFS-RT TripUpdates feed, filtered to one stop by
+ * GtfsRtDecoder. The feed has no weather; the station name is the
+ * configured one and costs no request.
+ */
+class GtfsRtProvider : public DataProvider {
+public:
+  /**
+   * @param stationName Shown as the station name (the feed has none).
+   * @param utcUs Wall clock, to drop departed trains; nullptr or a
+   * return of 0 (not synced) falls back to the feed timestamp.
+   */
+  GtfsRtProvider(HttpTransport &transport, const char *url,
+                 const char *stopId, const char *stationName,
+                 int64_t (*utcUs)());
+
+  const char *name() const override { return "GTFS-RT"; }
+  uint8_t fields() const override {
+    return SNAPSHOT_DEPARTURES | SNAPSHOT_STATION;
+  }
+  FetchResult fetch(Snapshot &snap, uint8_t fields, int64_t (*monoUs)(),
+                    void (*tap)(const uint8_t *, size_t)) override;
+  bool prewarm(uint8_t fields, uint32_t timeoutMs) override;
+
+  /**
+   * @brief Decoder counters of the last fetch.
+   */
+  const GtfsRtStats &lastStats() const { return stats; }
+
+private:
+  static bool parse(BodyReader &body, void *context);
+
+  HttpTransport &transport;
+  const char *url;
+  const char *stopId;
+  const char *stationName;
+  int64_t (*utcUs)();
+  Snapshot *target; // Durante fetch()
+  GtfsRtStats stats;
+};
+
+#endif
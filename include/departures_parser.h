@@ -0,0 +1,111 @@
+#ifndef DEPARTURES_PARSER_H
+#define DEPARTURES_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+// =================================================================
+// DEPARTURES PARSER
+// Streaming parser for the departures API payload, fed the body as it
+// arrives. No document is built: the few known keys are recognized
+// through a perfect hash computed at compile time and their values are
+// written straight into the Snapshot fields (truncated like
+// snapshotCopyField()). Everything else is tokenized and skipped. The
+// state is this object: a key of at most 13 bytes, one bit per
+// nesting level, the weather halves until they are joined. Plain C++,
+// no Arduino.
+// =================================================================
+
+// Oltre questo annidamento il payload è rifiutato (1 bit per livello)
+#define DEPARTURES_PARSER_DEPTH 32
+// "departureTime", la chiave più lunga
+#define DEPARTURES_PARSER_KEY_MAX 13
+
+class DeparturesParser {
+public:
+  /**
+   * @brief Clears snap, which is filled as the payload is fed.
+   * @param fields SnapshotField mask: the other parts of the payload
+   * are tokenized and skipped, and stay empty in snap.
+   */
+  explicit DeparturesParser(Snapshot &snap, uint8_t fields = SNAPSHOT_ALL);
+
+  /**
+   * @brief Parses the next bytes of the body.
+   * @return Bytes consumed: stops after the closing brace of the root
+   * object (like deserializeJson()) or at the first syntax error.
+   */
+  size_t feed(const char *data, size_t length);
+
+  // Oggetto radice chiuso: i dati in snap sono completi
+  bool done() const { return state == DONE; }
+  bool failed() const { return state == FAILED; }
+
+  // Senza stationName nel payload il chiamante tiene il nome precedente
+  bool hasStationName() const { return stationSeen; }
+
+private:
+  enum State : uint8_t {
+    EXPECT_VALUE,
+    EXPECT_VALUE_OR_END, // Dopo '['
+    EXPECT_KEY,
+    EXPECT_KEY_OR_END, // Dopo '{'
+    EXPECT_COLON,
+    EXPECT_COMMA_OR_END,
+    IN_KEY,
+    IN_STRING,
+    IN_ESCAPE,
+    IN_UNICODE,
+    IN_LITERAL, // Numeri, true, false, null
+    DONE,
+    FAILED,
+  };
+  // Di chi è l'oggetto o l'array aperto a ogni livello
+  enum Scope : uint8_t {
+    SCOPE_ROOT,
+    SCOPE_WEATHER,
+    SCOPE_DEPARTURES,
+    SCOPE_TRAIN,
+    SCOPE_SKIP,
+  };
+
+  bool step(char c);
+  bool beginValue(char c);
+  bool open(bool array);
+  bool close(bool array);
+  void endKey();
+  void beginField();
+  void endLiteral();
+  void put(char c);
+  void putCodePoint(uint32_t cp);
+  void finish();
+
+  Snapshot &snap;
+  uint8_t fields;
+  State state;
+  bool inKey; // IN_ESCAPE / IN_UNICODE tornano alla chiave
+  uint8_t depth;
+  uint32_t arrays; // Bit n: il livello n è un array
+  Scope scopes[4]; // Solo i primi livelli hanno un significato
+  int8_t key;      // Chiave del valore atteso, -1 se sconosciuta
+  char keyText[DEPARTURES_PARSER_KEY_MAX];
+  uint8_t keyLength;
+  uint32_t keyHash;
+  DepartureRecord *train; // Record del treno aperto
+  // Campo in scrittura, nullptr se il valore va scartato
+  char *out;
+  size_t room;
+  size_t length;
+  size_t literalStart;
+  uint32_t unicode;
+  uint8_t unicodeDigits;
+  uint16_t highSurrogate;
+  bool stationSeen;
+  bool weatherSeen;
+  char temperature[24];
+  char description[sizeof(Snapshot::weather)];
+};
+
+#endif
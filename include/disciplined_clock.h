@@ -0,0 +1,90 @@
+#ifndef DISCIPLINED_CLOCK_H
+#define DISCIPLINED_CLOCK_H
+
+#include <stdint.h>
+
+// =================================================================
+// DISCIPLINED CLOCK
+// Wall clock built on a monotonic microsecond counter. Offsets below
+// the step threshold are slewed (never stepped), and the crystal's
+// frequency error is estimated from the history of syncs so the clock
+// keeps time between them.
+// =================================================================
+
+#define CLOCK_SAMPLE_COUNT 8
+// Fastest slew allowed: 10% means a 1 s correction takes 10 s
+#define CLOCK_SLEW_MAX_PPM 100000
+// A sync closer than this to the last kept sample replaces it if more
+// precise, so the history spans hours (8 x 3 h) rather than minutes
+#define CLOCK_SAMPLE_MIN_GAP_US (3LL * 3600 * 1000000)
+// The drift is used only once its standard error is below this. With
+// the Date header (+-0.5 s) that takes about a day of syncs; with NTP
+// (a few ms) the first hours are enough
+#define CLOCK_DRIFT_MAX_ERROR_PPB 5000
+// Realistic crystal bound: estimates beyond it are clamped
+#define CLOCK_DRIFT_MAX_PPB 100000
+
+class DisciplinedClock {
+public:
+  DisciplinedClock();
+
+  /**
+   * @brief Feeds a reference time measurement.
+   * @param monoUs Monotonic time of the measurement.
+   * @param utcUs Reference UTC time (us since epoch) at monoUs.
+   * @param uncertaintyUs Half-width of the measurement error window; no
+   * phase correction is made while the clock is already inside it, and
+   * the drift fit weighs the sample by it.
+   * @param stepThresholdUs Larger offsets are stepped instead of slewed.
+   */
+  void sync(int64_t monoUs, int64_t utcUs, int64_t uncertaintyUs,
+            int64_t stepThresholdUs);
+
+  /**
+   * @brief UTC time in microseconds at the given monotonic time.
+   * Monotonic and continuous as long as no step is required.
+   */
+  int64_t utcAt(int64_t monoUs) const;
+
+  bool synced() const { return isSynced; }
+
+  /**
+   * @brief Estimated crystal frequency error in parts per million
+   * (positive = local oscillator runs slow), 0 until the syncs
+   * support an estimate.
+   */
+  float driftPpm() const { return rateBillionths / 1000.0f; }
+
+  /**
+   * @brief Phase correction still being slewed, in microseconds.
+   */
+  int64_t pendingSlewUs(int64_t monoUs) const;
+
+  uint32_t stepCount() const { return steps; }
+  uint32_t syncCount() const { return syncs; }
+
+private:
+  void rebase(int64_t monoUs);
+  void estimateDrift();
+
+  bool isSynced;
+  int64_t baseMono;
+  int64_t baseUtc;
+  int32_t rateBillionths; // Frequency correction in ppb
+
+  int64_t slewStart;
+  int64_t slewDuration;
+  int64_t slewTotal;
+
+  // Cronologia delle misure per la stima della deriva
+  int64_t sampleMono[CLOCK_SAMPLE_COUNT];
+  int64_t sampleUtc[CLOCK_SAMPLE_COUNT];
+  int64_t sampleUncertainty[CLOCK_SAMPLE_COUNT];
+  uint8_t sampleCount;
+  uint8_t sampleNext;
+
+  uint32_t steps;
+  uint32_t syncs;
+};
+
+#endif
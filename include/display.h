@@ -0,0 +1,92 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "framebuffer.h"
+#include "packed_font.h"
+#include "tile_renderer.h"
+
+// =================================================================
+// DISPLAY
+// DMD32's drawing calls (clearScreen, drawString, drawMarquee...) on
+// a Framebuffer with packed fonts, so the scenes read as they did
+// with DMD32. Between beginFrame() and endFrame() the calls are
+// recorded and rasterized per panel by a TileRenderer, on both cores
+// for large walls. Plain C++, no Arduino.
+// =================================================================
+
+#ifndef DISPLAY_MARQUEE_MAX
+#define DISPLAY_MARQUEE_MAX 256 // Come marqueeText[] di DMD32
+#endif
+
+class Display {
+public:
+  /**
+   * @param tiles Renders the recorded frames; nullptr draws them on the
+   * caller in one pass.
+   */
+  explicit Display(Framebuffer &fb, TileRenderer *tiles = nullptr);
+
+  Framebuffer &framebuffer() { return fb; }
+
+  /**
+   * @brief Records the following calls as one frame, drawn at
+   * endFrame(). No co_await in between: other scenes draw too.
+   */
+  void beginFrame();
+  void endFrame();
+
+  /**
+   * @param normal true: all off, false: all lit.
+   */
+  void clearScreen(bool normal = true);
+  void selectFont(const PackedFont &font);
+
+  void drawString(int x, int y, const char *text, size_t length,
+                  BlitMode mode = BLIT_NORMAL);
+  void drawBitmap(int x, int y, const Sprite &sprite,
+                  BlitMode mode = BLIT_NORMAL);
+  void writePixel(int x, int y, BlitMode mode, bool on);
+
+  /**
+   * @brief Status pixel composited over every frame, clear and draw
+   * until switched off, so scenes that redraw every few ms do not
+   * erase it. Unlit, the pixel is cleared once and then left to the
+   * scenes.
+   */
+  void setIndicator(int x, int y, bool lit);
+
+  /**
+   * @brief Starts a marquee with the current font; the text is copied.
+   */
+  void drawMarquee(const char *text, size_t length, int left, int top);
+
+  /**
+   * @brief Moves the marquee and redraws it on a cleared screen.
+   * @return true when the text has left the screen and wrapped around.
+   */
+  bool stepMarquee(int amountX, int amountY);
+
+private:
+  void flushFrame();
+  void drawIndicator();
+
+  Framebuffer &fb;
+  TileRenderer *tiles;
+  TileFrame frame;
+  bool recording;
+  const PackedFont *font;
+  int indicatorX;
+  int indicatorY;
+  bool indicatorLit;
+  char marqueeText[DISPLAY_MARQUEE_MAX];
+  size_t marqueeLength;
+  int marqueeWidth;
+  int marqueeHeight;
+  int marqueeX;
+  int marqueeY;
+};
+
+#endif
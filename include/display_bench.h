@@ -0,0 +1,29 @@
+#ifndef DISPLAY_BENCH_H
+#define DISPLAY_BENCH_H
+
+// =================================================================
+// DISPLAY BENCHMARK
+// With DISPLAY_BENCH=1 the board times, at boot and before the refresh
+// timer starts:
+// - glyph, icon and full-screen draws, DMD32 (one pixel at a time) vs
+//   the framebuffer blit kernels;
+// - one scan row for 1..DISPLAY_BENCH_MAX_PANELS panels in a row,
+//   DMD32's scanDisplayBySPI() vs PanelDriver::scan();
+// - one two-line frame per panel row through TileRenderer, walls of 1
+//   to 64 panels, on the loop core only vs with a worker on core 0.
+// Panels not wired up only shift the data further down the chain.
+// =================================================================
+
+#ifndef DISPLAY_BENCH
+#define DISPLAY_BENCH 0
+#endif
+
+#define DISPLAY_BENCH_ROUNDS 2000
+#define DISPLAY_BENCH_MAX_PANELS 8
+
+/**
+ * @brief Draws with System5x7, compiled in for both libraries.
+ */
+void displayBenchRun();
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FETCH_ALIGNER_H
+#define FETCH_ALIGNER_H
+
+#include <stdint.h>
+
+// =================================================================
+// FETCH ALIGNER
+// Lines the departures fetch up with the display cycle. It learns the
+// cycle period from the start of each departures scene and predicts
+// the next one. A departures fetch that falls due before that point is
+// held and run between the header and the departures scene, on a
+// connection pre-warmed (DNS, TCP, TLS) when the header scene starts:
+// the first train is drawn on data a fetch old, and no fetch blocks
+// the loop in the middle of an animation (see freshness.h for the age
+// at display). Plain C++, also built for the host simulator.
+// =================================================================
+
+// Un fetch non aspetta il tabellone più di così (oltre, parte subito)
+#ifndef FETCH_ALIGN_MAX_HOLD_MS
+#define FETCH_ALIGN_MAX_HOLD_MS 90000
+#endif
+
+class FetchAligner {
+public:
+  FetchAligner();
+
+  /**
+   * @brief Call when the departures scene starts.
+   */
+  void onDeparturesShown(uint32_t nowMs);
+
+  /**
+   * @brief true once the period is known and the cycle is on time
+   * (a stalled cycle stops the prediction until it shows up again).
+   */
+  bool predicting(uint32_t nowMs) const;
+
+  /**
+   * @return Predicted start of the next departures scene (millis);
+   * meaningful only while predicting().
+   */
+  uint32_t nextDeparturesMs() const { return lastStartMs + periodMs; }
+  uint32_t cycleMs() const { return periodMs; }
+
+  /**
+   * @brief Whether a departures fetch due at dueMs should wait for the
+   * next departures scene instead of running now.
+   */
+  bool hold(uint32_t nowMs, uint32_t dueMs) const;
+
+  /**
+   * @brief Whether a fetch due at dueMs falls before the next
+   * departures scene, i.e. it is worth pre-warming the connection.
+   */
+  bool dueBeforeDepartures(uint32_t nowMs, uint32_t dueMs) const;
+
+private:
+  uint32_t lastStartMs;
+  uint32_t periodMs; // Media mobile (1/4) del periodo del ciclo
+  uint32_t starts;
+};
+
+#endif
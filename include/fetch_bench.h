@@ -0,0 +1,42 @@
+#ifndef FETCH_BENCH_H
+#define FETCH_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================
+// FETCH BENCHMARK
+// With FETCH_BENCH=1 the board runs FETCH_BENCH_ROUNDS fetches with
+// each HTTP transport as soon as Wi-Fi is up and logs latency, heap
+// allocations and peak heap per fetch, then times full (pin-checked)
+// and resumed TLS handshakes, then carries on as usual.
+// Allocation counts need CONFIG_HEAP_USE_HOOKS (see platformio.ini).
+// =================================================================
+
+#ifndef FETCH_BENCH
+#define FETCH_BENCH 0
+#endif
+
+#define FETCH_BENCH_ROUNDS 5
+
+/**
+ * @brief Heap activity between fetchBenchHeapBegin() and
+ * fetchBenchHeapEnd(), across all tasks (lwIP and Wi-Fi included).
+ */
+struct HeapWindow {
+  uint32_t allocations;
+  uint32_t allocatedBytes;
+  int32_t peakLiveBytes; // Massimo allocato in più rispetto all'inizio
+  uint32_t freeBefore;
+  uint32_t freeAfter;
+};
+
+void fetchBenchHeapBegin();
+void fetchBenchHeapEnd(HeapWindow &window);
+
+/**
+ * @brief Runs the benchmark against url. Blocks for a few seconds.
+ */
+void fetchBenchRun(const char *url);
+
+#endif
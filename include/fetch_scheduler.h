@@ -0,0 +1,85 @@
+#ifndef FETCH_SCHEDULER_H
+#define FETCH_SCHEDULER_H
+
+#include <stdint.h>
+
+// =================================================================
+// FETCH SCHEDULER
+// Decides when the next API request goes out. Boards that boot
+// together must not hit the API together, so every device gets a
+// deterministic phase derived from its MAC, each period adds a bounded
+// random jitter, and server hints (Retry-After, Cache-Control max-age)
+// override the cadence. Plain C++, also built for the host simulator.
+// =================================================================
+
+// Il primo fetch dopo il boot viene distribuito su questa finestra
+#define FETCH_BOOT_SPREAD_MS 15000
+// Primo ritardo dopo un errore, poi raddoppia fino all'intervallo
+#define FETCH_RETRY_MIN_MS 30000
+// Oltre questo multiplo dell'intervallo ignoriamo max-age/Retry-After
+#define FETCH_HINT_MAX_INTERVALS 4
+
+struct FetchHints {
+  uint32_t retryAfterS; // 0 = assente
+  uint32_t maxAgeS;     // 0 = assente
+};
+
+class FetchScheduler {
+public:
+  /**
+   * @param intervalMs Nominal period between successful fetches.
+   * @param maxJitterMs Each period is moved by a random amount in
+   * [-maxJitterMs, +maxJitterMs].
+   */
+  FetchScheduler(uint32_t intervalMs, uint32_t maxJitterMs);
+
+  /**
+   * @brief Starts scheduling at nowMs.
+   * @param deviceId Stable per-device value (e.g. the MAC address): it
+   * picks the phase within the interval.
+   * @param seed Seed for the jitter generator.
+   */
+  void begin(uint32_t nowMs, uint64_t deviceId, uint32_t seed);
+
+  bool due(uint32_t nowMs) const { return (int32_t)(nowMs - nextMs) >= 0; }
+  uint32_t nextFetchMs() const { return nextMs; }
+
+  void onSuccess(uint32_t nowMs, const FetchHints &hints);
+  void onFailure(uint32_t nowMs, const FetchHints &hints);
+
+  /**
+   * @brief Makes the next fetch due now (e.g. on reconnect with stale
+   * data), keeping the phase for the following ones.
+   */
+  void requestNow(uint32_t nowMs) { nextMs = nowMs; }
+
+  uint32_t phaseMs() const { return phase; }
+  uint32_t consecutiveFailures() const { return failures; }
+
+private:
+  int32_t jitter();
+  uint32_t random32();
+
+  uint32_t interval;
+  uint32_t maxJitter;
+  uint32_t phase;
+  uint32_t anchorMs; // Griglia: anchorMs + k * interval
+  uint32_t nextMs;
+  uint32_t failures;
+  uint32_t rngState;
+};
+
+/**
+ * @brief Parses a Retry-After value given in delta-seconds.
+ * @return Seconds, or 0 if absent or not a number (HTTP-date values
+ * must be converted by the caller).
+ */
+uint32_t parseRetryAfterSeconds(const char *value);
+
+/**
+ * @brief Extracts max-age from a Cache-Control header.
+ * @return Seconds, or 0 if absent or no-cache/no-store.
+ */
+uint32_t parseCacheControlMaxAge(const char *value);
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packed_font.h"
+
+// =================================================================
+// FRAMEBUFFER
+// 1 bpp, width / 32 words per row; bit 31 of a word is its leftmost
+// pixel and 1 is a lit LED. Packed glyphs and sprites use the same bit
+// order, so every blit works on whole words: each source word is
+// shifted onto at most two screen words and combined with masks.
+// Plain C++, no Arduino.
+// =================================================================
+
+/**
+ * @brief Where the words live in memory. FB_SCAN_ORDER is the order a
+ * 1/4-scan P10 chain shifts its bytes in, so the refresh ISR sends one
+ * contiguous block per scan row:
+ *
+ *   [scan row 0..3][panel 0..n-1][byte 0..3][panel row 12, 8, 4, 0 (+scan)]
+ *
+ * Panels are numbered like DMD32 (x / 32 + across * (y / 16)) and the
+ * bytes are active low. A screen word (32 pixels of one panel row) is
+ * then 4 bytes, 4 apart: the kernels gather and scatter it.
+ */
+enum FramebufferLayout : uint8_t {
+  FB_ROW_MAJOR = 0,
+  FB_SCAN_ORDER = 1, // Altezza multipla di 16
+};
+
+// Stessi valori delle modalità GRAPHICS_* di DMD32
+enum BlitMode : uint8_t {
+  BLIT_NORMAL = 0,  // Copia opaca: anche i pixel spenti della sorgente
+  BLIT_INVERSE = 1, // Copia opaca invertita
+  BLIT_XOR = 2,     // GRAPHICS_TOGGLE
+  BLIT_OR = 3,
+  BLIT_NOR = 4, // Spegne dove la sorgente è accesa
+};
+
+/**
+ * @brief A 1-bpp source in framebuffer bit order: height rows of
+ * wordsPerRow words, bits past width are zero.
+ */
+struct Sprite {
+  const uint32_t *rows;
+  uint16_t width;
+  uint16_t height;
+  uint8_t wordsPerRow;
+};
+
+/**
+ * @brief Converts a drawBitmap()-style bitmap (rows of (width + 7) / 8
+ * bytes, MSB first) into sprite rows.
+ * @param out (width + 31) / 32 * height words.
+ */
+Sprite spriteFromBytes(const uint8_t *bits, uint16_t width, uint16_t height,
+                       uint32_t *out);
+
+class Framebuffer {
+public:
+  /**
+   * @param words width / 32 * height words, owned by the caller.
+   * @param width Multiple of 32 (one word per panel row).
+   */
+  Framebuffer(uint32_t *words, int width, int height,
+              FramebufferLayout layout = FB_ROW_MAJOR);
+
+  int width() const { return w; }
+  int height() const { return h; }
+  int wordsPerRow() const { return stride; }
+  FramebufferLayout layout() const { return order; }
+  const uint8_t *bytes() const { return (const uint8_t *)words; }
+  size_t size() const { return (size_t)stride * h * sizeof(uint32_t); }
+
+  // Solo FB_ROW_MAJOR
+  uint32_t *row(int y) { return words + y * stride; }
+  const uint32_t *row(int y) const { return words + y * stride; }
+
+  /**
+   * @brief Word k of row y (pixels 32k..32k+31) in either layout, 1 = lit.
+   */
+  uint32_t word(int y, int k) const;
+  void setWord(int y, int k, uint32_t value);
+
+  /**
+   * @brief Restricts blits and fills to a rectangle, x and width rounded
+   * out to whole words (e.g. one panel). clear() ignores it.
+   */
+  void setClip(int x, int y, int width, int height);
+  void clearClip();
+
+  void clear();
+  bool pixel(int x, int y) const;
+  void setPixel(int x, int y, BlitMode mode);
+
+  /**
+   * @brief Draws a sprite with its top-left corner at (x, y), clipped
+   * to the screen.
+   * @param cellWidth Width of the area the opaque modes overwrite, at
+   * least sprite.width (e.g. a glyph plus its spacing column).
+   */
+  void blit(int x, int y, const Sprite &sprite, BlitMode mode,
+            int cellWidth = 0);
+  void fillRect(int x, int y, int width, int height, BlitMode mode);
+
+  /**
+   * @brief Draws c like DMD32: in the opaque modes the spacing columns
+   * after the glyph are overwritten too.
+   * @return The advance (width + spacing), 0 if c is not in the font.
+   */
+  int drawChar(int x, int y, const PackedFont &font, uint8_t c,
+               BlitMode mode = BLIT_OR);
+  int drawText(int x, int y, const PackedFont &font, const char *text,
+               size_t length, BlitMode mode = BLIT_OR);
+
+private:
+  uint32_t *words;
+  int w;
+  int h;
+  int stride;
+  FramebufferLayout order;
+  // Clip: word [clipLo, clipHi), righe [clipTop, clipBottom)
+  int clipLo;
+  int clipHi;
+  int clipTop;
+  int clipBottom;
+};
+
+#endif
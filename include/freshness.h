@@ -0,0 +1,100 @@
+#ifndef FRESHNESS_H
+#define FRESHNESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================
+// DATA FRESHNESS
+// Timeline of the departures on screen (request sent, first byte,
+// parse complete, first frame drawn with them) and a histogram of
+// their age each time the departures scene starts. The log then
+// answers "how old was what the panel showed at 08:02", and the
+// histogram weighs the fetch cadence against the API cost. Times are
+// the monotonic clock (timeSourceMonoUs()); the age runs from the
+// request. Plain C++, also built for the host simulator.
+// =================================================================
+
+// Limiti dei bucket in secondi: <15 s, <30 s, <1 m, <2 m, <5 m, <10 m,
+// <15 m, oltre
+#define FRESHNESS_BUCKETS 8
+// Età per onShown() senza dati live (orario programmato, nessun dato)
+#define FRESHNESS_NO_DATA 0xffffffffu
+
+// Con dati live più vecchi di così le partenze hanno un pixel acceso in
+// basso a destra; 0 = mai. Vedi build_flags in platformio.ini
+#ifndef FRESHNESS_STALE_MARKER_S
+#define FRESHNESS_STALE_MARKER_S 0
+#endif
+
+struct DataTimeline {
+  int64_t requestUs;    // Richiesta inviata (per il relay: ricezione)
+  int64_t firstByteUs;  // Status line e header arrivati
+  int64_t parsedUs;     // Snapshot completo
+  int64_t renderedUs;   // Primo frame che le mostra, 0 = non ancora
+  int64_t requestUtcUs; // Ora UTC della richiesta, 0 se non sincronizzata
+};
+
+struct DataAgeStats {
+  uint32_t shown;  // Scene delle partenze con dati live
+  uint32_t noData; // ...senza
+  uint32_t lastMs;
+  uint32_t maxMs;
+  uint64_t sumMs;
+  uint32_t buckets[FRESHNESS_BUCKETS];
+};
+
+class DataFreshness {
+public:
+  DataFreshness();
+
+  /**
+   * @brief New departures are available; renderedUs is ignored.
+   */
+  void onData(const DataTimeline &timeline);
+
+  /**
+   * @brief A frame with the departures was drawn.
+   * @return true for the first frame of the current data (renderedUs
+   * was just set).
+   */
+  bool onRendered(int64_t nowUs);
+
+  /**
+   * @brief The departures scene starts: records the age in the
+   * histogram.
+   * @param live false if the screen shows no live data.
+   * @return The age in ms, or FRESHNESS_NO_DATA.
+   */
+  uint32_t onShown(int64_t nowUs, bool live);
+
+  bool hasData() const { return current.requestUs != 0; }
+  const DataTimeline &timeline() const { return current; }
+  uint32_t ageMs(int64_t nowUs) const;
+  const DataAgeStats &ageStats() const { return age; }
+
+  // Dalla richiesta al primo frame: ultimo e massimo
+  uint32_t lastLatencyMs() const { return latencyMs; }
+  uint32_t maxLatencyMs() const { return latencyMaxMs; }
+
+private:
+  DataTimeline current;
+  DataAgeStats age;
+  uint32_t latencyMs;
+  uint32_t latencyMaxMs;
+};
+
+/**
+ * @brief Upper limit of histogram bucket i in seconds, 0 for the last
+ * (open) one.
+ */
+uint32_t freshnessBucketLimitS(size_t i);
+
+/**
+ * @brief Writes the histogram as "<15s:3 <30s:5 ... >=15m:0".
+ * @return Length written (truncated to size - 1).
+ */
+size_t freshnessFormatHistogram(const DataAgeStats &stats, char *buf,
+                                size_t size);
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef GTFS_RT_H
+#define GTFS_RT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+// =================================================================
+// GTFS-REALTIME DECODER
+// Streaming protobuf decoder for a TripUpdates feed (FeedMessage),
+// fed the body as it arrives. It only descends into the messages it
+// needs (entity, trip_update, trip, vehicle, stop_time_update and
+// its arrival/departure events) and skips every other field in
+// bulk, whatever its size. The trips that stop at the configured
+// stop are kept in the snapshot, sorted by departure time, at most
+// SNAPSHOT_MAX_DEPARTURES. Memory is this object, for any feed size.
+// Plain C++, no Arduino.
+//
+// GTFS-RT carries no headsign: the record gets the route_id as type
+// and the vehicle label (else the trip_id) as destination.
+// =================================================================
+
+// FeedMessage > entity > trip_update > stop_time_update > departure
+#define GTFS_RT_DEPTH 6
+#define GTFS_RT_ID_MAX 40 // trip_id e label tenuti (troncati)
+// Partenze più vecchie di così rispetto a "adesso" sono scartate
+#define GTFS_RT_PAST_S 60
+
+struct GtfsRtStats {
+  uint32_t entities;
+  uint32_t tripUpdates;
+  uint32_t stopUpdates;
+  uint32_t matches; // stop_time_update della fermata, prima dei filtri
+};
+
+class GtfsRtDecoder {
+public:
+  /**
+   * @brief Clears snap, which is filled as the feed is decoded.
+   * @param stopId stop_id to keep; the string must outlive the decoder.
+   * @param nowUtc Unix seconds; 0 = the feed header timestamp.
+   */
+  GtfsRtDecoder(Snapshot &snap, const char *stopId, int64_t nowUtc);
+
+  /**
+   * @brief Decodes the next bytes of the feed.
+   * @return Bytes consumed, fewer only on a malformed feed.
+   */
+  size_t feed(const uint8_t *data, size_t length);
+
+  /**
+   * @brief Call at the end of the body.
+   * @return true if the feed ended on a field boundary.
+   */
+  bool finish();
+
+  bool failed() const { return state == FAILED; }
+  const GtfsRtStats &stats() const { return counters; }
+  int64_t feedTimestamp() const { return headerTime; }
+
+private:
+  enum State : uint8_t { TAG, VARINT, LENGTH, SKIP, STRING, FAILED };
+  // Messaggi in cui il decoder entra
+  enum Message : uint8_t {
+    MSG_FEED,
+    MSG_HEADER,
+    MSG_ENTITY,
+    MSG_TRIP_UPDATE,
+    MSG_TRIP,
+    MSG_VEHICLE,
+    MSG_STOP_TIME,
+    MSG_ARRIVAL,
+    MSG_DEPARTURE,
+    MSG_NONE,
+  };
+  struct Frame {
+    Message message;
+    uint32_t end; // Posizione nel flusso dove il messaggio finisce
+  };
+  // Evento di arrivo o partenza di uno stop_time_update
+  struct Event {
+    bool hasTime;
+    bool hasDelay;
+    int64_t time;
+    int32_t delay;
+  };
+
+  bool readVarint(uint8_t b);
+  void onTag();
+  void onVarint();
+  void onLength();
+  void endField();
+  Message child(uint32_t field) const;
+  void begin(Message message);
+  void end(Message message);
+  void commitTrip();
+  void insert(int64_t time, int64_t scheduled, int32_t delay);
+
+  Snapshot &snap;
+  const char *stopId;
+  size_t stopIdLength;
+  int64_t nowUtc;
+  State state;
+  uint8_t wireType;
+  uint8_t shift;
+  uint32_t field;
+  uint64_t value;
+  uint32_t pos;       // Byte consumati dall'inizio del feed
+  uint32_t remaining; // Byte da saltare o copiare
+  Frame stack[GTFS_RT_DEPTH];
+  uint8_t depth;
+
+  // Stringa in arrivo: copiata in out, o confrontata con stopId
+  char *out;
+  size_t room;
+  size_t length;
+  bool matchingStop;
+
+  // Entità e trip_update correnti
+  bool deleted;
+  bool canceled;
+  bool hasTripDelay;
+  int32_t tripDelay;
+  char tripId[GTFS_RT_ID_MAX];
+  char routeId[sizeof(DepartureRecord::type)];
+  char label[GTFS_RT_ID_MAX];
+  bool tripMatched;
+  Event tripEvent; // L'evento scelto alla fermata
+
+  // stop_time_update corrente
+  bool stopMatched;
+  bool stopSkipped;
+  Event arrival;
+  Event departure;
+
+  int64_t headerTime;
+  int64_t times[SNAPSHOT_MAX_DEPARTURES]; // Ordine dei record in snap
+  GtfsRtStats counters;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef HTTP_FETCH_H
+#define HTTP_FETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fetch_scheduler.h"
+#include "http_transport.h"
+
+// =================================================================
+// HTTP FETCH
+// One GET on any HttpTransport: status, the headers the scheduler and
+// the clock need, and the body streamed into a parser. Every failure
+// is classified, so the same code runs on the board and under fault
+// injection on the host. Plain C++, no Arduino.
+// =================================================================
+
+// Limite per connessione e per ogni lettura (era http.setTimeout(15000)).
+// Un fetch sano su link lento resta sotto i 5 s (env fetch_faults),
+// mentre ogni stallo congela il display per tutto il timeout
+#define FETCH_READ_TIMEOUT_MS 8000
+// Limite sull'intero fetch: un server che gocciola un byte alla volta
+// non rinnova mai il timeout di lettura e bloccherebbe il loop
+#define FETCH_DEADLINE_MS 12000
+
+enum FetchStatus {
+  FETCH_OK,
+  FETCH_BAD_URL,         // begin() fallita ("DNS Error")
+  FETCH_CONNECT_FAILED,  // Nessuna risposta ("Connection Failed")
+  FETCH_HTTP_ERROR,      // Stato diverso da 200
+  FETCH_BODY_FAILED,     // Corpo interrotto (timeout, reset, troncato)
+  FETCH_PARSE_FAILED     // Corpo completo ma non valido ("JSON Error")
+};
+
+const char *fetchStatusName(FetchStatus status);
+
+/**
+ * @brief Buffered reader over the response body, with the read()/
+ * readBytes() pair ArduinoJson accepts as a custom reader. Stops at the
+ * first transport error or when the fetch deadline passes.
+ */
+class BodyReader {
+public:
+  BodyReader(HttpTransport &transport, int64_t deadlineUs,
+             int64_t (*monoUs)());
+
+  int read();
+  size_t readBytes(char *buf, size_t length);
+
+  /**
+   * @brief Zero-copy read: points data at the bytes already buffered,
+   * refilling once from the transport if there are none, and consumes
+   * them.
+   * @return Their count, 0 at the end of the body or on error.
+   */
+  size_t readChunk(const char *&data);
+
+  /**
+   * @brief Called with every chunk read from the transport (e.g. to dump
+   * the payload to the log).
+   */
+  void setTap(void (*tap)(const uint8_t *data, size_t length)) {
+    tapFn = tap;
+  }
+
+  size_t bytesRead() const { return total; }
+  int error() const { return err; }
+
+private:
+  bool refill();
+
+  HttpTransport &transport;
+  int64_t deadlineUs;
+  int64_t (*monoUs)();
+  void (*tapFn)(const uint8_t *data, size_t length);
+  uint8_t buf[128];
+  size_t pos;
+  size_t length;
+  size_t total;
+  int err;
+  bool done;
+};
+
+/**
+ * @brief Parses the body. Returns false if the content is invalid or
+ * incomplete.
+ */
+typedef bool (*BodyParser)(BodyReader &body, void *context);
+
+struct FetchResult {
+  FetchStatus status;
+  int code; // Stato HTTP o codice HTTP_TRANSPORT_*
+  FetchHints hints;
+  char date[40]; // Header Date, "" se assente
+  int64_t sentUs;
+  int64_t headersUs;
+  int64_t doneUs;
+  size_t bodyBytes;
+};
+
+/**
+ * @brief Runs a GET and, on 200, feeds the body to parser.
+ * @param monoUs Monotonic clock in microseconds.
+ * @param tap Optional body tap, see BodyReader::setTap().
+ */
+FetchResult httpFetch(HttpTransport &transport, const char *url,
+                      BodyParser parser, void *context, int64_t (*monoUs)(),
+                      void (*tap)(const uint8_t *, size_t) = nullptr);
+
+#endif
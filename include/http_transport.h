@@ -0,0 +1,70 @@
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================
+// HTTP TRANSPORT
+// The minimal GET interface httpFetch() runs on: HTTPClient on the
+// board, a fault-injecting fake in the host build.
+// =================================================================
+
+// Codici negativi: gli stessi valori di HTTPClient dove esistono
+#define HTTP_TRANSPORT_REFUSED -1
+#define HTTP_TRANSPORT_CONNECTION_LOST -5
+#define HTTP_TRANSPORT_TIMEOUT -11
+#define HTTP_TRANSPORT_BAD_URL -100  // begin() fallita (URL, DNS)
+#define HTTP_TRANSPORT_TRUNCATED -101 // Chiusa prima di Content-Length
+#define HTTP_TRANSPORT_DEADLINE -102  // Superato il limite totale
+
+class HttpTransport {
+public:
+  virtual ~HttpTransport() {}
+
+  /**
+   * @brief Sends the request and waits for the status line and headers.
+   * @param headerKeys Response headers to keep, read back with header().
+   * @param timeoutMs Limit for connecting and receiving the headers.
+   * @return HTTP status, or a negative HTTP_TRANSPORT_* code.
+   */
+  virtual int get(const char *url, const char *const *headerKeys,
+                  size_t headerCount, uint32_t timeoutMs) = 0;
+
+  /**
+   * @return Value of headerKeys[index], "" if the response lacked it.
+   */
+  virtual const char *header(size_t index) = 0;
+
+  /**
+   * @brief Reads body bytes, waiting up to timeoutMs for the first one.
+   * @return Bytes read, 0 at the end of the body, or a negative
+   * HTTP_TRANSPORT_* code.
+   */
+  virtual int read(uint8_t *buf, size_t size, uint32_t timeoutMs) = 0;
+
+  /**
+   * @brief Closes the connection (safe to call in any state).
+   */
+  virtual void end() = 0;
+
+  /**
+   * @brief Opens (DNS, TCP, TLS) the connection to url's host ahead of
+   * the next get(), which then reuses it.
+   * @return false if the transport can't, or the connection failed.
+   */
+  virtual bool prewarm(const char *url, uint32_t timeoutMs) {
+    (void)url;
+    (void)timeoutMs;
+    return false;
+  }
+};
+
+#ifndef NATIVE_BUILD
+/**
+ * @brief Transport backed by the Arduino HTTPClient.
+ */
+HttpTransport &httpClientTransport();
+#endif
+
+#endif
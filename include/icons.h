@@ -0,0 +1,20 @@
+#ifndef ICONS_H
+#define ICONS_H
+
+// =================================================================
+// BUILT-IN ICONS
+// Compiled-in copies of the icons in the asset partition: used when
+// the partition is not flashed (ASSETS_BUILTIN) and by the packer.
+// =================================================================
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+// Train icon bitmap (16x16 pixels)
+const unsigned char trainIconBitmap[] PROGMEM = {
+    0xf0, 0x07, 0xc0, 0x03, 0x80, 0x01, 0x9e, 0x79, 0x9e, 0x79, 0x9e,
+    0x79, 0x9e, 0x79, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x98, 0x19,
+    0x98, 0x19, 0x88, 0x11, 0xc0, 0x03, 0xf3, 0xcf, 0xe7, 0xe7};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef LEAN_HTTP_H
+#define LEAN_HTTP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "http_transport.h"
+
+// =================================================================
+// LEAN HTTP/1.1 CLIENT
+// One GET to a known host without the String machinery of HTTPClient:
+// the status line and headers are parsed line by line in a fixed
+// buffer, only the headers asked for are kept, the body (plain,
+// Content-Length or chunked) is decoded straight into the caller's
+// buffer, and the socket is kept alive for the next request. Plain
+// C++, no Arduino.
+// =================================================================
+
+// Basta per la riga più lunga che ci interessa: le altre vengono saltate
+#define LEAN_HTTP_LINE_MAX 512
+#define LEAN_HTTP_HEADERS_MAX 4
+#define LEAN_HTTP_VALUE_MAX 64
+#define LEAN_HTTP_HOST_MAX 64
+#define LEAN_HTTP_PATH_MAX 256
+
+/**
+ * @brief Byte stream the client talks through: a TLS socket on the
+ * board, a scripted fake in the host build.
+ */
+class HttpSocket {
+public:
+  virtual ~HttpSocket() {}
+  virtual bool connect(const char *host, uint16_t port,
+                       uint32_t timeoutMs) = 0;
+  virtual bool connected() = 0;
+  virtual int write(const uint8_t *data, size_t length) = 0;
+  /**
+   * @brief Waits up to timeoutMs for data.
+   * @return Bytes read, 0 if the peer closed, or a negative
+   * HTTP_TRANSPORT_* code.
+   */
+  virtual int read(uint8_t *buf, size_t size, uint32_t timeoutMs) = 0;
+  virtual void stop() = 0;
+};
+
+class LeanHttpTransport : public HttpTransport {
+public:
+  explicit LeanHttpTransport(HttpSocket &socket);
+
+  int get(const char *url, const char *const *headerKeys, size_t headerCount,
+          uint32_t timeoutMs) override;
+  const char *header(size_t index) override;
+  int read(uint8_t *buf, size_t size, uint32_t timeoutMs) override;
+  void end() override;
+  bool prewarm(const char *url, uint32_t timeoutMs) override;
+
+  /**
+   * @brief Connections opened so far (requests minus reused sockets).
+   */
+  uint32_t connectCount() const { return connects; }
+
+private:
+  enum BodyMode { BODY_NONE, BODY_LENGTH, BODY_CHUNKED, BODY_CLOSE };
+  enum ChunkState { CHUNK_SIZE, CHUNK_DATA, CHUNK_DATA_END, CHUNK_TRAILER };
+
+  bool reconnect(const char *newHost, uint16_t newPort, uint32_t timeoutMs);
+  int request(const char *path, uint32_t timeoutMs);
+  int readHeaders(uint32_t timeoutMs);
+  bool headerLine(char *line, size_t length);
+  int nextByte(uint32_t timeoutMs);
+  int readRaw(uint8_t *buf, size_t size, uint32_t timeoutMs);
+  int readChunked(uint8_t *buf, size_t size, uint32_t timeoutMs);
+
+  HttpSocket &socket;
+  char host[LEAN_HTTP_HOST_MAX];
+  uint16_t port;
+  bool open;
+  bool reusable;
+  uint32_t connects;
+
+  const char *const *keys;
+  size_t keyCount;
+  char values[LEAN_HTTP_HEADERS_MAX][LEAN_HTTP_VALUE_MAX];
+
+  // Buffer di ricezione: righe degli header, poi i byte già letti del corpo
+  uint8_t buf[LEAN_HTTP_LINE_MAX];
+  size_t bufPos;
+  size_t bufLen;
+
+  int status;
+  BodyMode mode;
+  ChunkState chunkState;
+  uint32_t remaining; // Byte del corpo o del chunk corrente
+  bool finished;
+};
+
+/**
+ * @brief Splits "https://host[:port]/path" (http:// too).
+ * @return false if the URL is malformed or a part does not fit.
+ */
+bool leanHttpParseUrl(const char *url, char *host, size_t hostSize,
+                      uint16_t &port, const char *&path);
+
+#ifndef NATIVE_BUILD
+/**
+ * @brief LeanHttpTransport over a TLS socket (the fetch path default).
+ */
+HttpTransport &leanHttpsTransport();
+
+/**
+ * @brief LeanHttpTransport over plain TCP, for http:// URLs on the LAN.
+ */
+HttpTransport &leanHttpTransport();
+#endif
+
+#endif
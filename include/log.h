@@ -0,0 +1,179 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// =================================================================
+// LOG LEVELS
+// Everything above LOG_LEVEL is removed at compile time: the macro
+// expands to nothing and its arguments are never evaluated.
+// =================================================================
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_VERBOSE 5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Set to 1 (e.g. in secrets.h or build_flags) to dump raw API payloads
+#ifndef LOG_PAYLOAD_DUMP
+#define LOG_PAYLOAD_DUMP 0
+#endif
+
+// Ring buffer geometry: LOG_RING_SLOTS must be a power of two
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 32
+#endif
+#define LOG_ARG_BYTES 100
+
+// =================================================================
+// BINARY LOG RECORD
+// The hot path only copies the format pointer and the raw argument
+// values; the text is produced later by the drain task.
+// =================================================================
+enum LogArgTag : uint8_t {
+  LOG_ARG_I32,
+  LOG_ARG_U32,
+  LOG_ARG_I64,
+  LOG_ARG_U64,
+  LOG_ARG_F64,
+  LOG_ARG_STR,
+  LOG_ARG_PTR
+};
+
+struct LogRecord {
+  uint32_t timestamp; // millis() at the call site
+  const char *fmt;    // must be a string literal
+  uint8_t level;
+  uint8_t length; // bytes used in args[]
+  uint8_t args[LOG_ARG_BYTES];
+};
+
+struct LogEncoder {
+  LogRecord &rec;
+
+  void putRaw(LogArgTag tag, const void *value, size_t size) {
+    if (rec.length + 1 + size > LOG_ARG_BYTES)
+      return; // Argomenti troncati, il formatter stampa "?"
+    rec.args[rec.length++] = tag;
+    memcpy(&rec.args[rec.length], value, size);
+    rec.length += size;
+  }
+
+  void put(const char *s) {
+    if (!s)
+      s = "(null)";
+    // Le stringhe vengono copiate (troncate) perché il chiamante
+    // potrebbe liberarle prima che il drain task le formatti
+    size_t room = LOG_ARG_BYTES - rec.length;
+    if (room < 3)
+      return;
+    size_t n = strnlen(s, room - 3);
+    rec.args[rec.length++] = LOG_ARG_STR;
+    rec.args[rec.length++] = (uint8_t)n;
+    memcpy(&rec.args[rec.length], s, n);
+    rec.length += n;
+    rec.args[rec.length++] = '\0';
+  }
+  void put(char *s) { put((const char *)s); }
+
+  void put(double v) { putRaw(LOG_ARG_F64, &v, sizeof(v)); }
+  void put(float v) { put((double)v); }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value ||
+                          std::is_enum<T>::value>::type
+  put(T v) {
+    if (std::is_signed<T>::value && sizeof(T) <= 4) {
+      int32_t x = (int32_t)v;
+      putRaw(LOG_ARG_I32, &x, sizeof(x));
+    } else if (sizeof(T) <= 4) {
+      uint32_t x = (uint32_t)v;
+      putRaw(LOG_ARG_U32, &x, sizeof(x));
+    } else if (std::is_signed<T>::value) {
+      int64_t x = (int64_t)v;
+      putRaw(LOG_ARG_I64, &x, sizeof(x));
+    } else {
+      uint64_t x = (uint64_t)v;
+      putRaw(LOG_ARG_U64, &x, sizeof(x));
+    }
+  }
+
+  template <typename T> void put(T *p) {
+    const void *x = p;
+    putRaw(LOG_ARG_PTR, &x, sizeof(x));
+  }
+};
+
+// =================================================================
+// API
+// =================================================================
+void logInit();
+bool logPush(const LogRecord &rec);
+uint32_t logMillis();
+uint32_t logDroppedCount();
+void logFlush();
+void logDump(const char *label, const char *data, size_t length);
+
+/**
+ * @brief Encodes a log call into a binary record and queues it.
+ * Never blocks: if the ring is full the record is dropped and counted.
+ */
+template <typename... Args>
+void logWrite(uint8_t level, const char *fmt, Args... args) {
+  LogRecord rec;
+  rec.timestamp = logMillis();
+  rec.fmt = fmt;
+  rec.level = level;
+  rec.length = 0;
+  LogEncoder enc{rec};
+  (void)enc;
+  int expand[] = {0, (enc.put(args), 0)...};
+  (void)expand;
+  logPush(rec);
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(fmt, ...) logWrite(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(fmt, ...) logWrite(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(fmt, ...) logWrite(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(fmt, ...) logWrite(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOG_V(fmt, ...) logWrite(LOG_LEVEL_VERBOSE, fmt, ##__VA_ARGS__)
+#else
+#define LOG_V(fmt, ...) ((void)0)
+#endif
+
+#if LOG_PAYLOAD_DUMP
+#define LOG_PAYLOAD(label, data, length) logDump(label, data, length)
+#else
+#define LOG_PAYLOAD(label, data, length) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef NET_CONNECT_H
+#define NET_CONNECT_H
+
+#include <mbedtls/net_sockets.h>
+#include <stdint.h>
+
+// =================================================================
+// BOUNDED CONNECT
+// mbedtls_net_connect() without its unbounded waits: the DNS lookup
+// and the TCP handshake share one budget, so an unreachable host costs
+// the fetch timeout and not the OS connect timeout (tens of seconds
+// with the display frozen). Used by the TLS and the plain TCP socket.
+// =================================================================
+
+/**
+ * @brief Resolves host (IPv4) and opens a TCP connection within
+ * timeoutMs. The socket is left blocking, with sends bounded by
+ * timeoutMs too (a send that times out fails).
+ * @return 0, or an MBEDTLS_ERR_NET_* code (UNKNOWN_HOST also when the
+ * lookup runs out of time, CONNECT_FAILED when the handshake does).
+ */
+int netConnect(mbedtls_net_context *net, const char *host, uint16_t port,
+               uint32_t timeoutMs);
+
+#endif
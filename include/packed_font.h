@@ -0,0 +1,107 @@
+#ifndef PACKED_FONT_H
+#define PACKED_FONT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================
+// PACKED FONTS
+// Glyphs stored row-major, one or more 32-bit words per row with the
+// leftmost pixel in bit 31, the same bit order as the framebuffer: a
+// glyph row lands on the screen with one shift and two ORs. Built on
+// the host from DMD fonts (column-major, decoded per pixel by DMD32)
+// or BDF files, stored as ASSET_FONT_PACKED; the board converts its
+// built-in DMD fonts only if the partition lacks them. Plain C++, no
+// Arduino.
+// =================================================================
+
+// Formato: header 8 byte | PackedGlyph [charCount] | righe u32
+#define PACKED_FONT_MAGIC0 'P'
+#define PACKED_FONT_MAGIC1 'F'
+#define PACKED_FONT_VERSION 1
+
+struct PackedFontHeader {
+  char magic[2];
+  uint8_t version;
+  uint8_t height;
+  uint8_t firstChar;
+  uint8_t charCount;
+  uint8_t spacing; // Colonne vuote dopo ogni carattere (DMD32: 1)
+  uint8_t reserved;
+};
+
+struct PackedGlyph {
+  uint8_t width;       // 0 = carattere assente
+  uint8_t wordsPerRow; // (width + 31) / 32
+  uint16_t offset;     // Prima riga, in word dall'inizio delle righe
+};
+
+static_assert(sizeof(PackedFontHeader) == 8, "packed font header layout");
+static_assert(sizeof(PackedGlyph) == 4, "packed glyph layout");
+
+/**
+ * @brief One glyph: height rows of wordsPerRow words.
+ */
+struct GlyphBits {
+  uint8_t width;
+  uint8_t height;
+  uint8_t wordsPerRow;
+  const uint32_t *rows;
+};
+
+class PackedFont {
+public:
+  PackedFont();
+
+  /**
+   * @brief Validates a blob (header and glyph bounds) and uses it in
+   * place. The blob must be 4-byte aligned and outlive the font.
+   */
+  bool attach(const uint8_t *data, size_t size);
+
+  bool valid() const { return header != nullptr; }
+  uint8_t height() const { return header ? header->height : 0; }
+  uint8_t spacing() const { return header ? header->spacing : 0; }
+
+  /**
+   * @return false if c is outside the font.
+   */
+  bool glyph(uint8_t c, GlyphBits &out) const;
+
+  /**
+   * @brief Advance of c (width + spacing), 0 if missing.
+   */
+  int advance(uint8_t c) const;
+  int textWidth(const char *text, size_t length) const;
+
+private:
+  const PackedFontHeader *header;
+  const PackedGlyph *glyphs;
+  const uint32_t *rows;
+};
+
+/**
+ * @brief Blob length packedFontFromDmd() needs for a DMD font.
+ */
+size_t packedFontDmdSize(const uint8_t *dmd);
+
+/**
+ * @brief Converts a DMD font (the layout of fonts/Arial14.h) keeping
+ * DMD32's metrics, including its bottom-aligned last byte row.
+ * @param out 4-byte aligned.
+ * @return Blob length, 0 if out is too small.
+ */
+size_t packedFontFromDmd(const uint8_t *dmd, uint8_t *out, size_t size);
+
+#ifdef NATIVE_BUILD
+// Conversione BDF, solo sul PC (src/host/font_convert.cpp)
+
+/**
+ * @brief Converts a BDF font (characters 32..126; TTF sources go
+ * through otf2bdf first). Glyphs are placed on the font's baseline.
+ * @return Blob length, 0 if the file is malformed or out is too small.
+ */
+size_t packedFontFromBdf(const char *bdf, uint8_t *out, size_t size);
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef PANEL_H
+#define PANEL_H
+
+#include <stdint.h>
+
+#include "framebuffer.h"
+
+struct gptimer_t; // driver/gptimer.h
+
+// =================================================================
+// PANEL DRIVER
+// Refresh of a chain of 1/4-scan P10 panels, wired as for DMD32. The
+// framebuffer is kept in scan order (FB_SCAN_ORDER), so each scan()
+// sends one contiguous block of 16 bytes per panel over SPI, latches
+// it and lights the next group of rows. DMD32 gathered the same bytes
+// from four rows of its RAM, one SPI.transfer() per byte.
+//
+// The whole refresh path is cache-safe: the timer ISR, scan() and the
+// SPI and GPIO accesses it makes are in IRAM (registers only, no
+// Arduino HAL calls), the framebuffer is in internal RAM. With
+// CONFIG_GPTIMER_ISR_IRAM_SAFE (platformio.ini) the interrupt is
+// allocated with ESP_INTR_FLAG_IRAM and keeps firing while flash is
+// written (NVS, OTA); without it the panels freeze on one row.
+// =================================================================
+
+// Stessi pin di default di DMD32
+#ifndef PANEL_PIN_NOE
+#define PANEL_PIN_NOE 22
+#endif
+#ifndef PANEL_PIN_A
+#define PANEL_PIN_A 19
+#endif
+#ifndef PANEL_PIN_B
+#define PANEL_PIN_B 21
+#endif
+#ifndef PANEL_PIN_CLK
+#define PANEL_PIN_CLK 18
+#endif
+#ifndef PANEL_PIN_LATCH
+#define PANEL_PIN_LATCH 2
+#endif
+#ifndef PANEL_PIN_DATA
+#define PANEL_PIN_DATA 23
+#endif
+#ifndef PANEL_SPI_HZ
+#define PANEL_SPI_HZ 4000000 // SPI_CLOCK_DIV4 di DMD32
+#endif
+// 12 tick del timer a 40 kHz usato con DMD32
+#ifndef PANEL_SCAN_PERIOD_US
+#define PANEL_SCAN_PERIOD_US 300
+#endif
+
+/**
+ * @brief Time spent in scan(), one sample per scan row.
+ */
+struct PanelScanStats {
+  uint32_t rows;
+  uint32_t totalUs;
+  uint32_t maxUs;
+  uint32_t missed;   // Scan saltati: interrupt arrivati in ritardo
+  uint32_t maxGapUs; // Intervallo più lungo tra due scan
+};
+
+class PanelDriver {
+public:
+  PanelDriver(int across, int down);
+  ~PanelDriver();
+
+  /**
+   * @brief Allocates the framebuffer and sets up the pins and the SPI
+   * bus.
+   */
+  bool begin();
+
+  /**
+   * @brief Starts the refresh timer: scan() every periodUs, from the
+   * timer ISR.
+   */
+  bool start(uint32_t periodUs = PANEL_SCAN_PERIOD_US);
+
+  /**
+   * @brief The screen, valid (and cleared) after begin().
+   */
+  Framebuffer &framebuffer() { return fb; }
+  int panels() const { return across * down; }
+
+  /**
+   * @brief Shows the next scan row: a quarter of the rows of every
+   * panel. Called by the refresh timer ISR; safe with the cache off.
+   */
+  void scan();
+
+  /**
+   * @brief Copies the scan timings and starts a new window.
+   */
+  PanelScanStats takeStats();
+
+  /**
+   * @brief Logs the scan timings since the previous call.
+   */
+  void dumpStats();
+
+private:
+  int across;
+  int down;
+  uint32_t *words;
+  Framebuffer fb;
+  gptimer_t *timer;
+  // Copie per l'ISR: niente chiamate a funzioni in flash
+  const uint8_t *scanBytes;
+  uint32_t blockBytes;
+  uint32_t periodUs;
+  int64_t lastScanUs;
+  uint8_t phase;
+  PanelScanStats window;
+};
+
+#endif
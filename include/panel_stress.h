@@ -0,0 +1,24 @@
+#ifndef PANEL_STRESS_H
+#define PANEL_STRESS_H
+
+#include "panel.h"
+
+// =================================================================
+// PANEL STRESS TEST
+// With PANEL_STRESS=1 the board rewrites one sector of the spiffs
+// partition (unused by the firmware) in a loop for PANEL_STRESS_SECONDS
+// right after the refresh starts. Every erase and write turns the flash
+// cache off, as NVS, OTA and log-to-flash writes do. It then logs the
+// scans missed over that window: 0 with a cache-safe refresh path,
+// about one per PANEL_SCAN_PERIOD_US of flash time otherwise.
+// =================================================================
+
+#ifndef PANEL_STRESS
+#define PANEL_STRESS 0
+#endif
+
+#define PANEL_STRESS_SECONDS 10
+
+void panelStressRun(PanelDriver &panel);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+// =================================================================
+// POWER MANAGEMENT
+// The loop task sleeps between frame deadlines instead of spinning,
+// and esp_pm scales the CPU down to POWER_MIN_FREQ_MHZ while idle.
+// =================================================================
+
+#ifndef POWER_MAX_FREQ_MHZ
+#define POWER_MAX_FREQ_MHZ 240
+#endif
+// APB runs at min(CPU, 80 MHz): staying at 80 keeps the refresh timer
+// and SPI clocks stable without an extra lock
+#ifndef POWER_MIN_FREQ_MHZ
+#define POWER_MIN_FREQ_MHZ 80
+#endif
+
+/**
+ * @brief Configures dynamic frequency scaling and the PM locks. Must be
+ * called from the loop task (its handle is used for wake-ups).
+ */
+void powerInit();
+
+/**
+ * @brief Blocks the loop task until deadlineMs (millis) or until
+ * powerWake() is called, whichever comes first.
+ */
+void powerIdleUntil(uint32_t deadlineMs);
+
+/**
+ * @brief Wakes the loop task early (data ready, Wi-Fi event...).
+ * Safe to call from any task.
+ */
+void powerWake();
+
+/**
+ * @brief Holds the CPU at POWER_MAX_FREQ_MHZ while in scope, for
+ * latency-sensitive work such as TLS handshakes and parsing.
+ */
+class PowerBoost {
+public:
+  PowerBoost();
+  ~PowerBoost();
+};
+
+/**
+ * @brief Holds the APB frequency for the lifetime of the display
+ * refresh timer.
+ */
+void powerAcquireScanLock();
+
+/**
+ * @brief Logs loop CPU utilization and an estimated power draw for the
+ * window since the previous call, then resets the counters.
+ */
+void powerDumpStats();
+
+#endif
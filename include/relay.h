@@ -0,0 +1,119 @@
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+// =================================================================
+// LAN CACHING RELAY
+// In stations with several boards, one (the leader) fetches from the
+// API and multicasts the parsed snapshot; followers skip HTTPS and
+// fall back to fetching directly when the leader goes silent.
+// =================================================================
+
+#define RELAY_OFF 0
+#define RELAY_LEADER 1
+#define RELAY_FOLLOWER 2
+
+#ifndef RELAY_ROLE
+#define RELAY_ROLE RELAY_OFF
+#endif
+
+// 239.255.0.0/16: multicast "administratively scoped", resta in LAN
+#define RELAY_GROUP_A 239
+#define RELAY_GROUP_B 255
+#define RELAY_GROUP_C 42
+#define RELAY_GROUP_D 42
+#define RELAY_PORT 4242
+
+// Il leader ripete l'ultimo snapshot anche senza fetch nuovi
+#define RELAY_REPEAT_MS 30000
+// Dopo questo silenzio il follower torna a chiedere all'API
+#define RELAY_SILENCE_MS (3 * RELAY_REPEAT_MS + 5000)
+// All'avvio il follower aspetta il leader prima di fare da sé
+#define RELAY_BOOT_GRACE_MS RELAY_REPEAT_MS
+
+/**
+ * @brief Datagram transport: UDP multicast on the board, loopback
+ * multicast sockets in the host build.
+ */
+class RelayLink {
+public:
+  virtual ~RelayLink() {}
+  virtual bool send(const uint8_t *data, size_t length) = 0;
+  /**
+   * @brief Non-blocking receive.
+   * @return Datagram length, or -1 if nothing is pending.
+   */
+  virtual int receive(uint8_t *buf, size_t size) = 0;
+};
+
+class RelayNode {
+public:
+  /**
+   * @param utcUsFn Leader: stamps each packet (repeats included) with the
+   * current UTC so followers can set their clock; nullptr to skip.
+   */
+  RelayNode(RelayLink &link, int role, uint32_t nodeId,
+            const char *stationCode, int64_t (*utcUsFn)() = nullptr);
+
+  /**
+   * @brief Leader: broadcasts a freshly fetched snapshot.
+   */
+  void publish(const Snapshot &snap, uint32_t nowMs);
+
+  /**
+   * @brief Leader: repeats the last snapshot every RELAY_REPEAT_MS.
+   * Follower: drains pending datagrams.
+   * @return true if a new snapshot was received (read it with latest()).
+   */
+  bool poll(uint32_t nowMs);
+
+  /**
+   * @brief Follower: true when no valid packet arrived for
+   * RELAY_SILENCE_MS (RELAY_BOOT_GRACE_MS after the first poll if none
+   * ever did), i.e. it must fetch by itself.
+   */
+  bool silent(uint32_t nowMs) const;
+
+  const Snapshot &latest() const { return snapshot; }
+  int role() const { return nodeRole; }
+
+  uint32_t sentCount() const { return sent; }
+  uint32_t receivedCount() const { return received; }
+  uint32_t rejectedCount() const { return rejected; }
+
+private:
+  void broadcast(uint32_t nowMs);
+
+  RelayLink &link;
+  int nodeRole;
+  uint32_t id;
+  const char *station;
+  int64_t (*utcNow)();
+
+  Snapshot snapshot;
+  bool haveSnapshot;
+  uint32_t lastSentMs;
+  uint32_t lastHeardMs;
+  bool everHeard;
+  bool started;
+  uint32_t startMs;
+  uint32_t lastLeader;
+  uint32_t lastSequence;
+
+  uint32_t sent;
+  uint32_t received;
+  uint32_t rejected;
+};
+
+#ifndef NATIVE_BUILD
+/**
+ * @brief Opens the multicast socket on the Wi-Fi interface.
+ */
+RelayLink &relayWiFiLink();
+#endif
+
+#endif
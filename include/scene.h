@@ -0,0 +1,188 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <coroutine>
+#include <stdint.h>
+
+// =================================================================
+// COROUTINE SCENES
+// A scene is a C++20 coroutine returning SceneTask. It draws, then
+// co_awaits nextFrame() or sleepFor(ms) to give control back to the
+// runner; scenes can co_await other scenes to sequence them. Frames
+// live on the heap (a few hundred bytes each), no extra stacks.
+// =================================================================
+
+/**
+ * @brief CPU time accounting bucket. Declare one per scene as a static,
+ * then open a SceneScope at the top of the coroutine.
+ */
+struct SceneStats {
+  SceneStats(const char *name);
+
+  const char *name;
+  uint64_t cpuUs;
+  uint32_t slices;
+  uint32_t maxSliceUs;
+  SceneStats *next; // Lista di tutte le statistiche registrate
+
+  static SceneStats *first;
+};
+
+struct SceneRoot {
+  std::coroutine_handle<> resumePoint; // Coroutine più interna sospesa
+  std::coroutine_handle<> top;         // Coroutine radice (null = slot libero)
+  uint32_t wakeAtMs;
+  SceneStats *stats; // Bucket a cui addebitare il tempo CPU
+};
+
+class SceneTask {
+public:
+  struct promise_type {
+    std::coroutine_handle<> continuation;
+
+    SceneTask get_return_object() {
+      return SceneTask(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    // Lazy: la scena parte solo quando viene attesa o registrata
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+        // Torna a chi ci aspettava (symmetric transfer), senza ricorsione
+        std::coroutine_handle<> next = h.promise().continuation;
+        return next ? next : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void return_void() {}
+    void unhandled_exception() {}
+  };
+
+  SceneTask(SceneTask &&other) : handle(other.handle) {
+    other.handle = nullptr;
+  }
+  SceneTask(const SceneTask &) = delete;
+  SceneTask &operator=(const SceneTask &) = delete;
+  ~SceneTask() {
+    if (handle)
+      handle.destroy();
+  }
+
+  // co_await su una scena figlia: la avvia subito e ci riprende alla fine
+  bool await_ready() const noexcept { return !handle || handle.done(); }
+  std::coroutine_handle<>
+  await_suspend(std::coroutine_handle<> parent) noexcept {
+    handle.promise().continuation = parent;
+    return handle;
+  }
+  void await_resume() const noexcept {}
+
+private:
+  friend class SceneRunner;
+  explicit SceneTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+  std::coroutine_handle<promise_type> release() {
+    std::coroutine_handle<promise_type> h = handle;
+    handle = nullptr;
+    return h;
+  }
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+#define SCENE_MAX_ROOTS 4
+
+class SceneRunner {
+public:
+  typedef uint32_t (*ClockFn)();
+
+  SceneRunner(ClockFn millisFn, ClockFn microsFn);
+
+  /**
+   * @brief Registers a top-level scene. Roots run interleaved; a root
+   * whose coroutine returns is removed.
+   * @param stats Default CPU time bucket for the root.
+   */
+  bool add(SceneStats &stats, SceneTask task);
+
+  /**
+   * @brief Resumes every root whose wake time has passed.
+   */
+  void tick();
+
+  /**
+   * @brief Earliest wake time among the roots (millis), for idling.
+   */
+  uint32_t nextWakeMs() const;
+
+  uint32_t nowMs() const { return millisFn(); }
+
+  void dumpStats();
+
+  // Usati dagli awaitable: la radice in esecuzione in questo momento
+  SceneRoot *current() const { return running; }
+
+private:
+  ClockFn millisFn;
+  ClockFn microsFn;
+  SceneRoot roots[SCENE_MAX_ROOTS];
+  SceneRoot *running;
+  uint32_t statsSinceUs;
+};
+
+extern SceneRunner sceneRunner;
+
+// =================================================================
+// AWAITABLES
+// =================================================================
+
+struct SceneSleep {
+  uint32_t wakeAtMs;
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> h) noexcept {
+    SceneRoot *root = sceneRunner.current();
+    root->resumePoint = h;
+    root->wakeAtMs = wakeAtMs;
+  }
+  void await_resume() const noexcept {}
+};
+
+/**
+ * @brief Suspends until the next runner tick.
+ */
+inline SceneSleep nextFrame() { return SceneSleep{sceneRunner.nowMs()}; }
+
+/**
+ * @brief Suspends for at least ms milliseconds.
+ */
+inline SceneSleep sleepFor(uint32_t ms) {
+  return SceneSleep{sceneRunner.nowMs() + ms};
+}
+
+/**
+ * @brief Suspends until the given millis() deadline.
+ */
+inline SceneSleep sleepUntil(uint32_t deadlineMs) {
+  return SceneSleep{deadlineMs};
+}
+
+/**
+ * @brief Charges CPU time of the enclosing coroutine to stats until it
+ * goes out of scope (then the previous bucket is restored).
+ */
+class SceneScope {
+public:
+  SceneScope(SceneStats &stats);
+  ~SceneScope();
+
+private:
+  SceneRoot *root;
+  SceneStats *previous;
+};
+
+#endif
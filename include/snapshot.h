@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================
+// DEPARTURES SNAPSHOT
+// Fixed-size copy of everything the display shows, with a compact
+// binary wire format (used by the LAN relay). Plain C++, no Arduino.
+// =================================================================
+
+#define SNAPSHOT_MAX_DEPARTURES 8
+
+struct DepartureRecord {
+  char type[8];
+  char destination[40];
+  char departureTime[8];
+  char delay[12];
+};
+
+struct Snapshot {
+  uint32_t sequence; // Incrementato a ogni fetch riuscito dal leader
+  int64_t utcUs;     // Ora del leader all'invio, 0 se non sincronizzata
+  char weather[64];
+  char stationName[40];
+  uint8_t count;
+  DepartureRecord departures[SNAPSHOT_MAX_DEPARTURES];
+};
+
+// Parti di uno snapshot, come maschera: ogni DataFeed ne aggiorna una
+enum SnapshotField : uint8_t {
+  SNAPSHOT_DEPARTURES = 1,
+  SNAPSHOT_WEATHER = 2,
+  SNAPSHOT_STATION = 4,
+  SNAPSHOT_ALL = 7,
+};
+
+// Header (16) + stringhe con prefisso di lunghezza + CRC (4)
+#define SNAPSHOT_WIRE_MAX 1024
+
+/**
+ * @brief Serializes a snapshot.
+ * @param leaderId Identifies the sender (e.g. low bits of its MAC).
+ * @param stationCode Only receivers configured for the same station
+ * accept the packet.
+ * @return Encoded length, 0 if buf is too small.
+ */
+size_t snapshotEncode(const Snapshot &snap, uint32_t leaderId,
+                      const char *stationCode, uint8_t *buf, size_t size);
+
+/**
+ * @brief Parses and validates (magic, version, station, CRC) a packet.
+ * @return false for foreign, corrupt or truncated packets.
+ */
+bool snapshotDecode(const uint8_t *buf, size_t length,
+                    const char *stationCode, Snapshot &snap,
+                    uint32_t &leaderId);
+
+/**
+ * @brief Copies src into a fixed field, always NUL-terminated.
+ */
+void snapshotCopyField(char *dst, size_t size, const char *src);
+
+/**
+ * @brief CRC-32 (IEEE) used by the snapshot and timetable formats.
+ */
+uint32_t snapshotCrc32(const uint8_t *data, size_t length);
+
+#endif
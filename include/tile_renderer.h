@@ -0,0 +1,157 @@
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "framebuffer.h"
+#include "packed_font.h"
+
+// =================================================================
+// TILE RENDERER
+// A frame is recorded as a short list of draw commands (TileFrame),
+// then rasterized one panel (32x16 tile) at a time. Tiles do not share
+// framebuffer bytes in either layout, so two workers can rasterize
+// them at once: each takes the next tile index from an atomic counter
+// and render() returns once every tile is counted done (frame
+// barrier). The caller is always one of the workers; the other one,
+// if any, is woken through setHelper(). If the helper is preempted in
+// the middle of a tile, the caller blocks on setBarrier()'s hooks
+// after a short spin instead of burning its core. Plain C++, no
+// Arduino.
+// =================================================================
+
+#ifndef TILE_FRAME_COMMANDS
+#define TILE_FRAME_COMMANDS 48
+#endif
+#ifndef TILE_FRAME_TEXT
+#define TILE_FRAME_TEXT 1024 // Byte di testo per frame
+#endif
+// Con meno tile svegliare il secondo worker costa più di quanto rende
+#ifndef TILE_MIN_PARALLEL
+#define TILE_MIN_PARALLEL 4
+#endif
+// Giri di attesa attiva alla barriera prima di bloccarsi (un tile
+// rasterizzato dall'altro worker dura pochi microsecondi)
+#ifndef TILE_BARRIER_SPIN
+#define TILE_BARRIER_SPIN 2000
+#endif
+// 1: tutto sul core del chiamante; 2: un worker anche sull'altro core
+#ifndef TILE_WORKERS
+#define TILE_WORKERS 2
+#endif
+
+/**
+ * @brief The draw calls of one frame. Text is copied; fonts and sprite
+ * rows must stay valid until the frame is rendered.
+ */
+class TileFrame {
+public:
+  TileFrame();
+
+  void reset();
+  // false (e il comando viene perso) se il frame è pieno
+  bool clear();
+  bool fillRect(int x, int y, int width, int height, BlitMode mode);
+  bool blit(int x, int y, const Sprite &sprite, BlitMode mode);
+  bool drawText(int x, int y, const PackedFont &font, const char *text,
+                size_t length, BlitMode mode);
+
+  size_t size() const { return count; }
+  bool overflowed() const { return overflow; }
+
+  /**
+   * @brief Replays the commands that touch the rectangle, drawing
+   * through fb (already clipped to it by the caller).
+   */
+  void rasterize(Framebuffer &fb, int x, int y, int width,
+                 int height) const;
+
+private:
+  enum Kind : uint8_t { CMD_CLEAR, CMD_FILL, CMD_BLIT, CMD_TEXT };
+  struct Command {
+    Kind kind;
+    BlitMode mode;
+    int16_t x;
+    int16_t y;
+    int16_t width; // Area coperta, per scartare i tile non toccati
+    int16_t height;
+    uint16_t text; // Offset in texts
+    uint16_t length;
+    const void *source; // PackedFont o righe dello sprite
+    uint8_t wordsPerRow;
+  };
+
+  Command *add(Kind kind, int x, int y, int width, int height,
+               BlitMode mode);
+
+  Command commands[TILE_FRAME_COMMANDS];
+  char texts[TILE_FRAME_TEXT];
+  size_t count;
+  size_t textUsed;
+  bool overflow;
+};
+
+class TileRenderer {
+public:
+  typedef void (*WakeFn)(void *arg);
+
+  explicit TileRenderer(Framebuffer &fb);
+
+  /**
+   * @brief Second worker: wake(arg) must make it call help() soon.
+   * nullptr to rasterize on the caller only.
+   */
+  void setHelper(WakeFn wake, void *arg);
+  bool hasHelper() const { return wake != nullptr; }
+
+  /**
+   * @brief Blocking frame barrier. After TILE_BARRIER_SPIN checks,
+   * render() calls wait(arg) until the frame is done (wait may return
+   * early: the caller checks again). The helper calls finished(arg) when
+   * the frame is done on its side. nullptr to spin only.
+   */
+  void setBarrier(WakeFn wait, WakeFn finished, void *arg);
+
+  /**
+   * @brief Rasterizes frame into the framebuffer. Returns when every
+   * tile is done. One frame at a time, from one task.
+   */
+  void render(const TileFrame &frame);
+
+  /**
+   * @brief Worker side: rasterizes tiles of the current frame until
+   * none is left. Harmless if there is no frame in flight.
+   */
+  void help();
+
+  int tiles() const;
+  uint32_t helperTiles() const { return helped.load(); }
+
+private:
+  int runTiles();
+
+  Framebuffer &fb;
+  WakeFn wake;
+  void *wakeArg;
+  WakeFn barrierWait;
+  WakeFn barrierFinished;
+  void *barrierArg;
+  std::atomic<const TileFrame *> current;
+  std::atomic<int> tileCount;
+  std::atomic<int> next; // Prossimo tile da prendere
+  std::atomic<int> done; // Tile finiti nel frame corrente
+  std::atomic<uint32_t> helped;
+};
+
+#ifndef NATIVE_BUILD
+/**
+ * @brief Starts the second worker as a task pinned to core (the loop
+ * task runs on core 1) and registers it with the renderer.
+ */
+bool tileWorkerStart(TileRenderer &renderer, int core = 0);
+#endif
+
+#endif
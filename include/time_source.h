@@ -0,0 +1,83 @@
+#ifndef TIME_SOURCE_H
+#define TIME_SOURCE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Set to 1 to also run SNTP in the background (never waited on at boot)
+#ifndef USE_NTP
+#define USE_NTP 0
+#endif
+
+#ifndef NTP_SERVER
+#define NTP_SERVER "pool.ntp.org"
+#endif
+
+// Offsets larger than this are stepped, smaller ones are slewed by the
+// disciplined clock over several seconds
+#define TIME_STEP_THRESHOLD_US 2000000LL
+
+/**
+ * @brief Parses an HTTP IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT").
+ * @return true and the UTC epoch in out if the string is well formed.
+ */
+bool parseHttpDate(const char *date, time_t &out);
+
+/**
+ * @brief Sets the timezone and, if USE_NTP is enabled, starts SNTP.
+ * Does not wait for any network.
+ */
+void timeSourceInit(const char *tz);
+
+/**
+ * @brief Feeds the Date header of an HTTP response into the clock.
+ * @param date Value of the Date header.
+ * @param sentUs Monotonic time (timeSourceMonoUs) when the request left.
+ * @param receivedUs Monotonic time when the response headers arrived.
+ */
+void timeSourceFromHttpDate(const char *date, int64_t sentUs,
+                            int64_t receivedUs);
+
+/**
+ * @brief Feeds a timestamp from another clock (e.g. the relay leader).
+ * @param utcUs Reference UTC in microseconds.
+ * @param monoUs Local monotonic time when utcUs was received.
+ * @param uncertaintyUs How far off the reference may be.
+ */
+void timeSourceFromReference(int64_t utcUs, int64_t monoUs,
+                             int64_t uncertaintyUs);
+
+/**
+ * @brief Monotonic microseconds since boot, the clock's time base.
+ */
+int64_t timeSourceMonoUs();
+
+/**
+ * @brief Measured crystal drift in ppm (0 until enough syncs).
+ */
+float timeSourceDriftPpm();
+
+/**
+ * @brief Milliseconds until the displayed second changes (1000 while
+ * unsynced), so the clock scene can sleep instead of polling.
+ */
+uint32_t timeSourceMsToNextSecond();
+
+/**
+ * @brief True once the clock has been set from any source.
+ */
+bool timeSourceSynced();
+
+/**
+ * @brief Current UTC in microseconds, 0 while the clock has never been set.
+ */
+int64_t timeSourceUtcUs();
+
+/**
+ * @brief Non-blocking replacement for getLocalTime(), read from the
+ * disciplined clock so seconds never jump or repeat on a correction.
+ * @return false while the clock has never been set.
+ */
+bool timeSourceLocalTime(struct tm *info);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef TIMETABLE_H
+#define TIMETABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+// =================================================================
+// OFFLINE TIMETABLE
+// Scheduled departures of the configured station, read in place from
+// the "timetable" flash partition. Entries are sorted by minute of
+// day and a 1440-slot index gives the first departure at or after any
+// minute, so a lookup is one array read. Plain C++, no Arduino.
+// =================================================================
+
+// Formato (little endian, come l'ESP32):
+//   header 32 byte | indice u16 [1441] | entry 32 byte [count]
+#define TIMETABLE_MAGIC "TTB1"
+#define TIMETABLE_VERSION 1
+#define TIMETABLE_MINUTES 1440
+#define TIMETABLE_MAX_ENTRIES 1500
+
+struct TimetableHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t count;
+  char station[8];
+  uint32_t crc; // CRC-32 di indice ed entry
+  uint8_t reserved[12];
+};
+
+struct TimetableEntry {
+  uint16_t minute; // Minuti dalla mezzanotte, 0..1439
+  char type[6];
+  char destination[24];
+};
+
+static_assert(sizeof(TimetableHeader) == 32, "timetable header layout");
+static_assert(sizeof(TimetableEntry) == 32, "timetable entry layout");
+
+class Timetable {
+public:
+  Timetable();
+
+  /**
+   * @brief Validates an image (magic, version, station, size, CRC) and
+   * uses it in place: data must outlive the Timetable.
+   * @return false if the image is missing, foreign or corrupt.
+   */
+  bool attach(const uint8_t *data, size_t size, const char *stationCode);
+
+  bool valid() const { return entries != nullptr; }
+  uint16_t count() const { return entryCount; }
+
+  /**
+   * @brief Fills snap.departures with the next departures from minute
+   * on, wrapping past midnight. Weather and station are left alone.
+   * @return Departures written.
+   */
+  uint8_t upcoming(uint16_t minute, Snapshot &snap) const;
+
+private:
+  const uint16_t *index;
+  const TimetableEntry *entries;
+  uint16_t entryCount;
+};
+
+/**
+ * @brief Builds an image from unsorted entries (the host packer).
+ * @return Image length, 0 if out is too small or an entry is invalid.
+ */
+size_t timetableBuild(const char *stationCode, TimetableEntry *entries,
+                      size_t count, uint8_t *out, size_t size);
+
+/**
+ * @brief Image size for count entries.
+ */
+size_t timetableImageSize(size_t count);
+
+#ifndef NATIVE_BUILD
+/**
+ * @brief The timetable partition, mapped once into the data cache.
+ * Invalid (count 0) if the partition is missing or not flashed.
+ */
+const Timetable &timetableFlash(const char *stationCode);
+#endif
+
+#endif
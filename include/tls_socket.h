@@ -0,0 +1,87 @@
+#ifndef TLS_SOCKET_H
+#define TLS_SOCKET_H
+
+#include <stdint.h>
+
+#include "lean_http.h"
+
+// =================================================================
+// TLS SOCKET
+// HttpSocket on mbedTLS directly (no WiFiClientSecure). The SSL
+// context and its record buffers are set up once and reused for every
+// connection, so a fetch no longer costs ~20 KB of transient heap.
+// The server key is checked against a pin on full handshakes only;
+// later connections resume the pinned session and skip the
+// certificate entirely.
+// =================================================================
+
+// Negozia l'estensione max_fragment_length (RFC 6066) con questo limite:
+// 512, 1024, 2048 o 4096 byte, 0 = disattivata. Ha senso solo insieme a
+// buffer mbedTLS più piccoli (env esp32dev_small_tls in platformio.ini)
+#ifndef TLS_MAX_FRAGMENT
+#define TLS_MAX_FRAGMENT 0
+#endif
+
+// SHA-256 della SubjectPublicKeyInfo del server, in base64 (il formato
+// "pin-sha256" di HPKP). Vuoto = certificato non verificato. Il pin di
+// riserva è la chiave del prossimo certificato, già generata ma non in uso:
+// il rinnovo del server non lascia le schede senza dati. Vedi secrets.h.
+#ifndef TLS_PIN_SHA256
+#define TLS_PIN_SHA256 ""
+#endif
+#ifndef TLS_PIN_SHA256_BACKUP
+#define TLS_PIN_SHA256_BACKUP ""
+#endif
+
+struct TlsStats {
+  uint32_t handshakes;
+  uint32_t resumed;       // Handshake abbreviati (sessione riusata)
+  uint32_t failures;
+  uint32_t pinFailures;   // Chiave del server diversa da entrambi i pin
+  uint32_t lastHandshakeMs;
+  uint32_t lastHandshakeCpuUs; // Tempo di calcolo: wall meno attesa di rete
+  uint32_t lastPinCheckUs;
+  bool lastResumed;
+  int lastError;          // Codice mbedTLS dell'ultimo errore, 0 = nessuno
+  uint32_t fragmentLimit; // Limite negoziato col server, 0 = nessuno
+};
+
+/**
+ * @brief The board's TLS socket. The first call allocates the mbedTLS
+ * buffers, so call it early (setup) while the heap is unfragmented.
+ */
+HttpSocket &tlsSocket();
+
+const TlsStats &tlsSocketStats();
+
+/**
+ * @brief Drops the cached session: the next connection does a full
+ * handshake (and pin check). Used by the benchmark.
+ */
+void tlsSocketForgetSession();
+
+/**
+ * @brief Runs a handshake one step at a time within timeoutMs of
+ * startMs (DNS and TCP connect included): each step gets the time
+ * still left as its read timeout, so a server sending every record
+ * just before a full read timeout cannot stretch the connect. Plain
+ * C++ for the host fault injection (fetch_faults).
+ * @param step Runs one step, waiting at most leftMs for data: 0 when
+ * the handshake is over, 1 to go on, or a negative error.
+ * @return 0, the step's error, or timeoutError when the time is up.
+ */
+inline int tlsHandshakeWithin(uint32_t startMs, uint32_t timeoutMs,
+                              uint32_t (*nowMs)(),
+                              int (*step)(void *arg, uint32_t leftMs),
+                              void *arg, int timeoutError) {
+  for (;;) {
+    uint32_t elapsed = nowMs() - startMs;
+    if (elapsed >= timeoutMs)
+      return timeoutError;
+    int ret = step(arg, timeoutMs - elapsed);
+    if (ret <= 0)
+      return ret;
+  }
+}
+
+#endif
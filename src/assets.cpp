@@ -0,0 +1,141 @@
+#include "assets.h"
+
+#include <string.h>
+
+#include "snapshot.h"
+
+static size_t align4(size_t n) { return (n + 3) & ~(size_t)3; }
+
+// =================================================================
+// AssetStore
+// =================================================================
+
+AssetStore::AssetStore() : base(nullptr), entries(nullptr), entryCount(0) {}
+
+bool AssetStore::attach(const uint8_t *data, size_t size) {
+  base = nullptr;
+  entries = nullptr;
+  entryCount = 0;
+  if (!data || size < sizeof(AssetsHeader))
+    return false;
+
+  const AssetsHeader *header = (const AssetsHeader *)data;
+  if (memcmp(header->magic, ASSETS_MAGIC, 4) != 0 ||
+      header->version != ASSETS_VERSION || header->count > ASSETS_MAX ||
+      header->size > size ||
+      header->size < sizeof(AssetsHeader) +
+                         header->count * sizeof(AssetEntry))
+    return false;
+  if (snapshotCrc32(data + sizeof(AssetsHeader),
+                    header->size - sizeof(AssetsHeader)) != header->crc)
+    return false;
+
+  // Ogni blob deve stare nell'immagine: dopo, find() non controlla più
+  const AssetEntry *dir = (const AssetEntry *)(data + sizeof(AssetsHeader));
+  for (uint16_t i = 0; i < header->count; i++) {
+    if (dir[i].offset > header->size ||
+        dir[i].size > header->size - dir[i].offset ||
+        memchr(dir[i].name, '\0', ASSET_NAME_MAX) == nullptr)
+      return false;
+  }
+
+  base = data;
+  entries = dir;
+  entryCount = header->count;
+  return true;
+}
+
+const uint8_t *AssetStore::find(const char *name, AssetType type,
+                                size_t *size) const {
+  for (uint16_t i = 0; i < entryCount; i++) {
+    if (entries[i].type != type || strcmp(entries[i].name, name) != 0)
+      continue;
+    if (size)
+      *size = entries[i].size;
+    return base + entries[i].offset;
+  }
+  return nullptr;
+}
+
+bool AssetStore::bitmap(const char *name, AssetBitmap &out) const {
+  size_t size;
+  const uint8_t *blob = find(name, ASSET_BITMAP, &size);
+  if (!blob || size < sizeof(AssetBitmapHeader))
+    return false;
+  const AssetBitmapHeader *header = (const AssetBitmapHeader *)blob;
+  size_t rowBytes = (header->width + 7) / 8;
+  if (size < sizeof(AssetBitmapHeader) + rowBytes * header->height)
+    return false;
+  out.width = header->width;
+  out.height = header->height;
+  out.bits = blob + sizeof(AssetBitmapHeader);
+  return true;
+}
+
+// =================================================================
+// AssetImageBuilder
+// =================================================================
+
+AssetImageBuilder::AssetImageBuilder() : pendingCount(0) {}
+
+bool AssetImageBuilder::add(const char *name, AssetType type,
+                            const uint8_t *data, size_t size) {
+  if (pendingCount == ASSETS_MAX || strlen(name) >= ASSET_NAME_MAX)
+    return false;
+  Pending &p = pending[pendingCount++];
+  memset(&p, 0, sizeof(p));
+  strcpy(p.entry.name, name);
+  p.entry.type = type;
+  p.entry.size = (uint32_t)size;
+  p.data = data;
+  return true;
+}
+
+bool AssetImageBuilder::addBitmap(const char *name, const uint8_t *bits,
+                                  uint16_t width, uint16_t height) {
+  size_t size = sizeof(AssetBitmapHeader) + (width + 7) / 8 * height;
+  if (!add(name, ASSET_BITMAP, bits, size))
+    return false;
+  pending[pendingCount - 1].bitmap = {width, height};
+  return true;
+}
+
+size_t AssetImageBuilder::imageSize() const {
+  size_t size = sizeof(AssetsHeader) + pendingCount * sizeof(AssetEntry);
+  for (uint16_t i = 0; i < pendingCount; i++)
+    size = align4(size) + pending[i].entry.size;
+  return align4(size);
+}
+
+size_t AssetImageBuilder::write(uint8_t *out, size_t size) const {
+  size_t length = imageSize();
+  if (size < length)
+    return 0;
+  memset(out, 0, length);
+
+  AssetEntry *dir = (AssetEntry *)(out + sizeof(AssetsHeader));
+  size_t pos = sizeof(AssetsHeader) + pendingCount * sizeof(AssetEntry);
+  for (uint16_t i = 0; i < pendingCount; i++) {
+    const Pending &p = pending[i];
+    pos = align4(pos);
+    dir[i] = p.entry;
+    dir[i].offset = (uint32_t)pos;
+    size_t dataSize = p.entry.size;
+    if (p.entry.type == ASSET_BITMAP) {
+      memcpy(out + pos, &p.bitmap, sizeof(p.bitmap));
+      pos += sizeof(p.bitmap);
+      dataSize -= sizeof(p.bitmap);
+    }
+    memcpy(out + pos, p.data, dataSize);
+    pos += dataSize;
+  }
+
+  AssetsHeader *header = (AssetsHeader *)out;
+  memcpy(header->magic, ASSETS_MAGIC, 4);
+  header->version = ASSETS_VERSION;
+  header->count = pendingCount;
+  header->size = (uint32_t)length;
+  header->crc = snapshotCrc32(out + sizeof(AssetsHeader),
+                              length - sizeof(AssetsHeader));
+  return length;
+}
@@ -0,0 +1,39 @@
+#include "assets.h"
+
+#include <esp_partition.h>
+
+#include "log.h"
+
+// Sottotipo "custom" della partizione, vedi partitions.csv
+#define ASSETS_PARTITION_SUBTYPE ((esp_partition_subtype_t)0x41)
+
+const AssetStore &assetsFlash() {
+  static AssetStore store;
+  static bool mapped = false;
+  if (mapped)
+    return store;
+  mapped = true; // Un solo tentativo: la partizione non cambia a runtime
+
+  const esp_partition_t *partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ASSETS_PARTITION_SUBTYPE, "assets");
+  if (!partition) {
+    LOG_W("Assets partition missing");
+    return store;
+  }
+
+  // Mappata nella cache dati: font e icone sono puntatori nella flash
+  const void *data = nullptr;
+  esp_partition_mmap_handle_t handle;
+  if (esp_partition_mmap(partition, 0, partition->size,
+                         ESP_PARTITION_MMAP_DATA, &data, &handle) != ESP_OK) {
+    LOG_W("Assets partition mmap failed");
+    return store;
+  }
+  if (!store.attach((const uint8_t *)data, partition->size)) {
+    LOG_W("Assets partition empty or corrupt");
+    esp_partition_munmap(handle);
+    return store;
+  }
+  LOG_I("Assets: %u entries", store.count());
+  return store;
+}
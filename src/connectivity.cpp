@@ -0,0 +1,161 @@
+#include "connectivity.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_netif.h>
+#include <esp_wifi.h>
+
+#include "log.h"
+#include "power.h"
+
+static const char *wifiSsid = NULL;
+static const char *wifiPassword = NULL;
+
+// Scritti dal task eventi WiFi, letti dal loop()
+static volatile ConnState connState = CONN_DOWN;
+static volatile uint32_t connGeneration = 0;
+static volatile bool reconnectDue = false;
+static volatile uint32_t downSinceMs = 0;
+
+static TimerHandle_t reconnectTimer = NULL;
+static uint32_t backoffMs = CONN_BACKOFF_MIN_MS;
+
+// Statistiche
+static uint32_t disconnectCount = 0;
+static uint32_t lastDisconnectReason = 0;
+static uint32_t downTotalMs = 0;
+
+static void setState(ConnState state) {
+  if (state == connState)
+    return;
+
+  uint32_t now = millis();
+  if (state == CONN_UP) {
+    downTotalMs += now - downSinceMs;
+    connGeneration = connGeneration + 1;
+  } else if (connState == CONN_UP) {
+    downSinceMs = now;
+  }
+  connState = state;
+  powerWake(); // Aggiorna subito indicatore e scheduler dei fetch
+}
+
+// Gira nel task dei timer (stack piccolo): WiFi.begin() lo fa il loop()
+static void reconnectTimerCallback(TimerHandle_t) { reconnectDue = true; }
+
+/**
+ * @brief Forces the DNS servers on the STA interface. Unlike
+ * WiFi.config() it leaves the DHCP client alone; a new lease may bring
+ * the router's servers back, so it runs on every GOT_IP.
+ */
+static void forceDnsServers() {
+  esp_netif_t *sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  if (!sta)
+    return;
+  esp_netif_dns_info_t dns = {};
+  dns.ip.type = ESP_IPADDR_TYPE_V4;
+  dns.ip.u_addr.ip4.addr = ESP_IP4TOADDR(8, 8, 8, 8);
+  esp_netif_set_dns_info(sta, ESP_NETIF_DNS_MAIN, &dns);
+  dns.ip.u_addr.ip4.addr = ESP_IP4TOADDR(1, 1, 1, 1);
+  esp_netif_set_dns_info(sta, ESP_NETIF_DNS_BACKUP, &dns);
+}
+
+/**
+ * @brief Schedules the next reconnect attempt, doubling the delay each
+ * time up to CONN_BACKOFF_MAX_MS.
+ */
+static void scheduleReconnect() {
+  xTimerChangePeriod(reconnectTimer, pdMS_TO_TICKS(backoffMs), 0);
+  xTimerStart(reconnectTimer, 0);
+  backoffMs = backoffMs * 2 > CONN_BACKOFF_MAX_MS ? CONN_BACKOFF_MAX_MS
+                                                  : backoffMs * 2;
+}
+
+static void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+  case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+    setState(CONN_CONNECTING); // Associati, in attesa del DHCP
+    break;
+
+  case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+    LOG_I("WiFi up, IP: %s, RSSI: %d dBm", WiFi.localIP().toString().c_str(),
+          WiFi.RSSI());
+    backoffMs = CONN_BACKOFF_MIN_MS;
+    xTimerStop(reconnectTimer, 0);
+    reconnectDue = false;
+    forceDnsServers();
+    setState(CONN_UP);
+    break;
+
+  case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+    LOG_W("WiFi lost IP");
+    setState(CONN_CONNECTING);
+    break;
+
+  case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    disconnectCount++;
+    lastDisconnectReason = info.wifi_sta_disconnected.reason;
+    LOG_W("WiFi disconnected (reason %u)",
+          (unsigned)info.wifi_sta_disconnected.reason);
+    setState(CONN_DOWN);
+    scheduleReconnect();
+    break;
+
+  default:
+    break;
+  }
+}
+
+void connectivityBegin(const char *ssid, const char *password,
+                       const char *hostname) {
+  wifiSsid = ssid;
+  wifiPassword = password;
+  downSinceMs = millis();
+
+  reconnectTimer = xTimerCreate("wifi_reconnect",
+                                pdMS_TO_TICKS(CONN_BACKOFF_MIN_MS), pdFALSE,
+                                NULL, reconnectTimerCallback);
+
+  WiFi.onEvent(onWiFiEvent);
+  WiFi.mode(WIFI_STA);
+  WiFi.setHostname(hostname);
+  WiFi.setAutoReconnect(false); // Le riconnessioni le gestiamo noi
+
+  // Power management aggressivo per stabilità
+  esp_wifi_set_ps(WIFI_PS_NONE); // Disabilita power saving
+
+  setState(CONN_CONNECTING);
+  WiFi.begin(wifiSsid, wifiPassword);
+  LOG_I("WiFi connecting to %s", ssid);
+}
+
+void connectivityPoll() {
+  if (reconnectDue) {
+    reconnectDue = false;
+    if (connState == CONN_DOWN) {
+      LOG_I("WiFi reconnecting (backoff %lu ms)", (unsigned long)backoffMs);
+      setState(CONN_CONNECTING);
+      WiFi.begin(wifiSsid, wifiPassword);
+    }
+  }
+
+  if (connState != CONN_UP && millis() - downSinceMs > CONN_RESTART_AFTER_MS) {
+    LOG_E("No WiFi for %lu min, restarting...",
+          (unsigned long)(CONN_RESTART_AFTER_MS / 60000));
+    logFlush();
+    ESP.restart();
+  }
+}
+
+ConnState connectivityState() { return connState; }
+
+uint32_t connectivityGeneration() { return connGeneration; }
+
+void connectivityDumpStats() {
+  uint32_t down = downTotalMs;
+  if (connState != CONN_UP)
+    down += millis() - downSinceMs;
+  LOG_I("wifi state %d, disconnects %lu (last reason %lu), downtime %lu s",
+        (int)connState, (unsigned long)disconnectCount,
+        (unsigned long)lastDisconnectReason, (unsigned long)(down / 1000));
+}
@@ -0,0 +1,151 @@
+#include "data_feed.h"
+
+#include <string.h>
+
+void snapshotCopyParts(Snapshot &dst, const Snapshot &src, uint8_t fields) {
+  if (fields & SNAPSHOT_DEPARTURES) {
+    dst.count = src.count;
+    memcpy(dst.departures, src.departures, sizeof(dst.departures));
+  }
+  if (fields & SNAPSHOT_WEATHER)
+    memcpy(dst.weather, src.weather, sizeof(dst.weather));
+  if (fields & SNAPSHOT_STATION)
+    memcpy(dst.stationName, src.stationName, sizeof(dst.stationName));
+}
+
+// =================================================================
+// DataFeed
+// =================================================================
+
+DataFeed::DataFeed(const char *name, DataProvider &provider, uint8_t field,
+                   uint32_t ttlMs, uint32_t jitterMs)
+    : label(name), source(provider), part(field),
+      once(ttlMs == DATA_FEED_ONCE), valid(false),
+      scheduler(once ? DATA_FEED_ONCE_RETRY_MS : ttlMs, jitterMs),
+      lastOkMs(0), okCount(0), failCount(0) {
+  memset(&cache, 0, sizeof(cache));
+}
+
+void DataFeed::begin(uint32_t nowMs, uint64_t deviceId, uint32_t seed) {
+  scheduler.begin(nowMs, deviceId, seed);
+}
+
+void DataFeed::onSuccess(uint32_t nowMs, const FetchHints &hints,
+                         const Snapshot &snap) {
+  // Un nome vuoto vuol dire che la sorgente non l'ha mandato
+  if (part == SNAPSHOT_STATION && !snap.stationName[0]) {
+    onFailure(nowMs, hints);
+    return;
+  }
+  snapshotCopyParts(cache, snap, part);
+  valid = true;
+  lastOkMs = nowMs;
+  okCount++;
+  scheduler.onSuccess(nowMs, hints);
+}
+
+void DataFeed::onFailure(uint32_t nowMs, const FetchHints &hints) {
+  failCount++;
+  scheduler.onFailure(nowMs, hints);
+}
+
+// =================================================================
+// DataFeeds
+// =================================================================
+
+DataFeeds::DataFeeds()
+    : count(0), last(nullptr), requestCount(0), byteCount(0) {}
+
+bool DataFeeds::add(DataFeed &feed) {
+  if (count == DATA_FEED_MAX)
+    return false;
+  feeds[count++] = &feed;
+  return true;
+}
+
+void DataFeeds::begin(uint32_t nowMs, uint64_t deviceId, uint32_t seed) {
+  for (size_t i = 0; i < count; i++)
+    feeds[i]->begin(nowMs, deviceId, seed + (uint32_t)i);
+}
+
+bool DataFeeds::due(uint32_t nowMs, uint8_t only) const {
+  for (size_t i = 0; i < count; i++)
+    if ((feeds[i]->part & only) && feeds[i]->due(nowMs))
+      return true;
+  return false;
+}
+
+uint32_t DataFeeds::nextFetchMs(uint32_t nowMs, uint8_t only) const {
+  uint32_t next = nowMs + DATA_FEED_ONCE_RETRY_MS;
+  for (size_t i = 0; i < count; i++) {
+    const DataFeed &f = *feeds[i];
+    if (!(f.part & only) || (f.once && f.valid))
+      continue;
+    if ((int32_t)(f.nextFetchMs() - next) < 0)
+      next = f.nextFetchMs();
+  }
+  return next;
+}
+
+FetchResult DataFeeds::fetch(uint32_t nowMs, Snapshot &snap,
+                             uint8_t &refreshed, int64_t (*monoUs)(),
+                             void (*tap)(const uint8_t *, size_t),
+                             uint8_t only) {
+  refreshed = 0;
+  FetchResult r;
+  memset(&r, 0, sizeof(r));
+  r.status = FETCH_OK;
+
+  // Il più in ritardo decide il provider
+  DataFeed *lead = nullptr;
+  for (size_t i = 0; i < count; i++) {
+    DataFeed *f = feeds[i];
+    if ((f->part & only) && f->due(nowMs) &&
+        (!lead || (int32_t)(f->nextFetchMs() - lead->nextFetchMs()) < 0))
+      lead = f;
+  }
+  if (!lead)
+    return r;
+
+  bool joined[DATA_FEED_MAX] = {};
+  uint8_t fields = 0;
+  for (size_t i = 0; i < count; i++) {
+    DataFeed *f = feeds[i];
+    if (!(f->part & only) || &f->source != &lead->source ||
+        (f->once && f->valid))
+      continue;
+    uint32_t horizon = nowMs + DATA_FEED_COALESCE_MS;
+    if ((int32_t)(f->nextFetchMs() - horizon) <= 0) {
+      joined[i] = true;
+      fields |= f->part;
+    }
+  }
+
+  last = &lead->source;
+  r = lead->source.fetch(snap, fields & lead->source.fields(), monoUs, tap);
+  if (r.code != 0) { // 0: il provider ha risposto senza rete
+    requestCount++;
+    byteCount += r.bodyBytes;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (!joined[i])
+      continue;
+    DataFeed *f = feeds[i];
+    if (r.status == FETCH_OK) {
+      uint32_t before = f->okCount;
+      f->onSuccess(nowMs, r.hints, snap);
+      if (f->okCount != before)
+        refreshed |= f->part;
+    } else {
+      f->onFailure(nowMs, r.hints);
+    }
+  }
+  return r;
+}
+
+void DataFeeds::merge(Snapshot &snap) const {
+  memset(&snap, 0, sizeof(snap));
+  for (size_t i = 0; i < count; i++)
+    if (feeds[i]->valid)
+      snapshotCopyParts(snap, feeds[i]->cache, feeds[i]->part);
+}
@@ -0,0 +1,90 @@
+#include "data_provider.h"
+
+#include <string.h>
+
+#include "departures_parser.h"
+
+// =================================================================
+// JsonApiProvider
+// =================================================================
+
+JsonApiProvider::JsonApiProvider(HttpTransport &transport, const char *url,
+                                 const char *metaUrl)
+    : transport(transport), url(url), metaUrl(metaUrl ? metaUrl : url),
+      wanted(SNAPSHOT_ALL), target(nullptr) {}
+
+bool JsonApiProvider::parse(BodyReader &body, void *context) {
+  JsonApiProvider &self = *(JsonApiProvider *)context;
+  DeparturesParser parser(*self.target, self.wanted);
+  const char *chunk;
+  size_t n;
+  while (!parser.done() && !parser.failed() &&
+         (n = body.readChunk(chunk)) > 0)
+    parser.feed(chunk, n);
+  return parser.done();
+}
+
+FetchResult JsonApiProvider::fetch(Snapshot &snap, uint8_t fields,
+                                   int64_t (*monoUs)(),
+                                   void (*tap)(const uint8_t *, size_t)) {
+  memset(&snap, 0, sizeof(snap));
+  wanted = fields;
+  target = &snap;
+  const char *u = fields & SNAPSHOT_DEPARTURES ? url : metaUrl;
+  FetchResult r = httpFetch(transport, u, parse, this, monoUs, tap);
+  target = nullptr;
+  return r;
+}
+
+bool JsonApiProvider::prewarm(uint8_t fields, uint32_t timeoutMs) {
+  return transport.prewarm(fields & SNAPSHOT_DEPARTURES ? url : metaUrl,
+                           timeoutMs);
+}
+
+// =================================================================
+// GtfsRtProvider
+// =================================================================
+
+GtfsRtProvider::GtfsRtProvider(HttpTransport &transport, const char *url,
+                               const char *stopId, const char *stationName,
+                               int64_t (*utcUs)())
+    : transport(transport), url(url), stopId(stopId),
+      stationName(stationName), utcUs(utcUs), target(nullptr) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool GtfsRtProvider::parse(BodyReader &body, void *context) {
+  GtfsRtProvider &self = *(GtfsRtProvider *)context;
+  int64_t nowUtc = self.utcUs ? self.utcUs() / 1000000 : 0;
+  GtfsRtDecoder decoder(*self.target, self.stopId, nowUtc);
+  const char *chunk;
+  size_t n;
+  while (!decoder.failed() && (n = body.readChunk(chunk)) > 0)
+    decoder.feed((const uint8_t *)chunk, n);
+  self.stats = decoder.stats();
+  return decoder.finish();
+}
+
+FetchResult GtfsRtProvider::fetch(Snapshot &snap, uint8_t fields,
+                                  int64_t (*monoUs)(),
+                                  void (*tap)(const uint8_t *, size_t)) {
+  memset(&snap, 0, sizeof(snap));
+  FetchResult r;
+  memset(&r, 0, sizeof(r));
+  r.status = FETCH_OK; // Solo il nome: nessuna richiesta
+  if (fields & SNAPSHOT_DEPARTURES) {
+    memset(&stats, 0, sizeof(stats));
+    target = &snap;
+    r = httpFetch(transport, url, parse, this, monoUs, tap);
+    target = nullptr;
+  }
+  if (fields & SNAPSHOT_STATION)
+    snapshotCopyField(snap.stationName, sizeof(snap.stationName),
+                      stationName);
+  return r;
+}
+
+bool GtfsRtProvider::prewarm(uint8_t fields, uint32_t timeoutMs) {
+  // Il nome della stazione non passa dalla rete
+  return (fields & SNAPSHOT_DEPARTURES) && transport.prewarm(url, timeoutMs);
+}
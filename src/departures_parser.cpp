@@ -0,0 +1,476 @@
+#include "departures_parser.h"
+
+#include <string.h>
+
+// =================================================================
+// KEY HASH
+// FNV-1a, calcolato byte per byte mentre la chiave arriva. Il seme
+// che manda le chiavi note in slot tutti diversi della tabella viene
+// cercato dal compilatore: a runtime un lookup è una moltiplicazione,
+// un accesso alla tabella e un memcmp di conferma.
+// =================================================================
+
+namespace {
+
+enum Key : int8_t {
+  KEY_NONE = -1,
+  KEY_STATION_NAME,
+  KEY_WEATHER,
+  KEY_TEMPERATURE,
+  KEY_DESCRIPTION,
+  KEY_DEPARTURES,
+  KEY_TYPE,
+  KEY_DESTINATION,
+  KEY_DEPARTURE_TIME,
+  KEY_DELAY,
+  KEY_COUNT
+};
+
+// Stesso ordine di Key
+constexpr const char *KEYS[KEY_COUNT] = {
+    "stationName", "weather",     "temperature",   "description", "departures",
+    "type",        "destination", "departureTime", "delay"};
+
+constexpr uint32_t FNV_BASIS = 2166136261u;
+constexpr uint32_t FNV_PRIME = 16777619u;
+constexpr int SLOT_BITS = 4;
+constexpr int SLOTS = 1 << SLOT_BITS;
+constexpr uint32_t NO_SEED = 0xffffffffu;
+
+constexpr uint32_t hashStep(uint32_t hash, char c) {
+  return (hash ^ (uint8_t)c) * FNV_PRIME;
+}
+
+constexpr uint32_t hashOf(const char *s) {
+  uint32_t hash = FNV_BASIS;
+  while (*s)
+    hash = hashStep(hash, *s++);
+  return hash;
+}
+
+constexpr size_t lengthOf(const char *s) {
+  size_t n = 0;
+  while (s[n])
+    n++;
+  return n;
+}
+
+constexpr int slotOf(uint32_t hash, uint32_t seed) {
+  return (int)(((hash ^ seed) * 0x9e3779b1u) >> (32 - SLOT_BITS));
+}
+
+constexpr uint32_t findSeed() {
+  for (uint32_t seed = 0; seed < 100000; seed++) {
+    bool used[SLOTS] = {};
+    bool ok = true;
+    for (int k = 0; k < KEY_COUNT && ok; k++) {
+      int slot = slotOf(hashOf(KEYS[k]), seed);
+      ok = !used[slot];
+      used[slot] = true;
+    }
+    if (ok)
+      return seed;
+  }
+  return NO_SEED;
+}
+
+constexpr uint32_t SEED = findSeed();
+static_assert(SEED != NO_SEED, "no perfect hash for the departures keys");
+
+struct SlotTable {
+  int8_t key[SLOTS];
+  uint8_t length[KEY_COUNT];
+};
+
+constexpr SlotTable makeTable() {
+  SlotTable table = {};
+  for (int s = 0; s < SLOTS; s++)
+    table.key[s] = KEY_NONE;
+  for (int k = 0; k < KEY_COUNT; k++) {
+    table.key[slotOf(hashOf(KEYS[k]), SEED)] = (int8_t)k;
+    table.length[k] = (uint8_t)lengthOf(KEYS[k]);
+  }
+  return table;
+}
+
+constexpr SlotTable TABLE = makeTable();
+
+static_assert(lengthOf("departureTime") == DEPARTURES_PARSER_KEY_MAX,
+              "DEPARTURES_PARSER_KEY_MAX is the longest key");
+
+Key lookup(uint32_t hash, const char *text, uint8_t length) {
+  int8_t k = TABLE.key[slotOf(hash, SEED)];
+  if (k == KEY_NONE || TABLE.length[k] != length ||
+      memcmp(KEYS[k], text, length) != 0)
+    return KEY_NONE;
+  return (Key)k;
+}
+
+inline bool isSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isLiteral(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' ||
+         c == '+' || c == '.' || c == 'E';
+}
+
+inline int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+} // namespace
+
+// =================================================================
+// DeparturesParser
+// =================================================================
+
+DeparturesParser::DeparturesParser(Snapshot &snap, uint8_t fields)
+    : snap(snap), fields(fields), state(EXPECT_VALUE), inKey(false),
+      depth(0), arrays(0), key(KEY_NONE), keyLength(0), keyHash(FNV_BASIS),
+      train(nullptr), out(nullptr), room(0), length(0), literalStart(0),
+      unicode(0), unicodeDigits(0), highSurrogate(0), stationSeen(false),
+      weatherSeen(false) {
+  memset(&snap, 0, sizeof(snap));
+  temperature[0] = description[0] = '\0';
+}
+
+size_t DeparturesParser::feed(const char *data, size_t size) {
+  size_t i = 0;
+  while (i < size && state != DONE && state != FAILED) {
+    if (!step(data[i++]))
+      state = FAILED;
+  }
+  return i;
+}
+
+bool DeparturesParser::step(char c) {
+  switch (state) {
+  case IN_STRING:
+    if (c == '"') {
+      out = nullptr;
+      state = EXPECT_COMMA_OR_END;
+    } else if (c == '\\') {
+      state = IN_ESCAPE;
+    } else if ((uint8_t)c < 0x20) {
+      return false;
+    } else {
+      put(c);
+    }
+    return true;
+
+  case IN_KEY:
+    if (c == '"') {
+      endKey();
+      state = EXPECT_COLON;
+    } else if (c == '\\') {
+      keyLength = DEPARTURES_PARSER_KEY_MAX + 1; // Nessuna chiave nota
+      state = IN_ESCAPE;
+    } else if ((uint8_t)c < 0x20) {
+      return false;
+    } else {
+      if (keyLength < DEPARTURES_PARSER_KEY_MAX)
+        keyText[keyLength] = c;
+      if (keyLength <= DEPARTURES_PARSER_KEY_MAX)
+        keyLength++;
+      keyHash = hashStep(keyHash, c);
+    }
+    return true;
+
+  case IN_ESCAPE: {
+    static const char FROM[] = "\"\\/bfnrt";
+    static const char TO[] = "\"\\/\b\f\n\r\t";
+    state = inKey ? IN_KEY : IN_STRING;
+    if (c == 'u') {
+      unicode = 0;
+      unicodeDigits = 0;
+      state = IN_UNICODE;
+      return true;
+    }
+    const char *p = strchr(FROM, c);
+    if (!c || !p)
+      return false;
+    if (!inKey)
+      put(TO[p - FROM]);
+    return true;
+  }
+
+  case IN_UNICODE: {
+    int v = hexValue(c);
+    if (v < 0)
+      return false;
+    unicode = unicode << 4 | v;
+    if (++unicodeDigits < 4)
+      return true;
+    state = inKey ? IN_KEY : IN_STRING;
+    if (!inKey)
+      putCodePoint(unicode);
+    return true;
+  }
+
+  case IN_LITERAL:
+    if (isLiteral(c)) {
+      put(c);
+      return true;
+    }
+    endLiteral();
+    state = EXPECT_COMMA_OR_END;
+    break; // c chiude il letterale: va riletto come separatore
+
+  case DONE:
+  case FAILED:
+    return false;
+
+  default:
+    break;
+  }
+
+  if (isSpace(c))
+    return true;
+
+  switch (state) {
+  case EXPECT_VALUE_OR_END:
+    if (c == ']')
+      return close(true);
+    return beginValue(c);
+  case EXPECT_VALUE:
+    return beginValue(c);
+  case EXPECT_KEY_OR_END:
+    if (c == '}')
+      return close(false);
+    // fallthrough
+  case EXPECT_KEY:
+    if (c != '"')
+      return false;
+    inKey = true;
+    keyLength = 0;
+    keyHash = FNV_BASIS;
+    state = IN_KEY;
+    return true;
+  case EXPECT_COLON:
+    if (c != ':')
+      return false;
+    state = EXPECT_VALUE;
+    return true;
+  case EXPECT_COMMA_OR_END:
+    if (c == ',') {
+      state = arrays >> (depth - 1) & 1 ? EXPECT_VALUE : EXPECT_KEY;
+      return true;
+    }
+    if (c == '}' || c == ']')
+      return close(c == ']');
+    return false;
+  default:
+    return false;
+  }
+}
+
+bool DeparturesParser::beginValue(char c) {
+  if (depth == 0 && c != '{')
+    return false; // Solo un oggetto alla radice
+  if (c == '{' || c == '[')
+    return open(c == '[');
+  inKey = false;
+  beginField();
+  if (c == '"') {
+    state = IN_STRING;
+    return true;
+  }
+  if (!isLiteral(c))
+    return false;
+  literalStart = length;
+  put(c);
+  state = IN_LITERAL;
+  return true;
+}
+
+bool DeparturesParser::open(bool array) {
+  if (depth == DEPARTURES_PARSER_DEPTH)
+    return false;
+  Scope parent = depth == 0 ? SCOPE_ROOT
+                 : depth <= 4 ? scopes[depth - 1]
+                              : SCOPE_SKIP;
+  Scope scope = SCOPE_SKIP;
+  if (depth == 0) {
+    scope = SCOPE_ROOT;
+  } else if (parent == SCOPE_ROOT && key == KEY_WEATHER && !array &&
+             (fields & SNAPSHOT_WEATHER)) {
+    scope = SCOPE_WEATHER;
+    weatherSeen = true;
+    temperature[0] = description[0] = '\0';
+  } else if (parent == SCOPE_ROOT && key == KEY_DEPARTURES && array &&
+             (fields & SNAPSHOT_DEPARTURES)) {
+    scope = SCOPE_DEPARTURES;
+    snap.count = 0;
+  } else if (parent == SCOPE_DEPARTURES && !array &&
+             snap.count < SNAPSHOT_MAX_DEPARTURES) {
+    scope = SCOPE_TRAIN;
+    train = &snap.departures[snap.count++];
+    memset(train, 0, sizeof(*train));
+  }
+  if (depth < 4)
+    scopes[depth] = scope;
+  if (array)
+    arrays |= 1u << depth;
+  else
+    arrays &= ~(1u << depth);
+  depth++;
+  state = array ? EXPECT_VALUE_OR_END : EXPECT_KEY_OR_END;
+  return true;
+}
+
+bool DeparturesParser::close(bool array) {
+  if (depth == 0 || (bool)(arrays >> (depth - 1) & 1) != array)
+    return false;
+  depth--;
+  if (depth == 0) {
+    finish();
+    state = DONE;
+  } else {
+    state = EXPECT_COMMA_OR_END;
+  }
+  return true;
+}
+
+void DeparturesParser::endKey() {
+  key = keyLength <= DEPARTURES_PARSER_KEY_MAX
+            ? lookup(keyHash, keyText, keyLength)
+            : KEY_NONE;
+}
+
+// Il campo di destinazione del valore, scelto da livello e chiave
+void DeparturesParser::beginField() {
+  Scope scope = depth <= 4 ? scopes[depth - 1] : SCOPE_SKIP;
+  out = nullptr;
+  length = 0;
+  highSurrogate = 0;
+  if (arrays >> (depth - 1) & 1)
+    return; // Elementi di un array: nessuna chiave
+  switch (scope) {
+  case SCOPE_ROOT:
+    if (key == KEY_STATION_NAME && (fields & SNAPSHOT_STATION)) {
+      out = snap.stationName;
+      room = sizeof(snap.stationName);
+      stationSeen = true;
+    }
+    break;
+  case SCOPE_WEATHER:
+    if (key == KEY_TEMPERATURE) {
+      out = temperature;
+      room = sizeof(temperature);
+    } else if (key == KEY_DESCRIPTION) {
+      out = description;
+      room = sizeof(description);
+    }
+    break;
+  case SCOPE_TRAIN:
+    switch (key) {
+    case KEY_TYPE:
+      out = train->type;
+      room = sizeof(train->type);
+      break;
+    case KEY_DESTINATION:
+      out = train->destination;
+      room = sizeof(train->destination);
+      break;
+    case KEY_DEPARTURE_TIME:
+      out = train->departureTime;
+      room = sizeof(train->departureTime);
+      break;
+    case KEY_DELAY:
+      out = train->delay;
+      room = sizeof(train->delay);
+      break;
+    default:
+      break;
+    }
+    break;
+  default:
+    break;
+  }
+  if (out) {
+    out[0] = '\0';
+    if (scope == SCOPE_TRAIN && key == KEY_DESTINATION) {
+      put('-'); // Come "-> " + destination in fetchData()
+      put('>');
+      put(' ');
+    }
+  }
+}
+
+// null non scrive niente; numeri e booleani restano come nel testo.
+// stationName vuole una stringa, altrimenti resta il nome precedente
+void DeparturesParser::endLiteral() {
+  if (out == snap.stationName) {
+    stationSeen = false; // Come un nome assente
+    snap.stationName[0] = '\0';
+  } else if (out && length - literalStart == 4 &&
+             memcmp(out + literalStart, "null", 4) == 0) {
+    length = literalStart;
+    out[length] = '\0';
+  }
+  out = nullptr;
+}
+
+void DeparturesParser::put(char c) {
+  if (out && length + 1 < room) {
+    out[length++] = c;
+    out[length] = '\0';
+  }
+}
+
+// \uXXXX in UTF-8, coppie di surrogati comprese
+void DeparturesParser::putCodePoint(uint32_t cp) {
+  if (cp >= 0xd800 && cp < 0xdc00) {
+    highSurrogate = (uint16_t)cp;
+    return;
+  }
+  if (cp >= 0xdc00 && cp < 0xe000) {
+    if (!highSurrogate)
+      return;
+    cp = 0x10000 + ((uint32_t)(highSurrogate - 0xd800) << 10) +
+         (cp - 0xdc00);
+  }
+  highSurrogate = 0;
+  if (cp < 0x80) {
+    put((char)cp);
+  } else if (cp < 0x800) {
+    put((char)(0xc0 | cp >> 6));
+    put((char)(0x80 | (cp & 0x3f)));
+  } else if (cp < 0x10000) {
+    put((char)(0xe0 | cp >> 12));
+    put((char)(0x80 | (cp >> 6 & 0x3f)));
+    put((char)(0x80 | (cp & 0x3f)));
+  } else {
+    put((char)(0xf0 | cp >> 18));
+    put((char)(0x80 | (cp >> 12 & 0x3f)));
+    put((char)(0x80 | (cp >> 6 & 0x3f)));
+    put((char)(0x80 | (cp & 0x3f)));
+  }
+}
+
+// "<temperatura> - <descrizione>", con ^ al posto del simbolo di grado
+void DeparturesParser::finish() {
+  if (!weatherSeen)
+    return;
+  for (char *p = temperature; *p; p++)
+    if (*p == '^')
+      *p = '\xf8'; // SystemFont5x7 ha il simbolo di grado
+  out = snap.weather;
+  room = sizeof(snap.weather);
+  length = 0;
+  for (const char *p = temperature; *p; p++)
+    put(*p);
+  put(' ');
+  put('-');
+  put(' ');
+  for (const char *p = description; *p; p++)
+    put(*p);
+  out = nullptr;
+}
@@ -0,0 +1,148 @@
+#include "disciplined_clock.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+DisciplinedClock::DisciplinedClock()
+    : isSynced(false), baseMono(0), baseUtc(0), rateBillionths(0),
+      slewStart(0), slewDuration(1), slewTotal(0), sampleCount(0),
+      sampleNext(0), steps(0), syncs(0) {}
+
+int64_t DisciplinedClock::pendingSlewUs(int64_t monoUs) const {
+  int64_t elapsed = monoUs - slewStart;
+  if (elapsed <= 0)
+    return slewTotal;
+  if (elapsed >= slewDuration)
+    return 0;
+  return slewTotal - slewTotal * elapsed / slewDuration;
+}
+
+int64_t DisciplinedClock::utcAt(int64_t monoUs) const {
+  int64_t dx = monoUs - baseMono;
+  return baseUtc + dx + dx * rateBillionths / 1000000000LL + slewTotal -
+         pendingSlewUs(monoUs);
+}
+
+/**
+ * @brief Moves the base point to monoUs, folding in the part of the slew
+ * already applied, so the rate or slew can change without a jump.
+ */
+void DisciplinedClock::rebase(int64_t monoUs) {
+  int64_t remaining = pendingSlewUs(monoUs);
+  baseUtc = utcAt(monoUs);
+  baseMono = monoUs;
+  // La parte di slew non ancora applicata riparte da qui
+  slewTotal = remaining;
+  slewStart = monoUs;
+  slewDuration = llabs(remaining) * 1000000LL / CLOCK_SLEW_MAX_PPM + 1;
+}
+
+/**
+ * @brief Weighted least-squares slope of (utc - mono) against mono over
+ * the sync history. Measurements are raw reference times, independent
+ * of our own corrections, so the slope is the crystal's frequency
+ * error. Each sample weighs 1/variance, its window taken as a uniform
+ * error (variance u^2 / 3); the slope is kept only if its standard
+ * error, widened by residuals larger than the windows explain, is
+ * below CLOCK_DRIFT_MAX_ERROR_PPB.
+ */
+void DisciplinedClock::estimateDrift() {
+  if (sampleCount < 3)
+    return;
+
+  int first = (sampleNext + CLOCK_SAMPLE_COUNT - sampleCount) %
+              CLOCK_SAMPLE_COUNT;
+  double x[CLOCK_SAMPLE_COUNT], y[CLOCK_SAMPLE_COUNT], w[CLOCK_SAMPLE_COUNT];
+  double sw = 0, meanX = 0, meanY = 0;
+  for (int i = 0; i < sampleCount; i++) {
+    int k = (first + i) % CLOCK_SAMPLE_COUNT;
+    x[i] = (double)(sampleMono[k] - sampleMono[first]);
+    y[i] = (double)((sampleUtc[k] - sampleMono[k]) -
+                    (sampleUtc[first] - sampleMono[first]));
+    double u = (double)(sampleUncertainty[k] > 1000 ? sampleUncertainty[k]
+                                                    : 1000);
+    w[i] = 3.0 / (u * u);
+    sw += w[i];
+    meanX += w[i] * x[i];
+    meanY += w[i] * y[i];
+  }
+  meanX /= sw;
+  meanY /= sw;
+
+  double sxy = 0, sxx = 0;
+  for (int i = 0; i < sampleCount; i++) {
+    sxy += w[i] * (x[i] - meanX) * (y[i] - meanY);
+    sxx += w[i] * (x[i] - meanX) * (x[i] - meanX);
+  }
+  if (sxx <= 0)
+    return;
+  double slope = sxy / sxx;
+
+  // Residui oltre le finestre dichiarate: l'errore cresce di conseguenza
+  double chi2 = 0;
+  for (int i = 0; i < sampleCount; i++) {
+    double r = y[i] - meanY - slope * (x[i] - meanX);
+    chi2 += w[i] * r * r;
+  }
+  double scale = chi2 / (sampleCount - 2);
+  double errorPpb = sqrt((scale > 1 ? scale : 1) / sxx) * 1e9;
+  if (errorPpb > CLOCK_DRIFT_MAX_ERROR_PPB)
+    return; // Misure non ancora sufficienti, tieni la stima precedente
+
+  double ppb = slope * 1e9;
+  if (ppb > CLOCK_DRIFT_MAX_PPB)
+    ppb = CLOCK_DRIFT_MAX_PPB;
+  else if (ppb < -CLOCK_DRIFT_MAX_PPB)
+    ppb = -CLOCK_DRIFT_MAX_PPB;
+  rateBillionths = (int32_t)ppb;
+}
+
+void DisciplinedClock::sync(int64_t monoUs, int64_t utcUs,
+                            int64_t uncertaintyUs, int64_t stepThresholdUs) {
+  syncs++;
+
+  if (!isSynced || llabs(utcUs - utcAt(monoUs)) > stepThresholdUs) {
+    // Primo sync o errore troppo grande: salto netto, e la cronologia
+    // non è più confrontabile
+    baseMono = monoUs;
+    baseUtc = utcUs;
+    slewTotal = 0;
+    slewStart = monoUs;
+    slewDuration = 1;
+    sampleCount = 0;
+    sampleNext = 0;
+    if (isSynced)
+      steps++;
+    isSynced = true;
+  }
+
+  // Una misura ogni CLOCK_SAMPLE_MIN_GAP_US: nel frattempo l'ultima
+  // viene sostituita da una più precisa
+  int last = (sampleNext + CLOCK_SAMPLE_COUNT - 1) % CLOCK_SAMPLE_COUNT;
+  if (sampleCount == 0 ||
+      monoUs - sampleMono[last] >= CLOCK_SAMPLE_MIN_GAP_US) {
+    sampleMono[sampleNext] = monoUs;
+    sampleUtc[sampleNext] = utcUs;
+    sampleUncertainty[sampleNext] = uncertaintyUs;
+    sampleNext = (sampleNext + 1) % CLOCK_SAMPLE_COUNT;
+    if (sampleCount < CLOCK_SAMPLE_COUNT)
+      sampleCount++;
+  } else if (uncertaintyUs < sampleUncertainty[last]) {
+    sampleMono[last] = monoUs;
+    sampleUtc[last] = utcUs;
+    sampleUncertainty[last] = uncertaintyUs;
+  }
+
+  // Nuova stima di frequenza applicata da qui in avanti, senza salti
+  rebase(monoUs);
+  estimateDrift();
+
+  // Correzione di fase: solo se siamo fuori dalla finestra di incertezza,
+  // e sempre in slew così i secondi non saltano né si ripetono
+  // (l'offset è misurato rispetto a dove arriverà lo slew in corso)
+  int64_t offset = utcUs - (utcAt(monoUs) + slewTotal);
+  if (llabs(offset) > uncertaintyUs) {
+    slewTotal += offset;
+    slewDuration = llabs(slewTotal) * 1000000LL / CLOCK_SLEW_MAX_PPM + 1;
+  }
+}
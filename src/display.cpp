@@ -0,0 +1,147 @@
+#include "display.h"
+
+#include <string.h>
+
+// Sorgenti di writePixel() registrato: devono vivere fino al render
+static const uint32_t PIXEL_ON = 0x80000000u;
+static const uint32_t PIXEL_OFF = 0;
+
+Display::Display(Framebuffer &fb, TileRenderer *tiles)
+    : fb(fb), tiles(tiles), recording(false), font(nullptr),
+      indicatorX(0), indicatorY(0), indicatorLit(false), marqueeLength(0),
+      marqueeWidth(0), marqueeHeight(0), marqueeX(0), marqueeY(0) {}
+
+void Display::beginFrame() {
+  frame.reset();
+  recording = true;
+}
+
+void Display::endFrame() {
+  flushFrame();
+  recording = false;
+}
+
+// Anche a frame pieno: disegna quanto registrato e ricomincia
+void Display::flushFrame() {
+  if (frame.size() == 0)
+    return;
+  if (tiles) {
+    tiles->render(frame);
+  } else {
+    fb.clearClip();
+    frame.rasterize(fb, 0, 0, fb.width(), fb.height());
+  }
+  frame.reset();
+  drawIndicator();
+}
+
+// Sopra tutto quello che è appena stato disegnato
+void Display::drawIndicator() {
+  if (!indicatorLit)
+    return;
+  Sprite pixel = {&PIXEL_ON, 1, 1, 1};
+  fb.blit(indicatorX, indicatorY, pixel, BLIT_NORMAL);
+}
+
+void Display::setIndicator(int x, int y, bool lit) {
+  bool wasLit = indicatorLit;
+  indicatorX = x;
+  indicatorY = y;
+  indicatorLit = lit;
+  if (lit) {
+    drawIndicator(); // Subito, anche su una scena ferma
+  } else if (wasLit) {
+    Sprite pixel = {&PIXEL_OFF, 1, 1, 1};
+    fb.blit(x, y, pixel, BLIT_NORMAL);
+  }
+}
+
+void Display::clearScreen(bool normal) {
+  if (!recording) {
+    fb.clear();
+    if (!normal)
+      fb.fillRect(0, 0, fb.width(), fb.height(), BLIT_OR);
+    drawIndicator();
+    return;
+  }
+  if (!frame.clear()) {
+    flushFrame();
+    frame.clear();
+  }
+  if (!normal && !frame.fillRect(0, 0, fb.width(), fb.height(), BLIT_OR)) {
+    flushFrame();
+    frame.fillRect(0, 0, fb.width(), fb.height(), BLIT_OR);
+  }
+}
+
+void Display::selectFont(const PackedFont &f) { font = &f; }
+
+void Display::drawString(int x, int y, const char *text, size_t length,
+                         BlitMode mode) {
+  if (!font || !font->valid())
+    return;
+  if (recording) {
+    if (frame.drawText(x, y, *font, text, length, mode))
+      return;
+    flushFrame();
+    if (frame.drawText(x, y, *font, text, length, mode))
+      return; // Altrimenti più lungo del buffer: subito
+  }
+  fb.drawText(x, y, *font, text, length, mode);
+  drawIndicator();
+}
+
+void Display::drawBitmap(int x, int y, const Sprite &sprite, BlitMode mode) {
+  if (recording) {
+    if (frame.blit(x, y, sprite, mode))
+      return;
+    flushFrame();
+    frame.blit(x, y, sprite, mode);
+    return;
+  }
+  fb.blit(x, y, sprite, mode);
+  drawIndicator();
+}
+
+void Display::writePixel(int x, int y, BlitMode mode, bool on) {
+  Sprite pixel = {on ? &PIXEL_ON : &PIXEL_OFF, 1, 1, 1};
+  drawBitmap(x, y, pixel, mode);
+}
+
+void Display::drawMarquee(const char *text, size_t length, int left,
+                          int top) {
+  if (length > sizeof(marqueeText))
+    length = sizeof(marqueeText);
+  memcpy(marqueeText, text, length);
+  marqueeLength = length;
+  marqueeWidth = font ? font->textWidth(text, length) : 0;
+  marqueeHeight = font ? font->height() : 0;
+  marqueeX = left;
+  marqueeY = top;
+  drawString(marqueeX, marqueeY, marqueeText, marqueeLength);
+}
+
+// DMD32 fa scorrere di un pixel l'intera RAM e ridisegna solo l'ultimo
+// carattere; con i kernel a word ridisegnare tutto costa meno
+bool Display::stepMarquee(int amountX, int amountY) {
+  bool wrapped = false;
+  marqueeX += amountX;
+  marqueeY += amountY;
+  if (marqueeX < -marqueeWidth) {
+    marqueeX = fb.width();
+    wrapped = true;
+  } else if (marqueeX > fb.width()) {
+    marqueeX = -marqueeWidth;
+    wrapped = true;
+  }
+  if (marqueeY < -marqueeHeight) {
+    marqueeY = fb.height();
+    wrapped = true;
+  } else if (marqueeY > fb.height()) {
+    marqueeY = -marqueeHeight;
+    wrapped = true;
+  }
+  clearScreen();
+  drawString(marqueeX, marqueeY, marqueeText, marqueeLength);
+  return wrapped;
+}
@@ -0,0 +1,169 @@
+#include "display_bench.h"
+
+#include <Arduino.h>
+#include <DMD32.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include "fonts/SystemFont5x7.h"
+#include "framebuffer.h"
+#include "log.h"
+#include "packed_font.h"
+#include "panel.h"
+#include "tile_renderer.h"
+
+#define BENCH_WIDTH 64 // Il muro di default: 2x1 pannelli
+#define BENCH_HEIGHT 16
+
+static const char *BENCH_TEXT = "Bologna C.le";
+
+// Bitmap a scacchi, nel formato di drawBitmap()
+static uint8_t pattern[BENCH_WIDTH / 8 * BENCH_HEIGHT];
+
+static uint32_t elapsedNs(int64_t startUs, int rounds) {
+  return (uint32_t)((esp_timer_get_time() - startUs) * 1000 / rounds);
+}
+
+static void report(const char *name, uint32_t dmdNs, uint32_t fastNs) {
+  LOG_I("display bench %-12s DMD32 %7lu ns, new %6lu ns (x%lu)", name,
+        (unsigned long)dmdNs, (unsigned long)fastNs,
+        (unsigned long)(fastNs ? dmdNs / fastNs : 0));
+}
+
+static void benchBitmap(DMD &dmd, Framebuffer &fb, const char *name,
+                        int width, int height) {
+  static uint32_t rows[BENCH_WIDTH / 32 * BENCH_HEIGHT];
+  Sprite sprite = spriteFromBytes(pattern, width, height, rows);
+
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < DISPLAY_BENCH_ROUNDS; i++)
+    dmd.drawBitmap(i & 7, 0, pattern, width, height, GRAPHICS_NORMAL);
+  uint32_t dmdNs = elapsedNs(start, DISPLAY_BENCH_ROUNDS);
+
+  start = esp_timer_get_time();
+  for (int i = 0; i < DISPLAY_BENCH_ROUNDS; i++)
+    fb.blit(i & 7, 0, sprite, BLIT_NORMAL);
+  report(name, dmdNs, elapsedNs(start, DISPLAY_BENCH_ROUNDS));
+}
+
+// Una riga di scansione, le quattro fasi a turno
+static void benchScan(int panels) {
+  char name[16];
+  snprintf(name, sizeof(name), "scan %dx1", panels);
+  // DMD32 non libera la sua RAM: qualche byte perso, solo in questo test
+  DMD *legacy = new DMD(panels, 1);
+  legacy->clearScreen(true);
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < DISPLAY_BENCH_ROUNDS; i++)
+    legacy->scanDisplayBySPI();
+  uint32_t dmdNs = elapsedNs(start, DISPLAY_BENCH_ROUNDS);
+  delete legacy;
+
+  PanelDriver driver(panels, 1);
+  if (!driver.begin())
+    return;
+  start = esp_timer_get_time();
+  for (int i = 0; i < DISPLAY_BENCH_ROUNDS; i++)
+    driver.scan();
+  report(name, dmdNs, elapsedNs(start, DISPLAY_BENCH_ROUNDS));
+}
+
+// Worker del bench sull'altro core, legato al renderer del muro in prova
+static TileRenderer *benchRenderer;
+
+static void benchTileTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    benchRenderer->help();
+  }
+}
+
+static void wakeBenchTile(void *task) { xTaskNotifyGive((TaskHandle_t)task); }
+
+static uint32_t usPerFrame(TileRenderer &renderer, const PackedFont &font,
+                           int width, int height) {
+  static TileFrame frame;
+  int chars = width / 6 < (int)strlen(BENCH_TEXT) ? width / 6
+                                                 : (int)strlen(BENCH_TEXT);
+  uint32_t totalUs = 0;
+  for (int i = 0; i < DISPLAY_BENCH_ROUNDS / 10; i++) {
+    frame.reset();
+    frame.clear();
+    for (int band = 0; band < height; band += 16) {
+      frame.drawText(2 - i % 7, band, font, BENCH_TEXT, chars, BLIT_NORMAL);
+      frame.drawText(8, band + 8, font, BENCH_TEXT, chars, BLIT_OR);
+    }
+    int64_t start = esp_timer_get_time();
+    renderer.render(frame);
+    totalUs += esp_timer_get_time() - start;
+  }
+  return totalUs / (DISPLAY_BENCH_ROUNDS / 10);
+}
+
+// Tempo per frame, con 1 e 2 worker
+static void benchTiles(TaskHandle_t task, const PackedFont &font, int across,
+                       int down) {
+  int width = 32 * across, height = 16 * down;
+  uint32_t *words = (uint32_t *)malloc(width / 32 * height * 4);
+  if (!words)
+    return;
+  Framebuffer fb(words, width, height, FB_SCAN_ORDER);
+  TileRenderer renderer(fb);
+  uint32_t one = usPerFrame(renderer, font, width, height);
+  benchRenderer = &renderer;
+  renderer.setHelper(wakeBenchTile, task);
+  uint32_t two = usPerFrame(renderer, font, width, height);
+  renderer.setHelper(nullptr, nullptr);
+  LOG_I("display bench tiles %2dx%-2d 1 worker %5lu us, 2 workers %5lu us "
+        "(helper %lu tiles)",
+        across, down, (unsigned long)one, (unsigned long)two,
+        (unsigned long)renderer.helperTiles());
+  free(words);
+}
+
+void displayBenchRun() {
+  static DMD dmd(BENCH_WIDTH / 32, BENCH_HEIGHT / 16);
+  static uint32_t words[BENCH_WIDTH / 32 * BENCH_HEIGHT];
+  Framebuffer fb(words, BENCH_WIDTH, BENCH_HEIGHT);
+  for (size_t i = 0; i < sizeof(pattern); i++)
+    pattern[i] = (i / (BENCH_WIDTH / 8)) & 1 ? 0xaa : 0x55;
+
+  LOG_I("display bench: %d draws each", DISPLAY_BENCH_ROUNDS);
+  static uint8_t blob[4096] __attribute__((aligned(4)));
+  PackedFont packed;
+  bool converted =
+      packed.attach(blob, packedFontFromDmd(System5x7, blob, sizeof(blob)));
+  if (converted) {
+    size_t length = strlen(BENCH_TEXT);
+    dmd.selectFont(System5x7);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < DISPLAY_BENCH_ROUNDS; i++)
+      dmd.drawString(i & 7, 0, BENCH_TEXT, length, GRAPHICS_NORMAL);
+    uint32_t dmdNs = elapsedNs(start, DISPLAY_BENCH_ROUNDS * length);
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < DISPLAY_BENCH_ROUNDS; i++)
+      fb.drawText(i & 7, 0, packed, BENCH_TEXT, length, BLIT_NORMAL);
+    report("glyph", dmdNs, elapsedNs(start, DISPLAY_BENCH_ROUNDS * length));
+  }
+  benchBitmap(dmd, fb, "icon 16x16", 16, 16);
+  benchBitmap(dmd, fb, "screen 64x16", BENCH_WIDTH, BENCH_HEIGHT);
+  dmd.clearScreen(true);
+
+  // Tempo dell'ISR per riga: DMD32 cresce con i byte raccolti uno a uno
+  for (int panels = 1; panels <= DISPLAY_BENCH_MAX_PANELS; panels *= 2)
+    benchScan(panels);
+
+  // Rasterizzazione per tile: il secondo worker sul core 0
+  TaskHandle_t task = NULL;
+  if (converted &&
+      xTaskCreatePinnedToCore(benchTileTask, "bench tiles", 3072, NULL,
+                              tskIDLE_PRIORITY + 2, &task, 0) == pdPASS) {
+    const int walls[][2] = {{1, 1}, {2, 1}, {4, 1}, {8, 1},
+                            {8, 2}, {8, 4}, {8, 8}};
+    for (auto &wall : walls)
+      benchTiles(task, packed, wall[0], wall[1]);
+    vTaskDelete(task);
+  }
+  logFlush();
+}
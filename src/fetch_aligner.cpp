@@ -0,0 +1,31 @@
+#include "fetch_aligner.h"
+
+FetchAligner::FetchAligner() : lastStartMs(0), periodMs(0), starts(0) {}
+
+void FetchAligner::onDeparturesShown(uint32_t nowMs) {
+  if (starts > 0) {
+    uint32_t period = nowMs - lastStartMs;
+    // Un ciclo fermo (fetch lungo, scena bloccata) non sposta la media
+    if (starts == 1 || period < 2 * periodMs)
+      periodMs = starts == 1 ? period : periodMs - periodMs / 4 + period / 4;
+  }
+  lastStartMs = nowMs;
+  starts++;
+}
+
+bool FetchAligner::predicting(uint32_t nowMs) const {
+  if (starts < 2)
+    return false;
+  // Mezzo periodo di ritardo è tollerato, poi il ciclo è considerato fermo
+  return (int32_t)(nowMs - (nextDeparturesMs() + periodMs / 2)) < 0;
+}
+
+bool FetchAligner::hold(uint32_t nowMs, uint32_t dueMs) const {
+  if (!predicting(nowMs))
+    return false;
+  return (int32_t)(nextDeparturesMs() - dueMs) <= FETCH_ALIGN_MAX_HOLD_MS;
+}
+
+bool FetchAligner::dueBeforeDepartures(uint32_t nowMs, uint32_t dueMs) const {
+  return predicting(nowMs) && (int32_t)(dueMs - nextDeparturesMs()) <= 0;
+}
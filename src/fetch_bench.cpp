@@ -0,0 +1,163 @@
+#include "fetch_bench.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#include "http_fetch.h"
+#include "lean_http.h"
+#include "log.h"
+#include "tls_socket.h"
+
+// =================================================================
+// HEAP HOOKS
+// Chiamati da heap_caps per ogni malloc/free quando l'sdkconfig ha
+// CONFIG_HEAP_USE_HOOKS; contano solo dentro una finestra aperta.
+// =================================================================
+static portMUX_TYPE hookMux = portMUX_INITIALIZER_UNLOCKED;
+static bool windowOpen = false;
+static uint32_t allocations = 0;
+static uint32_t allocatedBytes = 0;
+static int32_t liveBytes = 0;
+static int32_t peakLiveBytes = 0;
+
+#if CONFIG_HEAP_USE_HOOKS
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size,
+                                                    uint32_t caps) {
+  (void)caps;
+  if (!ptr)
+    return;
+  taskENTER_CRITICAL(&hookMux); // Allocano anche i task sull'altro core
+  if (windowOpen) {
+    allocations++;
+    allocatedBytes += size;
+    liveBytes += size;
+    if (liveBytes > peakLiveBytes)
+      peakLiveBytes = liveBytes;
+  }
+  taskEXIT_CRITICAL(&hookMux);
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void *ptr) {
+  if (!ptr)
+    return;
+  size_t size = heap_caps_get_allocated_size(ptr);
+  taskENTER_CRITICAL(&hookMux);
+  if (windowOpen)
+    liveBytes -= size;
+  taskEXIT_CRITICAL(&hookMux);
+}
+#endif
+
+static uint32_t freeHeap() {
+  return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+void fetchBenchHeapBegin() {
+  taskENTER_CRITICAL(&hookMux);
+  allocations = 0;
+  allocatedBytes = 0;
+  liveBytes = 0;
+  peakLiveBytes = 0;
+  windowOpen = true;
+  taskEXIT_CRITICAL(&hookMux);
+}
+
+void fetchBenchHeapEnd(HeapWindow &window) {
+  taskENTER_CRITICAL(&hookMux);
+  windowOpen = false;
+  window.allocations = allocations;
+  window.allocatedBytes = allocatedBytes;
+  window.peakLiveBytes = peakLiveBytes;
+  taskEXIT_CRITICAL(&hookMux);
+  window.freeAfter = freeHeap();
+}
+
+// =================================================================
+// BENCHMARK
+// =================================================================
+
+// Solo il trasporto: il corpo viene letto e scartato
+static bool drainBody(BodyReader &body, void *context) {
+  (void)context;
+  char scratch[256];
+  while (body.readBytes(scratch, sizeof(scratch)) > 0)
+    ;
+  return true;
+}
+
+static int64_t benchMonoUs() { return esp_timer_get_time(); }
+
+static void benchTransport(const char *name, HttpTransport &transport,
+                           const char *url) {
+  uint64_t totalUs = 0;
+  uint32_t totalAllocs = 0;
+  int32_t worstPeak = 0;
+
+  for (int round = 0; round < FETCH_BENCH_ROUNDS; round++) {
+    HeapWindow heap = {};
+    heap.freeBefore = freeHeap();
+    fetchBenchHeapBegin();
+    FetchResult r = httpFetch(transport, url, drainBody, nullptr,
+                              benchMonoUs);
+    fetchBenchHeapEnd(heap);
+
+    uint32_t ms = (uint32_t)((r.doneUs - r.sentUs) / 1000);
+    LOG_I("bench %-10s #%d: %s %d, %u B body, %lu ms, %lu allocs "
+          "(%lu B), peak +%ld B, free %lu -> %lu",
+          name, round, fetchStatusName(r.status), r.code, r.bodyBytes,
+          (unsigned long)ms, (unsigned long)heap.allocations,
+          (unsigned long)heap.allocatedBytes, (long)heap.peakLiveBytes,
+          (unsigned long)heap.freeBefore, (unsigned long)heap.freeAfter);
+    totalUs += r.doneUs - r.sentUs;
+    totalAllocs += heap.allocations;
+    if (heap.peakLiveBytes > worstPeak)
+      worstPeak = heap.peakLiveBytes;
+    delay(500);
+  }
+
+  LOG_I("bench %-10s avg %lu ms, %lu allocs/fetch, worst peak +%ld B",
+        name, (unsigned long)(totalUs / FETCH_BENCH_ROUNDS / 1000),
+        (unsigned long)(totalAllocs / FETCH_BENCH_ROUNDS), (long)worstPeak);
+}
+
+// Ogni giro apre una connessione nuova: completa (pin) o ripresa
+static void benchHandshakes(const char *name, bool resume, const char *url) {
+  uint32_t totalMs = 0;
+  uint32_t totalCpuUs = 0;
+
+  for (int round = 0; round < FETCH_BENCH_ROUNDS; round++) {
+    tlsSocket().stop();
+    if (!resume)
+      tlsSocketForgetSession();
+    FetchResult r = httpFetch(leanHttpsTransport(), url, drainBody, nullptr,
+                              benchMonoUs);
+    const TlsStats &tls = tlsSocketStats();
+    LOG_I("bench %-10s #%d: %s, handshake %lu ms (cpu %lu ms, pin %lu us)%s",
+          name, round, fetchStatusName(r.status),
+          (unsigned long)tls.lastHandshakeMs,
+          (unsigned long)(tls.lastHandshakeCpuUs / 1000),
+          (unsigned long)tls.lastPinCheckUs,
+          tls.lastResumed ? ", resumed" : "");
+    totalMs += tls.lastHandshakeMs;
+    totalCpuUs += tls.lastHandshakeCpuUs;
+    delay(500);
+  }
+
+  LOG_I("bench %-10s avg handshake %lu ms, cpu %lu ms", name,
+        (unsigned long)(totalMs / FETCH_BENCH_ROUNDS),
+        (unsigned long)(totalCpuUs / FETCH_BENCH_ROUNDS / 1000));
+}
+
+void fetchBenchRun(const char *url) {
+#if !CONFIG_HEAP_USE_HOOKS
+  LOG_W("bench: CONFIG_HEAP_USE_HOOKS off, allocation counts will be 0");
+#endif
+  LOG_I("bench: %d fetches per transport", FETCH_BENCH_ROUNDS);
+  benchTransport("HTTPClient", httpClientTransport(), url);
+  benchTransport("lean", leanHttpsTransport(), url);
+  benchHandshakes("full", false, url);
+  benchHandshakes("resumed", true, url);
+  logFlush();
+}
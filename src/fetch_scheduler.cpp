@@ -0,0 +1,114 @@
+#include "fetch_scheduler.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Mescola bene anche MAC consecutivi dello stesso lotto (splitmix64)
+static uint64_t mix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+FetchScheduler::FetchScheduler(uint32_t intervalMs, uint32_t maxJitterMs)
+    : interval(intervalMs), maxJitter(maxJitterMs), phase(0), anchorMs(0),
+      nextMs(0), failures(0), rngState(1) {}
+
+void FetchScheduler::begin(uint32_t nowMs, uint64_t deviceId, uint32_t seed) {
+  uint64_t h = mix64(deviceId);
+  phase = (uint32_t)(h % interval);
+  rngState = seed ? seed : (uint32_t)(h >> 32) | 1;
+  failures = 0;
+
+  // Primo fetch presto (serve qualcosa da mostrare), ma distribuito;
+  // i successivi seguono la griglia sfasata di phase
+  nextMs = nowMs + (uint32_t)(h >> 40) % FETCH_BOOT_SPREAD_MS;
+  anchorMs = nowMs + phase;
+}
+
+uint32_t FetchScheduler::random32() {
+  // xorshift32: deterministico e identico su ESP32 e host
+  uint32_t x = rngState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rngState = x;
+  return x;
+}
+
+int32_t FetchScheduler::jitter() {
+  if (maxJitter == 0)
+    return 0;
+  return (int32_t)(random32() % (2 * maxJitter + 1)) - (int32_t)maxJitter;
+}
+
+void FetchScheduler::onSuccess(uint32_t nowMs, const FetchHints &hints) {
+  failures = 0;
+
+  // Prossimo slot della griglia dopo adesso, più il jitter
+  uint32_t periods = (uint32_t)(nowMs - anchorMs) / interval + 1;
+  if ((int32_t)(nowMs - anchorMs) < 0)
+    periods = 0;
+  uint32_t slot = anchorMs + periods * interval;
+  // Troppo vicino (fetch fuori griglia, es. dopo un errore): salta uno slot
+  if (slot - nowMs < interval / 2)
+    slot += interval;
+  nextMs = slot + jitter();
+
+  // max-age: il server dice che i dati restano validi, non chiedere prima
+  uint32_t cap = FETCH_HINT_MAX_INTERVALS * interval;
+  if (hints.maxAgeS) {
+    // Confronto in secondi: maxAgeS * 1000 può superare 32 bit
+    uint32_t fresh = hints.maxAgeS < cap / 1000 ? hints.maxAgeS * 1000 : cap;
+    if ((int32_t)(nowMs + fresh - nextMs) > 0)
+      nextMs = nowMs + fresh + random32() % (maxJitter + 1);
+  }
+}
+
+void FetchScheduler::onFailure(uint32_t nowMs, const FetchHints &hints) {
+  failures++;
+  uint32_t cap = FETCH_HINT_MAX_INTERVALS * interval;
+
+  if (hints.retryAfterS) {
+    // Il server chiede esplicitamente di aspettare: lo rispettiamo, più un
+    // jitter solo positivo così i client non tornano tutti insieme
+    uint32_t wait =
+        hints.retryAfterS < cap / 1000 ? hints.retryAfterS * 1000 : cap;
+    nextMs = nowMs + wait + random32() % (wait / 10 + 1);
+    return;
+  }
+
+  // Backoff esponenziale con "full jitter", limitato all'intervallo
+  uint32_t backoff = FETCH_RETRY_MIN_MS;
+  for (uint32_t i = 1; i < failures && backoff < interval; i++)
+    backoff *= 2;
+  if (backoff > interval)
+    backoff = interval;
+  nextMs = nowMs + backoff / 2 + random32() % (backoff / 2 + 1);
+}
+
+// strtoul() satura a ULONG_MAX, che sull'host ha 64 bit
+static uint32_t clampSeconds(unsigned long seconds) {
+  return seconds > UINT32_MAX ? UINT32_MAX : (uint32_t)seconds;
+}
+
+uint32_t parseRetryAfterSeconds(const char *value) {
+  if (!value)
+    return 0;
+  while (*value == ' ')
+    value++;
+  if (!isdigit((unsigned char)*value))
+    return 0;
+  return clampSeconds(strtoul(value, NULL, 10));
+}
+
+uint32_t parseCacheControlMaxAge(const char *value) {
+  if (!value || strstr(value, "no-store") || strstr(value, "no-cache"))
+    return 0;
+  const char *p = strstr(value, "max-age=");
+  if (!p)
+    return 0;
+  return clampSeconds(strtoul(p + 8, NULL, 10));
+}
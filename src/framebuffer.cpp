@@ -0,0 +1,273 @@
+#include "framebuffer.h"
+
+#include <string.h>
+
+// =================================================================
+// KERNELS
+// Una modalità per istanza del template: il combine si riduce a due o
+// tre operazioni logiche su un word, senza salti nel ciclo interno.
+// s = bit della sorgente già allineati, m = area coperta (modi opachi)
+// =================================================================
+
+template <BlitMode M>
+static inline void combine(uint32_t &d, uint32_t s, uint32_t m) {
+  switch (M) {
+  case BLIT_NORMAL:
+    d = (d & ~m) | (s & m);
+    break;
+  case BLIT_INVERSE:
+    d = (d & ~m) | (~s & m);
+    break;
+  case BLIT_XOR:
+    d ^= s;
+    break;
+  case BLIT_OR:
+    d |= s;
+    break;
+  case BLIT_NOR:
+    d &= ~s;
+    break;
+  }
+}
+
+// Word k di un'area larga width: pieno, parziale (bit alti) o vuoto
+static inline uint32_t spanMask(int k, int width) {
+  int bits = width - 32 * k;
+  if (bits >= 32)
+    return 0xffffffffu;
+  return bits <= 0 ? 0 : 0xffffffffu << (32 - bits);
+}
+
+// =================================================================
+// LAYOUTS
+// Dove sta un word dello schermo: rowBase() una volta per riga, poi
+// load() / store() per word. In row-major si riducono a un accesso
+// all'array, in scan order a 4 byte distanti 4, accesi a 0.
+// =================================================================
+
+struct Target {
+  uint32_t *words;
+  int stride; // Word per riga = pannelli in orizzontale
+  int height;
+  int lo; // Word scrivibili: [lo, hi)
+  int hi;
+};
+
+struct RowMajor {
+  static inline size_t rowBase(const Target &t, int y) {
+    return (size_t)y * t.stride;
+  }
+  static inline uint32_t load(const Target &t, size_t base, int k) {
+    return t.words[base + k];
+  }
+  static inline void store(const Target &t, size_t base, int k,
+                           uint32_t v) {
+    t.words[base + k] = v;
+  }
+};
+
+// Riga r del pannello: blocco r % 4, posizione 3 - r / 4 in ogni
+// gruppo di 4 byte; 16 byte per pannello e riga di scansione
+struct ScanOrder {
+  static inline size_t rowBase(const Target &t, int y) {
+    int r = y & 15;
+    size_t panels = (size_t)t.stride * (t.height >> 4);
+    return (r & 3) * 16 * panels + (size_t)(y >> 4) * t.stride * 16 +
+           (3 - (r >> 2));
+  }
+  static inline uint32_t load(const Target &t, size_t base, int k) {
+    const uint8_t *p = (const uint8_t *)t.words + base + 16 * k;
+    return ~((uint32_t)p[0] << 24 | (uint32_t)p[4] << 16 |
+             (uint32_t)p[8] << 8 | p[12]);
+  }
+  static inline void store(const Target &t, size_t base, int k,
+                           uint32_t v) {
+    uint8_t *p = (uint8_t *)t.words + base + 16 * k;
+    v = ~v;
+    p[0] = v >> 24;
+    p[4] = v >> 16;
+    p[8] = v >> 8;
+    p[12] = v;
+  }
+};
+
+// Solid: nessuna sorgente, l'area è tutta accesa (fillRect)
+template <class L, BlitMode M, bool Solid>
+static void blitRows(const Target &t, int y, const uint32_t *src,
+                     int srcStride, int rows, int x, int cellWidth) {
+  int lo = t.lo, hi = t.hi;
+  int shift = x & 31;
+  int base = x >> 5; // Arrotonda verso -inf anche se x < 0
+  int cellWords = (cellWidth + 31) >> 5;
+  // Solo i word della sorgente che toccano l'area di clip
+  int kFirst = base < lo - 1 ? lo - 1 - base : 0;
+  int kLast = hi - base < cellWords ? hi - base : cellWords;
+
+  for (int r = 0; r < rows; r++, src += srcStride) {
+    size_t row = L::rowBase(t, y + r);
+    for (int k = kFirst; k < kLast; k++) {
+      uint32_t m = spanMask(k, cellWidth);
+      uint32_t s = Solid ? m : k < srcStride ? src[k] : 0;
+      int word = base + k;
+      if (word >= lo) {
+        uint32_t d = L::load(t, row, word);
+        combine<M>(d, s >> shift, m >> shift);
+        L::store(t, row, word, d);
+      }
+      if (shift && word + 1 < hi) {
+        uint32_t d = L::load(t, row, word + 1);
+        combine<M>(d, s << (32 - shift), m << (32 - shift));
+        L::store(t, row, word + 1, d);
+      }
+    }
+  }
+}
+
+typedef void (*BlitKernel)(const Target &, int, const uint32_t *, int, int,
+                           int, int);
+
+#define BLIT_KERNELS(L, Solid)                                               \
+  {blitRows<L, BLIT_NORMAL, Solid>, blitRows<L, BLIT_INVERSE, Solid>,        \
+   blitRows<L, BLIT_XOR, Solid>, blitRows<L, BLIT_OR, Solid>,                \
+   blitRows<L, BLIT_NOR, Solid>}
+
+// [layout][mode]
+static const BlitKernel KERNELS[][5] = {BLIT_KERNELS(RowMajor, false),
+                                        BLIT_KERNELS(ScanOrder, false)};
+static const BlitKernel FILL_KERNELS[][5] = {BLIT_KERNELS(RowMajor, true),
+                                             BLIT_KERNELS(ScanOrder, true)};
+
+// =================================================================
+// Framebuffer
+// =================================================================
+
+Sprite spriteFromBytes(const uint8_t *bits, uint16_t width, uint16_t height,
+                       uint32_t *out) {
+  int rowBytes = (width + 7) / 8;
+  uint8_t wordsPerRow = (width + 31) / 32;
+  for (int y = 0; y < height; y++) {
+    for (int k = 0; k < wordsPerRow; k++) {
+      uint32_t word = 0;
+      for (int b = 0; b < 4; b++) {
+        int i = 4 * k + b;
+        word = (word << 8) | (i < rowBytes ? bits[y * rowBytes + i] : 0);
+      }
+      out[y * wordsPerRow + k] = word & spanMask(k, width);
+    }
+  }
+  return {out, width, height, wordsPerRow};
+}
+
+Framebuffer::Framebuffer(uint32_t *words, int width, int height,
+                         FramebufferLayout layout)
+    : words(words), w(width), h(height), stride(width / 32), order(layout),
+      clipLo(0), clipHi(stride), clipTop(0), clipBottom(height) {}
+
+void Framebuffer::setClip(int x, int y, int width, int height) {
+  int lo = x < 0 ? 0 : x >> 5;
+  int hi = x + width >= w ? stride : (x + width + 31) >> 5;
+  clipLo = lo;
+  clipHi = hi > lo ? hi : lo;
+  clipTop = y < 0 ? 0 : y > h ? h : y;
+  clipBottom = y + height > h ? h : y + height;
+  if (clipBottom < clipTop)
+    clipBottom = clipTop;
+}
+
+void Framebuffer::clearClip() {
+  clipLo = 0;
+  clipHi = stride;
+  clipTop = 0;
+  clipBottom = h;
+}
+
+uint32_t Framebuffer::word(int y, int k) const {
+  Target t = {words, stride, h, 0, stride};
+  if (order == FB_SCAN_ORDER)
+    return ScanOrder::load(t, ScanOrder::rowBase(t, y), k);
+  return RowMajor::load(t, RowMajor::rowBase(t, y), k);
+}
+
+void Framebuffer::setWord(int y, int k, uint32_t value) {
+  Target t = {words, stride, h, 0, stride};
+  if (order == FB_SCAN_ORDER)
+    ScanOrder::store(t, ScanOrder::rowBase(t, y), k, value);
+  else
+    RowMajor::store(t, RowMajor::rowBase(t, y), k, value);
+}
+
+// In scan order i LED spenti sono bit a 1
+void Framebuffer::clear() {
+  memset(words, order == FB_SCAN_ORDER ? 0xff : 0, size());
+}
+
+bool Framebuffer::pixel(int x, int y) const {
+  if (x < 0 || x >= w || y < 0 || y >= h)
+    return false;
+  return (word(y, x >> 5) >> (31 - (x & 31))) & 1;
+}
+
+void Framebuffer::setPixel(int x, int y, BlitMode mode) {
+  fillRect(x, y, 1, 1, mode);
+}
+
+void Framebuffer::blit(int x, int y, const Sprite &sprite, BlitMode mode,
+                       int cellWidth) {
+  if (cellWidth < sprite.width)
+    cellWidth = sprite.width;
+  if (x >= 32 * clipHi || x + cellWidth <= 32 * clipLo ||
+      y >= clipBottom || y + sprite.height <= clipTop)
+    return;
+  int first = y < clipTop ? clipTop - y : 0;
+  int last = y + sprite.height > clipBottom ? clipBottom - y : sprite.height;
+  Target t = {words, stride, h, clipLo, clipHi};
+  KERNELS[order][mode](t, y + first, sprite.rows + first * sprite.wordsPerRow,
+                       sprite.wordsPerRow, last - first, x, cellWidth);
+}
+
+void Framebuffer::fillRect(int x, int y, int width, int height,
+                           BlitMode mode) {
+  if (y < clipTop) {
+    height -= clipTop - y;
+    y = clipTop;
+  }
+  if (y + height > clipBottom)
+    height = clipBottom - y;
+  int left = 32 * clipLo, right = 32 * clipHi;
+  if (height <= 0 || x >= right || x + width <= left)
+    return;
+  if (x < left) { // Niente sorgente da scorrere: basta tagliare l'area
+    width -= left - x;
+    x = left;
+  }
+  if (x + width > right)
+    width = right - x;
+  Target t = {words, stride, h, clipLo, clipHi};
+  FILL_KERNELS[order][mode](t, y, nullptr, 0, height, x, width);
+}
+
+int Framebuffer::drawChar(int x, int y, const PackedFont &font, uint8_t c,
+                          BlitMode mode) {
+  GlyphBits g;
+  if (!font.glyph(c, g))
+    return 0;
+  Sprite sprite = {g.rows, g.width, g.height, g.wordsPerRow};
+  int spacing = font.spacing();
+  if (mode == BLIT_NORMAL) {
+    blit(x, y, sprite, mode, g.width + spacing); // Spaziatura compresa
+  } else {
+    blit(x, y, sprite, mode);
+    // Come DMD32, la colonna di spaziatura viene sempre spenta
+    if (spacing)
+      fillRect(x + g.width, y, spacing, g.height, BLIT_NOR);
+  }
+  return g.width + spacing;
+}
+
+int Framebuffer::drawText(int x, int y, const PackedFont &font,
+                          const char *text, size_t length, BlitMode mode) {
+  int start = x;
+  for (size_t i = 0; i < length && x < 32 * clipHi; i++)
+    x += drawChar(x, y, font, (uint8_t)text[i], mode);
+  return x - start;
+}
@@ -0,0 +1,79 @@
+#include "freshness.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const uint32_t BUCKET_LIMIT_S[FRESHNESS_BUCKETS - 1] = {
+    15, 30, 60, 120, 300, 600, 900};
+
+uint32_t freshnessBucketLimitS(size_t i) {
+  return i < FRESHNESS_BUCKETS - 1 ? BUCKET_LIMIT_S[i] : 0;
+}
+
+DataFreshness::DataFreshness() : latencyMs(0), latencyMaxMs(0) {
+  memset(&current, 0, sizeof(current));
+  memset(&age, 0, sizeof(age));
+}
+
+void DataFreshness::onData(const DataTimeline &timeline) {
+  current = timeline;
+  current.renderedUs = 0;
+}
+
+bool DataFreshness::onRendered(int64_t nowUs) {
+  if (!hasData() || current.renderedUs)
+    return false;
+  current.renderedUs = nowUs;
+  latencyMs = (uint32_t)((nowUs - current.requestUs) / 1000);
+  if (latencyMs > latencyMaxMs)
+    latencyMaxMs = latencyMs;
+  return true;
+}
+
+uint32_t DataFreshness::ageMs(int64_t nowUs) const {
+  if (!hasData())
+    return FRESHNESS_NO_DATA;
+  return (uint32_t)((nowUs - current.requestUs) / 1000);
+}
+
+uint32_t DataFreshness::onShown(int64_t nowUs, bool live) {
+  if (!live || !hasData()) {
+    age.noData++;
+    return FRESHNESS_NO_DATA;
+  }
+  uint32_t ms = ageMs(nowUs);
+  age.shown++;
+  age.lastMs = ms;
+  age.sumMs += ms;
+  if (ms > age.maxMs)
+    age.maxMs = ms;
+  size_t b = 0;
+  while (b < FRESHNESS_BUCKETS - 1 && ms >= BUCKET_LIMIT_S[b] * 1000)
+    b++;
+  age.buckets[b]++;
+  return ms;
+}
+
+// "15s", "2m": i limiti tondi si leggono meglio così
+static int formatLimit(char *buf, size_t size, uint32_t s) {
+  return s % 60 ? snprintf(buf, size, "%lus", (unsigned long)s)
+                : snprintf(buf, size, "%lum", (unsigned long)s / 60);
+}
+
+size_t freshnessFormatHistogram(const DataAgeStats &stats, char *buf,
+                                size_t size) {
+  size_t n = 0;
+  if (size)
+    buf[0] = '\0';
+  for (size_t i = 0; i < FRESHNESS_BUCKETS && n + 1 < size; i++) {
+    char limit[12];
+    uint32_t s = freshnessBucketLimitS(i);
+    formatLimit(limit, sizeof(limit), s ? s : BUCKET_LIMIT_S[i - 1]);
+    int w = snprintf(buf + n, size - n, "%s%s%s:%lu", i ? " " : "",
+                     s ? "<" : ">=", limit, (unsigned long)stats.buckets[i]);
+    if (w < 0)
+      break;
+    n += (size_t)w < size - n ? (size_t)w : size - n - 1;
+  }
+  return n;
+}
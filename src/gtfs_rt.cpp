@@ -0,0 +1,334 @@
+#include "gtfs_rt.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Numeri di campo di gtfs-realtime.proto
+#define FEED_HEADER 1
+#define FEED_ENTITY 2
+#define HEADER_TIMESTAMP 3
+#define ENTITY_IS_DELETED 2
+#define ENTITY_TRIP_UPDATE 3
+#define TRIP_UPDATE_TRIP 1
+#define TRIP_UPDATE_STOP_TIME 2
+#define TRIP_UPDATE_VEHICLE 3
+#define TRIP_UPDATE_DELAY 5
+#define TRIP_ID 1
+#define TRIP_RELATIONSHIP 4
+#define TRIP_ROUTE_ID 5
+#define VEHICLE_LABEL 2
+#define STOP_TIME_ARRIVAL 2
+#define STOP_TIME_DEPARTURE 3
+#define STOP_TIME_STOP_ID 4
+#define STOP_TIME_RELATIONSHIP 5
+#define EVENT_DELAY 1
+#define EVENT_TIME 2
+
+#define TRIP_CANCELED 3
+#define STOP_SKIPPED 1
+#define STOP_NO_DATA 2
+
+#define WIRE_VARINT 0
+#define WIRE_FIXED64 1
+#define WIRE_LENGTH 2
+#define WIRE_FIXED32 5
+
+GtfsRtDecoder::GtfsRtDecoder(Snapshot &snap, const char *stopId,
+                             int64_t nowUtc)
+    : snap(snap), stopId(stopId), stopIdLength(strlen(stopId)),
+      nowUtc(nowUtc), state(TAG), wireType(0), shift(0), field(0), value(0),
+      pos(0), remaining(0), depth(1), out(nullptr), room(0), length(0),
+      matchingStop(false), headerTime(0) {
+  memset(&snap, 0, sizeof(snap));
+  memset(&counters, 0, sizeof(counters));
+  stack[0] = {MSG_FEED, 0xffffffffu};
+  begin(MSG_ENTITY);
+}
+
+size_t GtfsRtDecoder::feed(const uint8_t *data, size_t size) {
+  size_t i = 0;
+  while (i < size && state != FAILED) {
+    if (state == SKIP || state == STRING) {
+      // Campi interi in un colpo solo, anche a cavallo dei chunk
+      size_t n = size - i < remaining ? size - i : remaining;
+      if (state == STRING) {
+        if (out) {
+          size_t copy = length + n < room ? n : room - 1 - length;
+          memcpy(out + length, data + i, copy);
+          out[length + copy] = '\0';
+        } else if (matchingStop) {
+          matchingStop = length + n <= stopIdLength &&
+                         memcmp(stopId + length, data + i, n) == 0;
+        }
+        length += n;
+        if (out && length >= room)
+          length = room - 1;
+      }
+      i += n;
+      pos += n;
+      remaining -= n;
+      if (remaining == 0)
+        endField();
+      continue;
+    }
+
+    if (depth > 1 && pos >= stack[depth - 1].end) {
+      state = FAILED; // Un varint sfora il messaggio che lo contiene
+      break;
+    }
+    uint8_t b = data[i++];
+    pos++;
+    if (!readVarint(b))
+      continue;
+    switch (state) {
+    case TAG:
+      onTag();
+      break;
+    case VARINT:
+      onVarint();
+      break;
+    case LENGTH:
+      onLength();
+      break;
+    default:
+      break;
+    }
+  }
+  return i;
+}
+
+bool GtfsRtDecoder::finish() {
+  if (state != TAG || depth != 1 || shift != 0)
+    state = FAILED;
+  return state != FAILED;
+}
+
+bool GtfsRtDecoder::readVarint(uint8_t b) {
+  if (shift == 0)
+    value = 0;
+  value |= (uint64_t)(b & 0x7f) << shift;
+  if (b & 0x80) {
+    shift += 7;
+    if (shift >= 64)
+      state = FAILED;
+    return false;
+  }
+  shift = 0;
+  return true;
+}
+
+void GtfsRtDecoder::onTag() {
+  field = (uint32_t)(value >> 3);
+  wireType = value & 7;
+  if (field == 0) {
+    state = FAILED;
+    return;
+  }
+  switch (wireType) {
+  case WIRE_VARINT:
+    state = VARINT;
+    return;
+  case WIRE_LENGTH:
+    state = LENGTH;
+    return;
+  case WIRE_FIXED64:
+  case WIRE_FIXED32:
+    remaining = wireType == WIRE_FIXED64 ? 8 : 4;
+    if (remaining > stack[depth - 1].end - pos) {
+      state = FAILED;
+      return;
+    }
+    out = nullptr;
+    state = SKIP;
+    return;
+  default:
+    state = FAILED; // Gruppi (3, 4): deprecati, non usati da GTFS-RT
+    return;
+  }
+}
+
+void GtfsRtDecoder::onVarint() {
+  Message message = stack[depth - 1].message;
+  if (message == MSG_HEADER && field == HEADER_TIMESTAMP) {
+    headerTime = (int64_t)value;
+  } else if (message == MSG_ENTITY && field == ENTITY_IS_DELETED) {
+    deleted = value != 0;
+  } else if (message == MSG_TRIP_UPDATE && field == TRIP_UPDATE_DELAY) {
+    hasTripDelay = true;
+    tripDelay = (int32_t)(int64_t)value;
+  } else if (message == MSG_TRIP && field == TRIP_RELATIONSHIP) {
+    canceled = value == TRIP_CANCELED;
+  } else if (message == MSG_STOP_TIME && field == STOP_TIME_RELATIONSHIP) {
+    stopSkipped = value == STOP_SKIPPED || value == STOP_NO_DATA;
+  } else if (message == MSG_ARRIVAL || message == MSG_DEPARTURE) {
+    Event &event = message == MSG_ARRIVAL ? arrival : departure;
+    if (field == EVENT_DELAY) {
+      event.hasDelay = true;
+      event.delay = (int32_t)(int64_t)value; // int32: negativi su 10 byte
+    } else if (field == EVENT_TIME) {
+      event.hasTime = true;
+      event.time = (int64_t)value;
+    }
+  }
+  endField();
+}
+
+void GtfsRtDecoder::onLength() {
+  Message parent = stack[depth - 1].message;
+  if (value > stack[depth - 1].end - pos) {
+    state = FAILED;
+    return;
+  }
+  remaining = (uint32_t)value;
+  Message message = child(field);
+  if (message != MSG_NONE) {
+    if (depth == GTFS_RT_DEPTH) {
+      state = FAILED;
+      return;
+    }
+    stack[depth++] = {message, pos + remaining};
+    begin(message);
+    endField(); // Chiude subito i messaggi vuoti
+    return;
+  }
+
+  out = nullptr;
+  matchingStop = false;
+  length = 0;
+  if (parent == MSG_TRIP && field == TRIP_ID) {
+    out = tripId;
+    room = sizeof(tripId);
+  } else if (parent == MSG_TRIP && field == TRIP_ROUTE_ID) {
+    out = routeId;
+    room = sizeof(routeId);
+  } else if (parent == MSG_VEHICLE && field == VEHICLE_LABEL) {
+    out = label;
+    room = sizeof(label);
+  } else if (parent == MSG_STOP_TIME && field == STOP_TIME_STOP_ID) {
+    matchingStop = true;
+  }
+  if (out)
+    out[0] = '\0';
+  state = out || matchingStop ? STRING : SKIP;
+  if (remaining == 0)
+    endField();
+}
+
+// Il campo è finito: chiude i messaggi che finiscono qui
+void GtfsRtDecoder::endField() {
+  if (state == STRING && !out)
+    stopMatched = matchingStop && length == stopIdLength;
+  state = TAG;
+  out = nullptr;
+  while (depth > 1 && pos == stack[depth - 1].end)
+    end(stack[--depth].message);
+}
+
+GtfsRtDecoder::Message GtfsRtDecoder::child(uint32_t f) const {
+  switch (stack[depth - 1].message) {
+  case MSG_FEED:
+    return f == FEED_HEADER   ? MSG_HEADER
+           : f == FEED_ENTITY ? MSG_ENTITY
+                              : MSG_NONE;
+  case MSG_ENTITY:
+    return f == ENTITY_TRIP_UPDATE ? MSG_TRIP_UPDATE : MSG_NONE;
+  case MSG_TRIP_UPDATE:
+    return f == TRIP_UPDATE_TRIP        ? MSG_TRIP
+           : f == TRIP_UPDATE_STOP_TIME ? MSG_STOP_TIME
+           : f == TRIP_UPDATE_VEHICLE   ? MSG_VEHICLE
+                                        : MSG_NONE;
+  case MSG_STOP_TIME:
+    return f == STOP_TIME_ARRIVAL     ? MSG_ARRIVAL
+           : f == STOP_TIME_DEPARTURE ? MSG_DEPARTURE
+                                      : MSG_NONE;
+  default:
+    return MSG_NONE;
+  }
+}
+
+void GtfsRtDecoder::begin(Message message) {
+  switch (message) {
+  case MSG_ENTITY:
+    deleted = false;
+    canceled = false;
+    hasTripDelay = false;
+    tripDelay = 0;
+    tripId[0] = routeId[0] = label[0] = '\0';
+    tripMatched = false;
+    memset(&tripEvent, 0, sizeof(tripEvent));
+    break;
+  case MSG_TRIP_UPDATE:
+    counters.tripUpdates++;
+    break;
+  case MSG_STOP_TIME:
+    counters.stopUpdates++;
+    stopMatched = false;
+    stopSkipped = false;
+    memset(&arrival, 0, sizeof(arrival));
+    memset(&departure, 0, sizeof(departure));
+    break;
+  default:
+    break;
+  }
+}
+
+void GtfsRtDecoder::end(Message message) {
+  if (message == MSG_ENTITY) {
+    counters.entities++;
+    commitTrip();
+    begin(MSG_ENTITY);
+  } else if (message == MSG_STOP_TIME && stopMatched) {
+    counters.matches++;
+    // L'orario di partenza, o quello di arrivo al capolinea
+    const Event &event = departure.hasTime ? departure : arrival;
+    int64_t now = nowUtc ? nowUtc : headerTime;
+    bool upcoming = event.hasTime && event.time >= now - GTFS_RT_PAST_S;
+    // Linee circolari: la prima fermata ancora da fare
+    if (!stopSkipped && upcoming &&
+        (!tripMatched || event.time < tripEvent.time)) {
+      tripMatched = true;
+      tripEvent = event;
+    }
+  }
+}
+
+void GtfsRtDecoder::commitTrip() {
+  if (!tripMatched || canceled || deleted)
+    return;
+  int32_t delay = tripEvent.hasDelay ? tripEvent.delay
+                  : hasTripDelay     ? tripDelay
+                                     : 0;
+  insert(tripEvent.time, tripEvent.time - delay, delay);
+}
+
+// Ordinate per orario previsto: un inserimento tiene le prime N
+void GtfsRtDecoder::insert(int64_t time, int64_t scheduled, int32_t delay) {
+  int n = snap.count;
+  if (n == SNAPSHOT_MAX_DEPARTURES && time >= times[n - 1])
+    return;
+  int at = n < SNAPSHOT_MAX_DEPARTURES ? n : n - 1;
+  while (at > 0 && times[at - 1] > time) {
+    times[at] = times[at - 1];
+    snap.departures[at] = snap.departures[at - 1];
+    at--;
+  }
+  if (n < SNAPSHOT_MAX_DEPARTURES)
+    snap.count++;
+  times[at] = time;
+
+  DepartureRecord &d = snap.departures[at];
+  memset(&d, 0, sizeof(d));
+  snapshotCopyField(d.type, sizeof(d.type), routeId);
+  memcpy(d.destination, "-> ", 3);
+  snapshotCopyField(d.destination + 3, sizeof(d.destination) - 3,
+                    label[0] ? label : tripId);
+  time_t t = (time_t)scheduled;
+  struct tm local;
+  localtime_r(&t, &local);
+  snprintf(d.departureTime, sizeof(d.departureTime), "%02d:%02d",
+           local.tm_hour, local.tm_min);
+  // In minuti, come l'API ("+5")
+  int minutes = (delay + (delay >= 0 ? 30 : -30)) / 60;
+  snprintf(d.delay, sizeof(d.delay), minutes >= 0 ? "+%d" : "%d", minutes);
+}
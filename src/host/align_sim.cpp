@@ -0,0 +1,203 @@
+// =================================================================
+// FETCH ALIGNMENT SIMULATION (host build)
+// Plays a day of the display cycle (clock, weather scroll, header
+// scroll, departures animation) against the real FetchScheduler, with
+// the departures fetch run when it falls due (as before) or lined up
+// by the real FetchAligner (held for the departures gate, connection
+// pre-warmed at the header gate). Reports the data age when the
+// departures are shown (with the DataFreshness histogram), the fetches
+// that froze a scroll or an animation, and how many paid for a new
+// connection.
+//
+//   pio run -e align_sim -t exec
+//   .pio/build/align_sim/program [cold_ms] [warm_ms] [idle_timeout_s]
+// =================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fetch_aligner.h"
+#include "fetch_scheduler.h"
+#include "freshness.h"
+
+static const uint32_t FETCH_INTERVAL_MS = 5 * 60 * 1000;
+static const uint32_t FETCH_JITTER_MS = 30 * 1000;
+static const uint32_t DAY_MS = 24 * 60 * 60 * 1000;
+static const uint64_t DEVICE_ID = 0x24a160c3b2f0ULL;
+// Orologio monotono della simulazione: come esp_timer, mai 0 dopo il boot
+static const int64_t BOOT_US = 1000000;
+
+// Durate delle scene come in main.cpp: 35 ms per pixel di scroll su
+// 64 colonne, 5 treni da 3.75 s con 4 animazioni da 17 passi x 20 ms
+static const uint32_t TIME_SCENE_MS = 10000;
+static const uint32_t HEADER_SCENE_MS = 50 + (64 + 28 * 6) * 35;
+static const uint32_t DEPARTURES_SCENE_MS = 5 * 3750 + 4 * 17 * 20;
+
+enum SceneKind { SCENE_STATIC, SCENE_MOVING };
+
+struct Result {
+  uint32_t fetches;
+  uint32_t cold;      // Con DNS + TCP + TLS da rifare
+  uint32_t frozen;    // Durante uno scroll o un'animazione
+  uint32_t prewarms;
+  uint32_t shown;
+  uint64_t ageSumMs;
+  uint64_t firstAgeSumMs; // Prima volta che un fetch arriva sul pannello
+  uint32_t firstShown;
+  uint32_t maxAgeMs;
+  DataAgeStats freshness;
+};
+
+class Sim {
+public:
+  Sim(bool aligned, uint32_t coldMs, uint32_t warmMs, uint32_t idleMs)
+      : aligned(aligned), coldMs(coldMs), warmMs(warmMs), idleMs(idleMs),
+        scheduler(FETCH_INTERVAL_MS, FETCH_JITTER_MS), rng(12345),
+        connIdleSince(0), connOpen(false), lastDataMs(0), hasData(false),
+        newData(false) {
+    memset(&result, 0, sizeof(result));
+  }
+
+  Result run() {
+    scheduler.begin(0, DEVICE_ID, 1);
+    uint32_t now = 0;
+    while (now < DAY_MS) {
+      now = scene(now, TIME_SCENE_MS, SCENE_STATIC);
+      // Il meteo cambia lunghezza: 20-45 caratteri
+      uint32_t weatherMs = (64 + (20 + random() % 26) * 6) * 35;
+      now = scene(now, weatherMs, SCENE_MOVING);
+      if (aligned &&
+          aligner.dueBeforeDepartures(now, scheduler.nextFetchMs())) {
+        result.prewarms++;
+        now += connect(now);
+      }
+      now = scene(now, HEADER_SCENE_MS, SCENE_MOVING);
+      if (aligned && scheduler.due(now))
+        now += fetch(now);
+      departuresShown(now);
+      now = scene(now, DEPARTURES_SCENE_MS, SCENE_MOVING);
+    }
+    result.freshness = freshness.ageStats();
+    return result;
+  }
+
+private:
+  uint32_t random() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 16;
+  }
+
+  // Una scena, allungata dai fetch che partono mentre è in corso
+  uint32_t scene(uint32_t start, uint32_t duration, SceneKind kind) {
+    uint32_t end = start + duration;
+    for (;;) {
+      uint32_t due = scheduler.nextFetchMs();
+      if ((int32_t)(due - end) >= 0)
+        return end;
+      uint32_t at = (int32_t)(due - start) > 0 ? due : start;
+      if (aligned && aligner.hold(at, due))
+        return end; // Aspetta il cancello delle partenze
+      if (kind == SCENE_MOVING)
+        result.frozen++;
+      uint32_t took = fetch(at);
+      end += took;
+      start = at + took;
+    }
+  }
+
+  uint32_t connect(uint32_t now) {
+    if (connOpen && now - connIdleSince < idleMs)
+      return 0;
+    result.cold++;
+    connOpen = true;
+    connIdleSince = now + coldMs;
+    return coldMs;
+  }
+
+  uint32_t fetch(uint32_t now) {
+    uint32_t took = connect(now) + warmMs;
+    int64_t sentUs = BOOT_US + now * 1000LL;
+    int64_t doneUs = sentUs + took * 1000LL;
+    freshness.onData({sentUs, doneUs, doneUs, 0, 0});
+    result.fetches++;
+    connIdleSince = now + took;
+    FetchHints hints = {};
+    scheduler.onSuccess(now + took, hints);
+    lastDataMs = now + took;
+    hasData = newData = true;
+    return took;
+  }
+
+  void departuresShown(uint32_t now) {
+    aligner.onDeparturesShown(now);
+    freshness.onShown(BOOT_US + now * 1000LL, hasData);
+    freshness.onRendered(BOOT_US + now * 1000LL);
+    if (!hasData)
+      return;
+    uint32_t age = now - lastDataMs;
+    result.shown++;
+    result.ageSumMs += age;
+    if (age > result.maxAgeMs)
+      result.maxAgeMs = age;
+    if (newData) {
+      result.firstShown++;
+      result.firstAgeSumMs += age;
+      newData = false;
+    }
+  }
+
+  bool aligned;
+  uint32_t coldMs;
+  uint32_t warmMs;
+  uint32_t idleMs;
+  FetchScheduler scheduler;
+  FetchAligner aligner;
+  DataFreshness freshness;
+  uint32_t rng;
+  uint32_t connIdleSince;
+  bool connOpen;
+  uint32_t lastDataMs;
+  bool hasData;
+  bool newData;
+  Result result;
+};
+
+static void print(const char *name, const Result &r) {
+  printf("%-10s %7u %6u %7u %9u %10.1f %10.1f %8.1f\n", name, r.fetches,
+         r.cold, r.frozen, r.prewarms,
+         r.firstShown ? r.firstAgeSumMs / 1000.0 / r.firstShown : 0.0,
+         r.shown ? r.ageSumMs / 1000.0 / r.shown : 0.0, r.maxAgeMs / 1000.0);
+}
+
+int main(int argc, char **argv) {
+  uint32_t coldMs = argc > 1 ? strtoul(argv[1], NULL, 10) : 1200;
+  uint32_t warmMs = argc > 2 ? strtoul(argv[2], NULL, 10) : 250;
+  uint32_t idleMs = (argc > 3 ? strtoul(argv[3], NULL, 10) : 60) * 1000;
+
+  printf("Fetch %u ms on a new connection, %u ms on an open one; the "
+         "server drops idle connections after %u s\n",
+         coldMs, warmMs, idleMs / 1000);
+  printf("Cycle: clock %u ms, weather ~%u ms, header %u ms, departures "
+         "%u ms\n\n",
+         TIME_SCENE_MS, (64 + 32 * 6) * 35, HEADER_SCENE_MS,
+         DEPARTURES_SCENE_MS);
+  Result before = Sim(false, coldMs, warmMs, idleMs).run();
+  Result after = Sim(true, coldMs, warmMs, idleMs).run();
+
+  printf("%-10s %7s %6s %7s %9s %10s %10s %8s\n", "", "fetches", "cold",
+         "frozen", "prewarms", "age new s", "age all s", "max s");
+  print("when due", before);
+  print("aligned", after);
+
+  // Età dalla richiesta, come sul tabellone
+  char buf[128];
+  freshnessFormatHistogram(before.freshness, buf, sizeof(buf));
+  printf("\nage at display, when due: %s\n", buf);
+  freshnessFormatHistogram(after.freshness, buf, sizeof(buf));
+  printf("age at display, aligned:  %s\n", buf);
+  if (after.fetches < before.fetches * 9 / 10) {
+    printf("aligned: too few fetches\n");
+    return 1;
+  }
+  return 0;
+}
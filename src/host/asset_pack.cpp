@@ -0,0 +1,132 @@
+// =================================================================
+// ASSET PACKER (host build)
+// Writes the image for the "assets" flash partition (see assets.h)
+// from the fonts and icons the firmware used to compile in, and
+// checks it with the real AssetStore. Every font is stored twice: as
+// is (DMD32) and converted to the packed format ("glyphs/<name>").
+// Extra BDF fonts (TTF: convert with otf2bdf first) are packed as
+// "glyphs/<file name without .bdf>".
+//
+//   .pio/build/asset_pack/program assets.bin [font.bdf ...]
+//   esptool.py write_flash 0x3D0000 assets.bin
+// =================================================================
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "assets.h"
+#include "fonts/Arial14.h"
+#include "fonts/SystemFont5x7.h"
+#include "icons.h"
+#include "packed_font.h"
+
+#define PACKED_FONT_MAX 32768
+
+// I blob restano vivi fino alla scrittura dell'immagine
+static std::vector<std::vector<uint8_t>> blobs;
+static std::vector<std::string> names;
+
+/**
+ * @brief Length of a DMD font: 6-byte header, width table if the font is
+ * proportional, then ceil(height / 8) bytes per glyph column.
+ */
+static size_t dmdFontSize(const uint8_t *font) {
+  bool proportional = font[0] != 0 || font[1] != 0;
+  uint8_t height = font[3];
+  uint8_t count = font[5];
+  size_t columns = 0;
+  for (uint8_t i = 0; i < count; i++)
+    columns += proportional ? font[6 + i] : font[2];
+  return 6 + (proportional ? count : 0) + columns * ((height + 7) / 8);
+}
+
+static bool addPacked(AssetImageBuilder &builder, const std::string &name,
+                      const std::vector<uint8_t> &blob) {
+  PackedFont check;
+  if (blob.empty() || !check.attach(blob.data(), blob.size())) {
+    fprintf(stderr, "%s: conversion failed\n", name.c_str());
+    return false;
+  }
+  blobs.push_back(blob);
+  names.push_back("glyphs/" + name);
+  return builder.add(names.back().c_str(), ASSET_FONT_PACKED,
+                     blobs.back().data(), blobs.back().size());
+}
+
+static std::vector<uint8_t> packDmd(const uint8_t *font) {
+  std::vector<uint8_t> blob(PACKED_FONT_MAX);
+  blob.resize(packedFontFromDmd(font, blob.data(), blob.size()));
+  return blob;
+}
+
+static std::vector<uint8_t> packBdf(const char *path) {
+  std::vector<uint8_t> blob;
+  FILE *in = fopen(path, "rb");
+  if (!in) {
+    perror(path);
+    return blob;
+  }
+  std::string text;
+  char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    text.append(chunk, n);
+  fclose(in);
+  blob.resize(PACKED_FONT_MAX);
+  blob.resize(packedFontFromBdf(text.c_str(), blob.data(), blob.size()));
+  return blob;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <out.bin> [font.bdf ...]\n", argv[0]);
+    return 2;
+  }
+  blobs.reserve(ASSETS_MAX); // I puntatori passati al builder restano validi
+  names.reserve(ASSETS_MAX);
+
+  static AssetImageBuilder builder;
+  builder.add("font/arial14", ASSET_FONT_DMD, Arial_14,
+              dmdFontSize(Arial_14));
+  builder.add("font/system5x7", ASSET_FONT_DMD, System5x7,
+              dmdFontSize(System5x7));
+  builder.addBitmap("icon/train", trainIconBitmap, 16, 16);
+  if (!addPacked(builder, "arial14", packDmd(Arial_14)) ||
+      !addPacked(builder, "system5x7", packDmd(System5x7)))
+    return 1;
+  for (int i = 2; i < argc; i++) {
+    std::string name = argv[i];
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos)
+      name = name.substr(slash + 1);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bdf") == 0)
+      name.resize(name.size() - 4);
+    if (!addPacked(builder, name, packBdf(argv[i])))
+      return 1;
+  }
+
+  std::vector<uint8_t> image(builder.imageSize());
+  size_t length = builder.write(image.data(), image.size());
+
+  // Rilegge l'immagine come farà la scheda
+  AssetStore store;
+  AssetBitmap icon;
+  if (!store.attach(image.data(), length) ||
+      !store.find("font/arial14", ASSET_FONT_DMD) ||
+      !store.find("glyphs/arial14", ASSET_FONT_PACKED) ||
+      !store.bitmap("icon/train", icon)) {
+    fprintf(stderr, "image does not validate\n");
+    return 1;
+  }
+  printf("%u assets, %zu bytes\n", store.count(), length);
+
+  FILE *out = fopen(argv[1], "wb");
+  if (!out || fwrite(image.data(), 1, length, out) != length) {
+    perror(argv[1]);
+    return 1;
+  }
+  fclose(out);
+  return 0;
+}
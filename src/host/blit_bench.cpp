@@ -0,0 +1,170 @@
+// =================================================================
+// BLIT BENCHMARK (host build)
+// Checks the word-parallel blit kernels against a pixel-at-a-time
+// reference (random sprites, positions, modes and wall sizes, edges
+// included) in both layouts, then times glyph, icon and full-screen
+// blits both ways.
+//
+//   .pio/build/blit_bench/program
+// =================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "framebuffer.h"
+
+// Un pixel alla volta, come writePixel() di DMD32
+static void referencePixel(Framebuffer &fb, int x, int y, bool on,
+                           BlitMode mode) {
+  if (x < 0 || x >= fb.width() || y < 0 || y >= fb.height())
+    return;
+  uint32_t &word = fb.row(y)[x >> 5];
+  uint32_t bit = 0x80000000u >> (x & 31);
+  switch (mode) {
+  case BLIT_NORMAL:
+    word = on ? word | bit : word & ~bit;
+    break;
+  case BLIT_INVERSE:
+    word = on ? word & ~bit : word | bit;
+    break;
+  case BLIT_XOR:
+    if (on)
+      word ^= bit;
+    break;
+  case BLIT_OR:
+    if (on)
+      word |= bit;
+    break;
+  case BLIT_NOR:
+    if (on)
+      word &= ~bit;
+    break;
+  }
+}
+
+static bool spriteBit(const Sprite &s, int x, int y) {
+  if (x >= s.width)
+    return false;
+  return (s.rows[y * s.wordsPerRow + x / 32] >> (31 - x % 32)) & 1;
+}
+
+static void referenceBlit(Framebuffer &fb, int x, int y, const Sprite &s,
+                          BlitMode mode, int cellWidth) {
+  if (cellWidth < s.width)
+    cellWidth = s.width;
+  for (int r = 0; r < s.height; r++)
+    for (int c = 0; c < cellWidth; c++)
+      referencePixel(fb, x + c, y + r, spriteBit(s, c, r), mode);
+}
+
+static Sprite randomSprite(std::vector<uint32_t> &rows, int width,
+                           int height) {
+  std::vector<uint8_t> bytes((width + 7) / 8 * height);
+  for (uint8_t &b : bytes)
+    b = rand();
+  rows.resize((width + 31) / 32 * height);
+  return spriteFromBytes(bytes.data(), width, height, rows.data());
+}
+
+static bool verify() {
+  const int walls[][2] = {{1, 1}, {2, 1}, {3, 2}, {8, 4}};
+  for (auto &wall : walls) {
+    int width = 32 * wall[0], height = 16 * wall[1];
+    std::vector<uint32_t> a(width / 32 * height), b(a.size()), c(a.size());
+    Framebuffer fast(a.data(), width, height);
+    Framebuffer slow(b.data(), width, height);
+    Framebuffer scan(c.data(), width, height, FB_SCAN_ORDER);
+    for (int i = 0; i < 20000; i++) {
+      std::vector<uint32_t> rows;
+      Sprite s = randomSprite(rows, 1 + rand() % 70, 1 + rand() % 20);
+      int x = rand() % (width + 80) - 75;
+      int y = rand() % (height + 24) - 22;
+      BlitMode mode = (BlitMode)(rand() % 5);
+      int cell = rand() % 2 ? s.width + rand() % 3 : 0;
+      for (size_t k = 0; k < a.size(); k++)
+        a[k] = b[k] = (uint32_t)rand() * 2654435761u;
+      for (int r = 0; r < height; r++)
+        for (int k = 0; k < width / 32; k++)
+          scan.setWord(r, k, fast.word(r, k));
+      fast.blit(x, y, s, mode, cell);
+      scan.blit(x, y, s, mode, cell);
+      referenceBlit(slow, x, y, s, mode, cell);
+      int fx = rand() % (width + 20) - 10, fy = rand() % height;
+      int fw = rand() % 40, fh = rand() % 10;
+      fast.fillRect(fx, fy, fw, fh, mode);
+      scan.fillRect(fx, fy, fw, fh, mode);
+      for (int r = 0; r < fh; r++)
+        for (int c = 0; c < fw; c++)
+          referencePixel(slow, fx + c, fy + r, true, mode);
+      bool same = true;
+      for (int r = 0; r < height; r++)
+        for (int k = 0; k < width / 32; k++)
+          same = same && scan.word(r, k) == fast.word(r, k);
+      if (a != b || !same) {
+        printf("mismatch%s: wall %dx%d sprite %dx%d at %d,%d mode %d\n",
+               same ? "" : " (scan order)", wall[0], wall[1], s.width,
+               s.height, x, y, mode);
+        return false;
+      }
+    }
+  }
+  printf("kernels match the reference in both layouts\n");
+  return true;
+}
+
+static double nsPerBlit(Framebuffer &fb, const Sprite &s, bool reference,
+                        BlitMode mode, int rounds) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    int x = i % 37 - 3; // Allineamenti diversi, bordi compresi
+    if (reference)
+      referenceBlit(fb, x, 0, s, mode, 0);
+    else
+      fb.blit(x, 0, s, mode);
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / rounds;
+}
+
+int main() {
+  if (!verify())
+    return 1;
+
+  const char *modes[] = {"normal", "inverse", "xor", "or", "nor"};
+  const int walls[][2] = {{2, 1}, {8, 4}};
+  for (auto &wall : walls) {
+    int width = 32 * wall[0], height = 16 * wall[1];
+    std::vector<uint32_t> words(width / 32 * height), scanWords(words.size());
+    Framebuffer fb(words.data(), width, height);
+    Framebuffer scan(scanWords.data(), width, height, FB_SCAN_ORDER);
+    std::vector<uint32_t> glyphRows, iconRows, screenRows;
+    struct {
+      const char *name;
+      Sprite sprite;
+      int rounds;
+    } cases[] = {
+        {"glyph 10x14", randomSprite(glyphRows, 10, 14), 400000},
+        {"icon 16x16", randomSprite(iconRows, 16, 16), 400000},
+        {"screen", randomSprite(screenRows, width, height),
+         4000000 / (width * height / 64)},
+    };
+    printf("\n%dx%d panels (%dx%d px)\n", wall[0], wall[1], width, height);
+    for (auto &c : cases) {
+      for (int m = 0; m < 5; m++) {
+        double fast = nsPerBlit(fb, c.sprite, false, (BlitMode)m, c.rounds);
+        double scanned = nsPerBlit(scan, c.sprite, false, (BlitMode)m,
+                                   c.rounds);
+        double slow = nsPerBlit(fb, c.sprite, true, (BlitMode)m,
+                                c.rounds / 10);
+        printf("  %-12s %-8s %9.1f ns  scan order %9.1f ns  per pixel "
+               "%9.1f ns  x%.1f\n",
+               c.name, modes[m], fast, scanned, slow, slow / fast);
+      }
+    }
+  }
+  return 0;
+}
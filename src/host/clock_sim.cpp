@@ -0,0 +1,118 @@
+// =================================================================
+// CLOCK DRIFT SIMULATION (host build)
+// Feeds the real DisciplinedClock two days of syncs from a crystal
+// with a known frequency error: Date headers every 5 min (truncated
+// to the second, random RTT, the same window as time_source.cpp) or
+// NTP-grade references (a few ms). Reports when the drift estimate is
+// first used, its worst error from then on, and the clock error after
+// a 6 h outage at the end. Exits non-zero if an estimate falls outside
+// its tolerance or never shows up.
+//
+//   pio run -e clock_sim -t exec
+// =================================================================
+#include <math.h>
+#include <stdio.h>
+
+#include "disciplined_clock.h"
+#include "time_source.h"
+
+static const int64_t HOUR_US = 3600LL * 1000000;
+static const int64_t SYNC_EVERY_US = 5LL * 60 * 1000000;
+static const int64_t RUN_US = 48 * HOUR_US;
+static const int64_t OUTAGE_US = 6 * HOUR_US;
+static const int64_t EPOCH_US = 1792224000LL * 1000000; // 17/10/2026
+
+// La stima è usata con un errore standard sotto 5 ppm: due errori
+// standard di scarto sono ancora nella norma
+static const double DATE_TOLERANCE_PPM =
+    2 * CLOCK_DRIFT_MAX_ERROR_PPB / 1000.0;
+
+struct ClockCase {
+  const char *name;
+  double ppm;          // Errore vero del quarzo (+ = locale lento)
+  bool ntp;            // Riferimento preciso invece del Date header
+  double expectPpm;    // Stima attesa (il limite per i quarzi fuori scala)
+  double tolerancePpm; // Scarto ammesso una volta che la stima è usata
+  int64_t reportByUs;  // Entro quando la stima deve comparire
+};
+
+static const ClockCase CASES[] = {
+    {"Date, 0 ppm", 0, false, 0, DATE_TOLERANCE_PPM, 36 * HOUR_US},
+    {"Date, +20 ppm", 20, false, 20, DATE_TOLERANCE_PPM, 36 * HOUR_US},
+    {"Date, -20 ppm", -20, false, -20, DATE_TOLERANCE_PPM, 36 * HOUR_US},
+    {"Date, +40 ppm", 40, false, 40, DATE_TOLERANCE_PPM, 36 * HOUR_US},
+    {"Date, -40 ppm", -40, false, -40, DATE_TOLERANCE_PPM, 36 * HOUR_US},
+    {"Date, +300 ppm", 300, false, 100, 0.01, 36 * HOUR_US},
+    {"NTP, +20 ppm", 20, true, 20, 1, 12 * HOUR_US},
+    {"NTP, -40 ppm", -40, true, -40, 1, 12 * HOUR_US},
+};
+
+static uint32_t rng = 12345;
+static uint32_t random32() {
+  rng = rng * 1103515245u + 12345u;
+  return rng >> 8;
+}
+
+static int64_t trueUtc(const ClockCase &c, int64_t monoUs) {
+  return EPOCH_US + monoUs + (int64_t)llround(monoUs * c.ppm / 1e6);
+}
+
+/**
+ * @return false if the case is out of tolerance.
+ */
+static bool run(const ClockCase &c) {
+  DisciplinedClock clock;
+  int64_t firstUs = -1;
+  double worst = 0;
+  // I fetch non cadono allo stesso punto del secondo: fino a 1 s in più
+  for (int64_t mono = 1000000; mono < RUN_US;
+       mono += SYNC_EVERY_US + random32() % 1000000) {
+    if (c.ntp) {
+      int64_t error = (int64_t)(random32() % 10000) - 5000;
+      clock.sync(mono, trueUtc(c, mono) + error, 5000,
+                 TIME_STEP_THRESHOLD_US);
+    } else {
+      // Come timeSourceFromHttpDate(): centro della finestra e
+      // semi-ampiezza, Date troncato al secondo
+      int64_t rttUs = 50000 + random32() % 300000;
+      int64_t serverSec = trueUtc(c, mono) / 1000000;
+      clock.sync(mono, serverSec * 1000000 + 500000, 500000 + rttUs / 2,
+                 TIME_STEP_THRESHOLD_US);
+    }
+    double estimate = clock.driftPpm();
+    if (estimate == 0 && firstUs < 0)
+      continue;
+    if (firstUs < 0)
+      firstUs = mono;
+    double error = fabs(estimate - c.expectPpm);
+    if (error > worst)
+      worst = error;
+  }
+
+  // Senza sync per 6 ore: la deriva stimata tiene l'ora
+  int64_t end = RUN_US + OUTAGE_US;
+  double outageMs = (clock.utcAt(end) - trueUtc(c, end)) / 1000.0;
+
+  bool ok = worst <= c.tolerancePpm;
+  if (c.reportByUs && (firstUs < 0 || firstUs > c.reportByUs))
+    ok = false;
+  char first[16] = "never";
+  if (firstUs >= 0)
+    snprintf(first, sizeof(first), "%.1f h", (double)firstUs / HOUR_US);
+  printf("%-16s %8s %10.2f %9.2f %12.0f  %s\n", c.name, first,
+         clock.driftPpm(), worst, outageMs, ok ? "ok" : "OUT OF TOLERANCE");
+  return ok;
+}
+
+int main() {
+  printf("Syncs every %d min for %d h, then %d h without; Date header "
+         "+-0.5 s plus RTT/2, NTP +-5 ms\n\n",
+         (int)(SYNC_EVERY_US / 60000000), (int)(RUN_US / HOUR_US),
+         (int)(OUTAGE_US / HOUR_US));
+  printf("%-16s %8s %10s %9s %12s\n", "case", "used at", "final ppm",
+         "worst err", "outage ms");
+  bool ok = true;
+  for (const ClockCase &c : CASES)
+    ok = run(c) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#ifndef HOST_PGMSPACE_H
+#define HOST_PGMSPACE_H
+
+// Host build: lets the DMD font headers compile outside Arduino
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+
+#endif
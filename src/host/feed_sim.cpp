@@ -0,0 +1,171 @@
+// =================================================================
+// DATA FEED SIMULATION (host build)
+// Runs the real DataFeeds (departures every 5 min, weather every hour,
+// station name once per boot) against a fake JSON API on a virtual
+// clock, next to the single 5-minute fetch they replace, and reports
+// requests, weather/station parses and bytes per day. The API sends
+// weather and station in every departures response; the last row is
+// an endpoint that could leave them out. Body sizes default to the
+// json_bench fixture (limit=5 and limit=0); the per-request overhead
+// (request, response headers, TLS records) is an estimate.
+//
+//   pio run -e feed_sim -t exec
+//   .pio/build/feed_sim/program [full_bytes] [meta_bytes] [overhead]
+// =================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "data_feed.h"
+#include "fetch_scheduler.h"
+
+static const uint32_t FETCH_INTERVAL_MS = 5 * 60 * 1000;
+static const uint32_t WEATHER_INTERVAL_MS = 60 * 60 * 1000;
+static const uint32_t FETCH_JITTER_MS = 30 * 1000;
+static const uint32_t DAY_MS = 24 * 60 * 60 * 1000;
+static const uint64_t DEVICE_ID = 0x24a160c3b2f0ULL;
+
+static int64_t simMonoUs() { return 0; }
+
+// Risponde come l'API: tutto con limit=5, meteo e stazione con limit=0
+class SimApi : public DataProvider {
+public:
+  SimApi(size_t fullBytes, size_t metaBytes, bool split)
+      : fullBytes(fullBytes), metaBytes(metaBytes), split(split) {
+    memset(parsed, 0, sizeof(parsed));
+  }
+
+  const char *name() const override { return "sim"; }
+  uint8_t fields() const override { return SNAPSHOT_ALL; }
+
+  FetchResult fetch(Snapshot &snap, uint8_t fields, int64_t (*)(),
+                    void (*)(const uint8_t *, size_t)) override {
+    memset(&snap, 0, sizeof(snap));
+    FetchResult r;
+    memset(&r, 0, sizeof(r));
+    r.status = FETCH_OK;
+    r.code = 200;
+    r.bodyBytes = fields & SNAPSHOT_DEPARTURES ? fullBytes : metaBytes;
+    // Solo le partenze: "{" + l'array + "}"
+    if (split && fields == SNAPSHOT_DEPARTURES)
+      r.bodyBytes = fullBytes - metaBytes + 2;
+    if (fields & SNAPSHOT_DEPARTURES) {
+      snap.count = 5;
+      parsed[0]++;
+    }
+    if (fields & SNAPSHOT_WEATHER) {
+      snapshotCopyField(snap.weather, sizeof(snap.weather), "18C - Sereno");
+      parsed[1]++;
+    }
+    if (fields & SNAPSHOT_STATION) {
+      snapshotCopyField(snap.stationName, sizeof(snap.stationName),
+                        "Castelfranco Emilia");
+      parsed[2]++;
+    }
+    return r;
+  }
+
+  size_t fullBytes;
+  size_t metaBytes;
+  bool split;
+  uint32_t parsed[3]; // Partenze, meteo, stazione estratti dal body
+};
+
+struct Day {
+  uint32_t requests;
+  uint64_t bodyBytes;
+  uint32_t parsed[3];
+};
+
+// Prima: un solo FetchScheduler, ogni richiesta porta (e parsa) tutto
+static Day runSingle(size_t fullBytes) {
+  FetchScheduler scheduler(FETCH_INTERVAL_MS, FETCH_JITTER_MS);
+  scheduler.begin(0, DEVICE_ID, 1);
+  Day day = {};
+  for (uint32_t now = 0; now < DAY_MS; now = scheduler.nextFetchMs()) {
+    if (!scheduler.due(now))
+      continue;
+    FetchHints hints = {};
+    scheduler.onSuccess(now, hints);
+    day.requests++;
+    day.bodyBytes += fullBytes;
+    for (int i = 0; i < 3; i++)
+      day.parsed[i]++;
+  }
+  return day;
+}
+
+// Dopo: tre feed con TTL propri sullo stesso provider
+static Day runFeeds(size_t fullBytes, size_t metaBytes, bool split) {
+  SimApi api(fullBytes, metaBytes, split);
+  DataFeed departures("departures", api, SNAPSHOT_DEPARTURES,
+                      FETCH_INTERVAL_MS, FETCH_JITTER_MS);
+  DataFeed weather("weather", api, SNAPSHOT_WEATHER, WEATHER_INTERVAL_MS,
+                   FETCH_JITTER_MS);
+  DataFeed station("station", api, SNAPSHOT_STATION, DATA_FEED_ONCE,
+                   FETCH_JITTER_MS);
+  DataFeeds feeds;
+  feeds.add(departures);
+  feeds.add(weather);
+  feeds.add(station);
+  feeds.begin(0, DEVICE_ID, 1);
+
+  static Snapshot snap;
+  for (uint32_t now = 0; now < DAY_MS; now = feeds.nextFetchMs(now)) {
+    while (feeds.due(now)) {
+      uint8_t refreshed;
+      FetchResult r = feeds.fetch(now, snap, refreshed, simMonoUs, nullptr);
+      if (r.status != FETCH_OK || !refreshed) {
+        printf("feeds: request at %u ms refreshed nothing\n", now);
+        exit(1);
+      }
+    }
+  }
+  feeds.merge(snap);
+  if (snap.count != 5 || !snap.weather[0] || !snap.stationName[0]) {
+    printf("feeds: merged snapshot incomplete\n");
+    exit(1);
+  }
+  for (size_t i = 0; i < feeds.size() && !split; i++) {
+    const DataFeed &f = feeds.feed(i);
+    printf("  %-10s %4u refreshes, last at %5.1f h\n", f.name(),
+           f.refreshes(), f.refreshedMs() / 3600000.0);
+  }
+  Day day = {feeds.requests(), feeds.bodyBytes(), {}};
+  memcpy(day.parsed, api.parsed, sizeof(day.parsed));
+  return day;
+}
+
+static void printDay(const char *name, const Day &day, size_t overhead) {
+  printf("%-22s %5u %8.1f %10.1f %6u %6u %6u\n", name, day.requests,
+         day.bodyBytes / 1024.0,
+         (day.bodyBytes + (uint64_t)day.requests * overhead) / 1024.0,
+         day.parsed[0], day.parsed[1], day.parsed[2]);
+}
+
+int main(int argc, char **argv) {
+  size_t fullBytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 1326;
+  size_t metaBytes = argc > 2 ? strtoul(argv[2], NULL, 10) : 178;
+  size_t overhead = argc > 3 ? strtoul(argv[3], NULL, 10) : 600;
+
+  printf("Body %zu B (limit=5), %zu B (limit=0), +%zu B per request\n\n",
+         fullBytes, metaBytes, overhead);
+  Day before = runSingle(fullBytes);
+  printf("feeds over 24 h:\n");
+  Day after = runFeeds(fullBytes, metaBytes, false);
+  Day split = runFeeds(fullBytes, metaBytes, true);
+
+  printf("\n%-22s %5s %8s %10s %6s %6s %6s\n", "per day", "req", "body KB",
+         "+overhead", "dep", "wthr", "stat");
+  printDay("single 5 min fetch", before, overhead);
+  printDay("feeds 5 min/1 h/boot", after, overhead);
+  printDay("feeds, split endpoint", split, overhead);
+  printf("\nweather parsed %ux less often, station name once; body bytes "
+         "%+.1f%% (%+.1f%% with a departures-only endpoint)\n",
+         before.parsed[1] / (after.parsed[1] ? after.parsed[1] : 1),
+         100.0 * ((double)after.bodyBytes - before.bodyBytes) /
+             before.bodyBytes,
+         100.0 * ((double)split.bodyBytes - before.bodyBytes) /
+             before.bodyBytes);
+  return 0;
+}
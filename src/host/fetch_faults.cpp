@@ -0,0 +1,432 @@
+// =================================================================
+// FETCH FAULT INJECTION (host build)
+// Runs the real httpFetch() against a fake transport that misbehaves
+// in one way per case (slow drip, stalls, resets, truncated bodies,
+// error codes...) on a virtual clock, and reports how long each case
+// blocks the loop (i.e. freezes the display) and when the scheduler
+// retries. A second table feeds scripted server responses (chunked,
+// split at odd boundaries, oversized headers, keep-alive, a pre-warmed
+// connection) through the LeanHttpTransport framing code. A third one
+// plays servers that send their TLS handshake records slowly against
+// the connect budget (tlsHandshakeWithin()).
+//
+//   pio run -e fetch_faults -t exec
+// =================================================================
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "fetch_scheduler.h"
+#include "http_fetch.h"
+#include "lean_http.h"
+#include "tls_socket.h"
+
+static int64_t virtualUs = 0;
+static int64_t virtualMonoUs() { return virtualUs; }
+static void advanceMs(uint32_t ms) { virtualUs += (int64_t)ms * 1000; }
+
+// Dopo i byte previsti la connessione...
+enum AfterBody {
+  BODY_END,   // ...si chiude normalmente
+  BODY_STALL, // ...resta aperta senza mandare nulla
+  BODY_RESET, // ...riceve un RST
+  BODY_CLOSE  // ...si chiude prima di Content-Length
+};
+
+struct FaultCase {
+  const char *name;
+  int status;            // Stato HTTP, o codice HTTP_TRANSPORT_*
+  uint32_t headersMs;    // Attesa per la risposta (0 = normale)
+  size_t bodyLimit;      // Byte del corpo inviati prima del guasto
+  AfterBody after;
+  uint32_t chunkBytes;   // Dimensione di ogni segmento del corpo
+  uint32_t chunkEveryMs; // Intervallo tra i segmenti
+  const char *body;      // nullptr = fixture JSON
+  const char *retryAfter;
+};
+
+static const size_t ALL = (size_t)-1;
+
+static const FaultCase CASES[] = {
+    {"ok", 200, 300, ALL, BODY_END, 1460, 20, nullptr, ""},
+    {"ok, slow link", 200, 1200, ALL, BODY_END, 256, 400, nullptr, ""},
+    {"bad url / dns", HTTP_TRANSPORT_BAD_URL, 0, ALL, BODY_END, 0, 0,
+     nullptr, ""},
+    {"refused", HTTP_TRANSPORT_REFUSED, 30, ALL, BODY_END, 0, 0, nullptr,
+     ""},
+    {"connect timeout", HTTP_TRANSPORT_TIMEOUT, FETCH_READ_TIMEOUT_MS, ALL,
+     BODY_END, 0, 0, nullptr, ""},
+    {"503 + Retry-After", 503, 150, ALL, BODY_END, 1460, 20,
+     "{\"error\":\"busy\"}", "120"},
+    {"500", 500, 150, ALL, BODY_END, 1460, 20, "Internal Server Error", ""},
+    {"200 html page", 200, 300, ALL, BODY_END, 1460, 20,
+     "<html><body>Captive portal</body></html>", ""},
+    {"stall after headers", 200, 300, 0, BODY_STALL, 1460, 20, nullptr, ""},
+    {"stall mid-body", 200, 300, 700, BODY_STALL, 1460, 20, nullptr, ""},
+    {"reset mid-body", 200, 300, 700, BODY_RESET, 1460, 20, nullptr, ""},
+    {"truncated body", 200, 300, 700, BODY_CLOSE, 1460, 20, nullptr, ""},
+    {"drip 1 B / 100 ms", 200, 300, ALL, BODY_END, 1, 100, nullptr, ""},
+    {"drip 64 B / 1 s", 200, 300, ALL, BODY_END, 64, 1000, nullptr, ""},
+    {"drip 64 B / 14 s", 200, 300, ALL, BODY_END, 64, 14000, nullptr, ""},
+    {"drip 64 B / 16 s", 200, 300, ALL, BODY_END, 64, 16000, nullptr, ""},
+};
+
+/**
+ * @brief Fake transport driven by a FaultCase; every wait moves the
+ * virtual clock instead of sleeping.
+ */
+class FaultTransport : public HttpTransport {
+public:
+  FaultTransport(const FaultCase &c, const std::string &fixture)
+      : fault(c), body(c.body ? c.body : fixture), pos(0) {}
+
+  int get(const char *url, const char *const *headerKeys, size_t count,
+          uint32_t timeoutMs) override {
+    (void)url;
+    keys = headerKeys;
+    keyCount = count;
+    advanceMs(fault.headersMs < timeoutMs ? fault.headersMs : timeoutMs);
+    return fault.status;
+  }
+
+  const char *header(size_t index) override {
+    if (index >= keyCount || fault.status <= 0)
+      return "";
+    if (strcmp(keys[index], "Date") == 0)
+      return "Sat, 17 Oct 2026 08:00:00 GMT";
+    if (strcmp(keys[index], "Retry-After") == 0)
+      return fault.retryAfter;
+    return "";
+  }
+
+  int read(uint8_t *buf, size_t size, uint32_t timeoutMs) override {
+    size_t limit = fault.bodyLimit < body.size() ? fault.bodyLimit
+                                                 : body.size();
+    if (pos >= limit) {
+      switch (fault.after) {
+      case BODY_END:
+        return 0;
+      case BODY_STALL:
+        advanceMs(timeoutMs);
+        return HTTP_TRANSPORT_TIMEOUT;
+      case BODY_RESET:
+        return HTTP_TRANSPORT_CONNECTION_LOST;
+      case BODY_CLOSE:
+        return HTTP_TRANSPORT_TRUNCATED;
+      }
+    }
+    if (fault.chunkEveryMs > timeoutMs) {
+      advanceMs(timeoutMs);
+      return HTTP_TRANSPORT_TIMEOUT;
+    }
+    advanceMs(fault.chunkEveryMs);
+    size_t n = fault.chunkBytes;
+    if (n > size)
+      n = size;
+    if (n > limit - pos)
+      n = limit - pos;
+    memcpy(buf, body.data() + pos, n);
+    pos += n;
+    return (int)n;
+  }
+
+  void end() override {}
+
+private:
+  const FaultCase &fault;
+  std::string body;
+  size_t pos;
+  const char *const *keys = nullptr;
+  size_t keyCount = 0;
+};
+
+/**
+ * @brief Stand-in for deserializeJson(): consumes one JSON object and
+ * checks its structure, stopping at the closing brace like ArduinoJson.
+ */
+static bool parseJsonShape(BodyReader &body, void *context) {
+  (void)context;
+  int c;
+  while ((c = body.read()) == ' ' || c == '\n' || c == '\r' || c == '\t')
+    ;
+  if (c != '{')
+    return false;
+  int depth = 1;
+  bool inString = false;
+  while (depth > 0) {
+    c = body.read();
+    if (c < 0)
+      return false; // IncompleteInput
+    if (inString) {
+      if (c == '\\')
+        body.read();
+      else if (c == '"')
+        inString = false;
+    } else if (c == '"') {
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      depth++;
+    } else if (c == '}' || c == ']') {
+      depth--;
+    }
+  }
+  return true;
+}
+
+static std::string makeFixture() {
+  std::string json = "{\"stationName\":\"Castelfranco Emilia\","
+                     "\"weather\":{\"temperature\":\"18^C\","
+                     "\"description\":\"Sereno\"},\"departures\":[";
+  for (int i = 0; i < 5; i++) {
+    char train[256];
+    snprintf(train, sizeof(train),
+             "%s{\"type\":\"REG\",\"number\":\"%d\","
+             "\"destination\":\"Bologna Centrale\","
+             "\"departureTime\":\"08:%02d\",\"delay\":\"+%d\","
+             "\"platform\":\"%d\",\"stops\":[\"Anzola\",\"Samoggia\","
+             "\"Bologna Borgo Panigale\"]}",
+             i ? "," : "", 17400 + i, 10 + i * 12, i, 1 + i % 3);
+    json += train;
+  }
+  json += "]}";
+  return json;
+}
+
+// =================================================================
+// Lean client framing
+// =================================================================
+
+/**
+ * @brief Server side of a socket: each request written releases the next
+ * scripted response, delivered in segments of segmentBytes.
+ */
+class ScriptSocket : public HttpSocket {
+public:
+  ScriptSocket(const std::string *responses, size_t count, size_t segment,
+               bool closeAfter)
+      : responses(responses), count(count), next(0), segment(segment),
+        closeAfter(closeAfter), isOpen(false) {}
+
+  bool connect(const char *, uint16_t, uint32_t) override {
+    advanceMs(200);
+    isOpen = true;
+    pending.clear();
+    return true;
+  }
+  bool connected() override { return isOpen; }
+  int write(const uint8_t *, size_t length) override {
+    if (next < count)
+      pending += responses[next++];
+    return (int)length;
+  }
+  int read(uint8_t *buf, size_t size, uint32_t timeoutMs) override {
+    if (pending.empty()) {
+      if (closeAfter && next == count) {
+        isOpen = false;
+        return 0;
+      }
+      advanceMs(timeoutMs);
+      return HTTP_TRANSPORT_TIMEOUT;
+    }
+    advanceMs(5);
+    size_t n = pending.size() < segment ? pending.size() : segment;
+    if (n > size)
+      n = size;
+    memcpy(buf, pending.data(), n);
+    pending.erase(0, n);
+    return (int)n;
+  }
+  void stop() override { isOpen = false; }
+
+private:
+  const std::string *responses;
+  size_t count;
+  size_t next;
+  size_t segment;
+  bool closeAfter;
+  bool isOpen;
+  std::string pending;
+};
+
+static std::string chunked(const std::string &body, size_t chunkSize) {
+  std::string out;
+  for (size_t i = 0; i < body.size(); i += chunkSize) {
+    size_t n = body.size() - i < chunkSize ? body.size() - i : chunkSize;
+    char size[32];
+    snprintf(size, sizeof(size), "%zx;ext=1\r\n", n);
+    out += size + body.substr(i, n) + "\r\n";
+  }
+  return out + "0\r\nX-Trailer: 1\r\n\r\n";
+}
+
+static void runLeanFraming(const std::string &fixture) {
+  std::string length = "HTTP/1.1 200 OK\r\nContent-Type: application/json"
+                       "\r\nDate: Sat, 17 Oct 2026 08:00:00 GMT\r\n"
+                       "Content-Length: " +
+                       std::to_string(fixture.size()) + "\r\n\r\n" +
+                       fixture;
+  std::string chunkedResponse =
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n"
+      "Cache-Control: max-age=240\r\n\r\n" +
+      chunked(fixture, 100);
+  std::string longHeader = "HTTP/1.1 200 OK\r\nSet-Cookie: " +
+                           std::string(1500, 'c') + "\r\nContent-Length: " +
+                           std::to_string(fixture.size()) + "\r\n\r\n" +
+                           fixture;
+  std::string http10 = "HTTP/1.0 200 OK\r\n\r\n" + fixture;
+  std::string cut = chunkedResponse.substr(0, chunkedResponse.size() / 2);
+  std::string busy = "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 90"
+                     "\r\nContent-Length: 4\r\n\r\nbusy";
+
+  struct LeanCase {
+    const char *name;
+    const std::string *responses;
+    size_t count;
+    size_t segment;
+    bool closeAfter;
+    bool prewarm; // Connessione aperta prima, come al cancello del tabellone
+  };
+  std::string twice[] = {length, chunkedResponse};
+  std::string afterError[] = {busy, length};
+  const LeanCase cases[] = {
+      {"content-length", &length, 1, 1460, false, false},
+      {"chunked", &chunkedResponse, 1, 1460, false, false},
+      {"chunked, 1 B segments", &chunkedResponse, 1, 1, false, false},
+      {"chunked, 7 B segments", &chunkedResponse, 1, 7, false, false},
+      {"1.5 KB header line", &longHeader, 1, 1460, false, false},
+      {"HTTP/1.0, close", &http10, 1, 1460, true, false},
+      {"chunked, cut + close", &cut, 1, 1460, true, false},
+      {"keep-alive x2", twice, 2, 1460, false, false},
+      {"503 then 200", afterError, 2, 1460, false, false},
+      {"pre-warmed", &length, 1, 1460, false, true},
+  };
+
+  printf("\nLean HTTP client framing\n");
+  printf("%-22s | %-12s %5s %6s %6s | %8s\n", "case", "status", "code",
+         "bytes", "ms", "connects");
+  for (const LeanCase &c : cases) {
+    ScriptSocket socket(c.responses, c.count, c.segment, c.closeAfter);
+    LeanHttpTransport transport(socket);
+    if (c.prewarm &&
+        !transport.prewarm("https://api.example/departures", 5000))
+      printf("%s: pre-warm failed\n", c.name);
+    for (size_t i = 0; i < c.count; i++) {
+      virtualUs = 1000000;
+      FetchResult r = httpFetch(transport, "https://api.example/departures",
+                                parseJsonShape, nullptr, virtualMonoUs);
+      printf("%-22s | %-12s %5d %6u %6lld | %8u\n", i ? "" : c.name,
+             fetchStatusName(r.status), r.code, (unsigned)r.bodyBytes,
+             (long long)(r.doneUs - r.sentUs) / 1000,
+             transport.connectCount());
+    }
+  }
+}
+
+// =================================================================
+// TLS handshake budget
+// =================================================================
+
+static const int SSL_TIMEOUT = -0x6800; // MBEDTLS_ERR_SSL_TIMEOUT
+
+struct SlowHandshake {
+  uint32_t records; // Record del server ancora da mandare
+  uint32_t everyMs; // Attesa prima di ognuno
+};
+
+static uint32_t virtualMs() { return (uint32_t)(virtualUs / 1000); }
+
+// Un passo: aspetta il prossimo record, al più leftMs
+static int slowHandshakeStep(void *arg, uint32_t leftMs) {
+  SlowHandshake &h = *(SlowHandshake *)arg;
+  if (h.everyMs > leftMs) {
+    advanceMs(leftMs);
+    return SSL_TIMEOUT;
+  }
+  advanceMs(h.everyMs);
+  return --h.records ? 1 : 0;
+}
+
+/**
+ * @return false if the bounded handshake blocked past the timeout.
+ */
+static bool runSlowHandshakes() {
+  struct HandshakeCase {
+    const char *name;
+    SlowHandshake server;
+  };
+  const HandshakeCase cases[] = {
+      {"fast server", {4, 60}},
+      {"record every 2 s", {4, 2000}},
+      {"record every 7.9 s", {4, 7900}},
+      {"silent server", {1, 60000}},
+  };
+  const uint32_t connectMs = 200; // DNS e SYN, già dentro il budget
+  const uint32_t timeoutMs = FETCH_READ_TIMEOUT_MS;
+  bool ok = true;
+
+  printf("\nTLS handshake, %u ms connect timeout\n", timeoutMs);
+  printf("%-20s | %-8s %9s | %-8s %9s\n", "case", "per read", "ms",
+         "budget", "ms");
+  for (const HandshakeCase &c : cases) {
+    // Prima: ogni lettura ripartiva con il timeout intero
+    SlowHandshake server = c.server;
+    virtualUs = 0;
+    advanceMs(connectMs);
+    int ret;
+    while ((ret = slowHandshakeStep(&server, timeoutMs)) > 0) {
+    }
+    uint32_t perReadMs = virtualMs();
+    bool perReadOk = ret == 0;
+
+    server = c.server;
+    virtualUs = 0;
+    advanceMs(connectMs);
+    ret = tlsHandshakeWithin(0, timeoutMs, virtualMs, slowHandshakeStep,
+                             &server, SSL_TIMEOUT);
+    uint32_t budgetMs = virtualMs();
+    printf("%-20s | %-8s %9u | %-8s %9u\n", c.name,
+           perReadOk ? "ok" : "timeout", perReadMs,
+           ret == 0 ? "ok" : "timeout", budgetMs);
+    if (budgetMs > timeoutMs) {
+      printf("%s: handshake blocked past the timeout\n", c.name);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int main() {
+  std::string fixture = makeFixture();
+  printf("Fetch fault injection: read timeout %u ms, fetch deadline %u ms, "
+         "fixture %u bytes\n\n",
+         FETCH_READ_TIMEOUT_MS, FETCH_DEADLINE_MS, (unsigned)fixture.size());
+  printf("%-20s | %-14s %5s %6s | %10s | %9s\n", "case", "status", "code",
+         "bytes", "blocked ms", "retry (s)");
+
+  for (const FaultCase &c : CASES) {
+    virtualUs = 1000000;
+    FaultTransport transport(c, fixture);
+    FetchResult r = httpFetch(transport, "https://api.example/departures",
+                              parseJsonShape, nullptr, virtualMonoUs);
+
+    // Quando riproverebbe lo scheduler vero, partendo da zero errori
+    FetchScheduler scheduler(5 * 60 * 1000, 30 * 1000);
+    scheduler.begin(0, 0x240ac4000000ULL, 1);
+    uint32_t now = (uint32_t)(r.doneUs / 1000);
+    if (r.status == FETCH_OK)
+      scheduler.onSuccess(now, r.hints);
+    else
+      scheduler.onFailure(now, r.hints);
+
+    printf("%-20s | %-14s %5d %6u | %10lld | %9u\n", c.name,
+           fetchStatusName(r.status), r.code, (unsigned)r.bodyBytes,
+           (long long)(r.doneUs - r.sentUs) / 1000,
+           (scheduler.nextFetchMs() - now) / 1000);
+  }
+  printf("\nblocked = loop (and display animation) frozen inside "
+         "fetchData(); on failure the\nold departures stay on screen with "
+         "an error in place of the weather until the retry.\n");
+
+  runLeanFraming(fixture);
+  return runSlowHandshakes() ? 0 : 1;
+}
@@ -0,0 +1,339 @@
+// =================================================================
+// FLEET vs MOCK API (host build)
+// Runs N copies of the board's fetch loop (real FetchScheduler, the
+// Wi-Fi reconnect backoff from connectivity.h, the read timeout of
+// httpFetch) in accelerated virtual time against a mock departures
+// endpoint, and injects one fault per scenario:
+//
+//   baseline  1% connection resets, log-normal latency (median 300 ms)
+//   503       10 min of 503 + Retry-After: 60
+//   500       10 min of 500 without hints
+//   slow      10 min of 30x latency (most requests hit the timeout)
+//   refused   10 min of connection refused (API host down)
+//   wifi      10 min without Wi-Fi for every board (AP reboot)
+//
+// The mock also sheds load above its capacity with 503 + Retry-After,
+// so retry storms show up as overload responses.
+//
+//   pio run -e fleet_mock -t exec
+//   .pio/build/fleet_mock/program [boards] [hours] [capacity req/s]
+// =================================================================
+#include <algorithm>
+#include <math.h>
+#include <queue>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "connectivity.h"
+#include "fetch_scheduler.h"
+#include "http_fetch.h"
+
+static const uint32_t FETCH_INTERVAL_MS = 5 * 60 * 1000;
+static const uint32_t FETCH_JITTER_MS = 30 * 1000;
+static const uint32_t HTTP_TIMEOUT_MS = FETCH_READ_TIMEOUT_MS;
+static const uint32_t BOOT_SKEW_MS = 2000;
+static const uint32_t DHCP_MS = 1500;
+
+static const uint32_t FAULT_START_MS = 60 * 60 * 1000;
+static const uint32_t FAULT_LENGTH_MS = 10 * 60 * 1000;
+static const uint32_t STALENESS_SAMPLE_MS = 10000;
+// Finestra in cui si cercano le tempeste di retry dopo il guasto
+static const uint32_t STORM_WINDOW_MS = 10 * 60 * 1000;
+
+static const double LATENCY_MEDIAN_MS = 300;
+static const double LATENCY_SIGMA = 0.6; // p99 ~ 1.2 s
+static const double RESET_RATE = 0.01;
+
+enum FaultKind {
+  FAULT_NONE,
+  FAULT_503,
+  FAULT_500,
+  FAULT_SLOW,
+  FAULT_REFUSED,
+  FAULT_WIFI
+};
+
+static const char *faultName(FaultKind kind) {
+  static const char *names[] = {"baseline", "503",     "500",
+                                "slow",     "refused", "wifi"};
+  return names[kind];
+}
+
+// =================================================================
+// Mock API
+// =================================================================
+struct Response {
+  int code;          // < 0: errore di trasporto, come HTTPClient
+  uint32_t doneMs;   // Istante in cui fetchData() ritorna
+  uint32_t retryAfterS;
+};
+
+class MockApi {
+public:
+  MockApi(FaultKind fault, uint32_t capacity, std::mt19937 &rng)
+      : fault(fault), capacity(capacity), rng(rng), second(0),
+        servedThisSecond(0), shed(0), requests(0) {}
+
+  Response handle(uint32_t nowMs) {
+    requests++;
+    bool inFault = faultActive(nowMs);
+    std::lognormal_distribution<double> latency(log(LATENCY_MEDIAN_MS),
+                                                LATENCY_SIGMA);
+    double ms = latency(rng);
+
+    if (inFault && fault == FAULT_REFUSED)
+      return {-1, nowMs + 200, 0};
+
+    // Capacità del server: oltre la soglia risponde 503 senza lavorare
+    if (nowMs / 1000 != second) {
+      second = nowMs / 1000;
+      servedThisSecond = 0;
+    }
+    if (++servedThisSecond > capacity) {
+      shed++;
+      return {503, nowMs + 50, 30};
+    }
+
+    if (inFault && fault == FAULT_SLOW)
+      ms *= 30;
+    if (ms > HTTP_TIMEOUT_MS)
+      return {-11, nowMs + HTTP_TIMEOUT_MS, 0}; // HTTPC_ERROR_READ_TIMEOUT
+
+    uint32_t done = nowMs + (uint32_t)ms;
+    if (inFault && fault == FAULT_503)
+      return {503, done, 60};
+    if (inFault && fault == FAULT_500)
+      return {500, done, 0};
+    if (std::uniform_real_distribution<double>(0, 1)(rng) < RESET_RATE)
+      return {-1, done, 0};
+    return {200, done, 0};
+  }
+
+  bool faultActive(uint32_t nowMs) const {
+    return fault != FAULT_NONE && nowMs >= FAULT_START_MS &&
+           nowMs < FAULT_START_MS + FAULT_LENGTH_MS;
+  }
+
+  uint32_t shedCount() const { return shed; }
+  uint32_t requestCount() const { return requests; }
+
+private:
+  FaultKind fault;
+  uint32_t capacity;
+  std::mt19937 &rng;
+  uint32_t second;
+  uint32_t servedThisSecond;
+  uint32_t shed;
+  uint32_t requests;
+};
+
+// =================================================================
+// Board: lo stesso giro di loop() ridotto al percorso dei fetch
+// =================================================================
+struct Board {
+  FetchScheduler scheduler;
+  uint32_t bootMs;
+  uint32_t lastFreshMs; // Ultimo 200, o il boot se non ancora arrivato
+  bool inFlight;
+  uint32_t issuedMs;
+  Response pending;
+  uint32_t recoveredMs; // Primo 200 dopo la fine del guasto, 0 = mai
+
+  Board() : scheduler(FETCH_INTERVAL_MS, FETCH_JITTER_MS) {}
+};
+
+/**
+ * @brief When the board gets its IP back after an AP outage, following
+ * the reconnect backoff of connectivity.cpp.
+ */
+static uint32_t wifiBackAtMs(uint32_t skewMs) {
+  uint32_t t = FAULT_START_MS + skewMs;
+  uint32_t backoff = CONN_BACKOFF_MIN_MS;
+  uint32_t end = FAULT_START_MS + FAULT_LENGTH_MS;
+  while (t < end) {
+    t += backoff;
+    backoff = backoff * 2 > CONN_BACKOFF_MAX_MS ? CONN_BACKOFF_MAX_MS
+                                                : backoff * 2;
+  }
+  return t + DHCP_MS;
+}
+
+struct Report {
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t shed;
+  double meanPerSecond;
+  uint32_t peakPerSecond;
+  double amplification; // Richieste nel guasto+finestra / attese
+  double recover95S;
+  double recover100S;
+  uint32_t staleP50S, staleP90S, staleP99S, staleMaxS;
+};
+
+static uint32_t percentile(std::vector<uint32_t> &v, double p) {
+  if (v.empty())
+    return 0;
+  size_t k = (size_t)(p * (v.size() - 1));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+static Report simulate(int boards, uint32_t durationMs, FaultKind fault,
+                       uint32_t capacity, uint32_t seed) {
+  std::mt19937 rng(seed);
+  MockApi api(fault, capacity, rng);
+  std::vector<Board> fleet(boards);
+
+  typedef std::pair<uint32_t, int> Event; // (istante, scheda)
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+  std::uniform_int_distribution<uint32_t> skew(0, BOOT_SKEW_MS);
+  uint64_t baseMac = 0x240ac4000000ULL;
+  for (int b = 0; b < boards; b++) {
+    Board &board = fleet[b];
+    board.bootMs = skew(rng);
+    board.lastFreshMs = board.bootMs;
+    board.inFlight = false;
+    board.recoveredMs = 0;
+    board.scheduler.begin(board.bootMs, baseMac + b, rng());
+    events.push(Event(board.scheduler.nextFetchMs(), b));
+  }
+
+  std::vector<uint32_t> perSecond(durationMs / 1000 + 1, 0);
+  std::vector<uint32_t> staleness;
+  staleness.reserve((size_t)boards * (durationMs / STALENESS_SAMPLE_MS));
+  uint32_t nextSample = STALENESS_SAMPLE_MS;
+  uint32_t failures = 0;
+  uint32_t faultEnd = FAULT_START_MS + FAULT_LENGTH_MS;
+
+  while (!events.empty()) {
+    Event e = events.top();
+    events.pop();
+    uint32_t now = e.first;
+    if (now >= durationMs)
+      continue;
+
+    while (nextSample <= now) {
+      for (const Board &board : fleet)
+        staleness.push_back((nextSample - board.lastFreshMs) / 1000);
+      nextSample += STALENESS_SAMPLE_MS;
+    }
+
+    Board &board = fleet[e.second];
+    bool wifiDown = fault == FAULT_WIFI && now >= FAULT_START_MS &&
+                    now < faultEnd;
+
+    if (board.inFlight) {
+      // fetchData() è tornata: stesso ramo di loop()
+      board.inFlight = false;
+      Response &r = board.pending;
+      // L'AP sparisce a metà richiesta: la connessione cade
+      bool linkLost = fault == FAULT_WIFI && board.issuedMs < FAULT_START_MS &&
+                      now >= FAULT_START_MS;
+      FetchHints hints = {};
+      hints.retryAfterS = r.retryAfterS;
+      if (r.code == 200 && !linkLost) {
+        board.lastFreshMs = now;
+        if (fault != FAULT_NONE && now >= faultEnd && !board.recoveredMs)
+          board.recoveredMs = now;
+        board.scheduler.onSuccess(now, hints);
+      } else {
+        failures++;
+        board.scheduler.onFailure(now, hints);
+      }
+      events.push(Event(board.scheduler.nextFetchMs(), e.second));
+      continue;
+    }
+
+    if (wifiDown) {
+      // Il fetch resta in attesa e parte appena torna l'IP
+      events.push(Event(wifiBackAtMs(skew(rng)), e.second));
+      continue;
+    }
+    if (!board.scheduler.due(now)) {
+      events.push(Event(board.scheduler.nextFetchMs(), e.second));
+      continue;
+    }
+
+    perSecond[now / 1000]++;
+    board.issuedMs = now;
+    board.pending = api.handle(now);
+    board.inFlight = true;
+    events.push(Event(board.pending.doneMs, e.second));
+  }
+
+  Report r = {};
+  r.requests = api.requestCount();
+  r.failures = failures;
+  r.shed = api.shedCount();
+  r.meanPerSecond = r.requests / (durationMs / 1000.0);
+  r.peakPerSecond = *std::max_element(perSecond.begin(), perSecond.end());
+
+  uint32_t windowEnd = faultEnd + STORM_WINDOW_MS;
+  uint32_t inWindow = 0;
+  for (uint32_t s = FAULT_START_MS / 1000;
+       s < windowEnd / 1000 && s < perSecond.size(); s++)
+    inWindow += perSecond[s];
+  double expected =
+      (double)boards * (windowEnd - FAULT_START_MS) / FETCH_INTERVAL_MS;
+  r.amplification = inWindow / expected;
+
+  if (fault != FAULT_NONE) {
+    std::vector<uint32_t> recover;
+    for (const Board &board : fleet)
+      recover.push_back(board.recoveredMs ? board.recoveredMs - faultEnd
+                                          : durationMs - faultEnd);
+    std::sort(recover.begin(), recover.end());
+    r.recover95S = recover[(size_t)(0.95 * (recover.size() - 1))] / 1000.0;
+    r.recover100S = recover.back() / 1000.0;
+  }
+
+  r.staleP50S = percentile(staleness, 0.50);
+  r.staleP90S = percentile(staleness, 0.90);
+  r.staleP99S = percentile(staleness, 0.99);
+  r.staleMaxS = percentile(staleness, 1.0);
+  return r;
+}
+
+int main(int argc, char **argv) {
+  int boards = argc > 1 ? atoi(argv[1]) : 500;
+  double hours = argc > 2 ? atof(argv[2]) : 3.0;
+  uint32_t capacity = argc > 3 ? (uint32_t)atoi(argv[3]) : 20;
+  uint32_t durationMs = (uint32_t)(hours * 3600 * 1000);
+  if (boards <= 0 || durationMs <= FAULT_START_MS + FAULT_LENGTH_MS) {
+    fprintf(stderr, "usage: %s [boards] [hours > 1.2] [capacity]\n",
+            argv[0]);
+    return 1;
+  }
+
+  printf("Fleet vs mock API: %d boards, %.1f h, server capacity %u req/s, "
+         "10 min fault at 1 h\n",
+         boards, hours, capacity);
+  printf("%-8s | %8s %6s %6s | %6s %6s %6s | %7s %7s | %5s %5s %5s %5s\n",
+         "scenario", "requests", "fail", "shed", "mean/s", "peak/s", "ampl",
+         "rec95", "rec100", "p50", "p90", "p99", "max");
+  printf("%-8s | %22s | %20s | %15s | %23s\n", "", "", "req/s", "recovery (s)",
+         "staleness (s)");
+
+  const FaultKind faults[] = {FAULT_NONE, FAULT_503,     FAULT_500,
+                              FAULT_SLOW, FAULT_REFUSED, FAULT_WIFI};
+  for (FaultKind fault : faults) {
+    Report r = simulate(boards, durationMs, fault, capacity, 12345);
+    char rec95[16] = "-", rec100[16] = "-";
+    if (fault != FAULT_NONE) {
+      snprintf(rec95, sizeof(rec95), "%.0f", r.recover95S);
+      snprintf(rec100, sizeof(rec100), "%.0f", r.recover100S);
+    }
+    printf("%-8s | %8u %6u %6u | %6.2f %6u %6.2f | %7s %7s | %5u %5u %5u "
+           "%5u\n",
+           faultName(fault), r.requests, r.failures, r.shed, r.meanPerSecond,
+           r.peakPerSecond, r.amplification, rec95, rec100, r.staleP50S,
+           r.staleP90S, r.staleP99S, r.staleMaxS);
+  }
+  printf("ampl = requests from fault start to 10 min after its end, over "
+         "the nominal rate\n");
+  return 0;
+}
@@ -0,0 +1,145 @@
+// =================================================================
+// FLEET SIMULATION (host build)
+// Runs the real FetchScheduler for N boards that all power up within a
+// couple of seconds, and measures the load they put on the API.
+//
+//   pio run -e fleet_sim -t exec
+//   .pio/build/fleet_sim/program [hours] [outage]
+// =================================================================
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "fetch_scheduler.h"
+
+static const uint32_t FETCH_INTERVAL_MS = 5 * 60 * 1000;
+static const uint32_t FETCH_JITTER_MS = 30 * 1000;
+static const uint32_t BOOT_SKEW_MS = 2000; // Stesso circuito di alimentazione
+
+// Guasto simulato: il server risponde 503 + Retry-After per 5 minuti
+static const uint32_t OUTAGE_START_MS = 60 * 60 * 1000;
+static const uint32_t OUTAGE_END_MS = OUTAGE_START_MS + 5 * 60 * 1000;
+static const uint32_t OUTAGE_RETRY_AFTER_S = 60;
+
+struct Result {
+  uint32_t requests;
+  uint32_t peakPerSecond;
+  double meanPerSecond;
+  double p99PerSecond;
+};
+
+static Result summarize(std::vector<uint32_t> &requestTimes,
+                        uint32_t durationMs) {
+  Result r = {};
+  r.requests = requestTimes.size();
+  std::vector<uint32_t> perSecond(durationMs / 1000 + 1, 0);
+  for (uint32_t t : requestTimes) {
+    if (t < durationMs)
+      perSecond[t / 1000]++;
+  }
+  r.peakPerSecond = *std::max_element(perSecond.begin(), perSecond.end());
+  r.meanPerSecond = (double)r.requests / (durationMs / 1000.0);
+
+  // p99 solo sui secondi con traffico: la media da sola nasconde i picchi
+  std::vector<uint32_t> busy;
+  for (uint32_t c : perSecond) {
+    if (c)
+      busy.push_back(c);
+  }
+  if (!busy.empty()) {
+    std::sort(busy.begin(), busy.end());
+    r.p99PerSecond = busy[(size_t)(busy.size() * 0.99)];
+  }
+  return r;
+}
+
+/**
+ * @brief Old behaviour: fetch at boot, then exactly every interval.
+ */
+static Result simulateLegacy(int boards, uint32_t durationMs,
+                             std::mt19937 &rng, bool outage) {
+  std::vector<uint32_t> times;
+  std::uniform_int_distribution<uint32_t> skew(0, BOOT_SKEW_MS);
+  for (int b = 0; b < boards; b++) {
+    uint32_t t = skew(rng);
+    while (t < durationMs) {
+      times.push_back(t);
+      // Prima, un errore HTTP non aggiornava lastDataFetch: si riprovava
+      // a ogni giro di loop(); qui lo approssimiamo con 1 s
+      bool failed = outage && t >= OUTAGE_START_MS && t < OUTAGE_END_MS;
+      t += failed ? 1000 : FETCH_INTERVAL_MS;
+    }
+  }
+  return summarize(times, durationMs);
+}
+
+static Result simulateScheduled(int boards, uint32_t durationMs,
+                                std::mt19937 &rng, bool outage) {
+  std::vector<FetchScheduler> fleet;
+  fleet.reserve(boards);
+
+  typedef std::pair<uint32_t, int> Event; // (istante, scheda)
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+  std::uniform_int_distribution<uint32_t> skew(0, BOOT_SKEW_MS);
+  // MAC consecutivi dello stesso lotto: il caso peggiore per l'hash
+  uint64_t baseMac = 0x240ac4000000ULL;
+  for (int b = 0; b < boards; b++) {
+    fleet.emplace_back(FETCH_INTERVAL_MS, FETCH_JITTER_MS);
+    uint32_t boot = skew(rng);
+    fleet[b].begin(boot, baseMac + b, rng());
+    events.push(Event(fleet[b].nextFetchMs(), b));
+  }
+
+  std::vector<uint32_t> times;
+  while (!events.empty()) {
+    Event e = events.top();
+    events.pop();
+    uint32_t t = e.first;
+    if (t >= durationMs)
+      continue;
+    times.push_back(t);
+
+    FetchScheduler &s = fleet[e.second];
+    FetchHints hints = {};
+    if (outage && t >= OUTAGE_START_MS && t < OUTAGE_END_MS) {
+      hints.retryAfterS = OUTAGE_RETRY_AFTER_S;
+      s.onFailure(t, hints);
+    } else {
+      s.onSuccess(t, hints);
+    }
+    events.push(Event(s.nextFetchMs(), e.second));
+  }
+  return summarize(times, durationMs);
+}
+
+int main(int argc, char **argv) {
+  double hours = argc > 1 ? atof(argv[1]) : 6.0;
+  bool outage = argc > 2 && strcmp(argv[2], "outage") == 0;
+  uint32_t durationMs = (uint32_t)(hours * 3600 * 1000);
+  const int fleetSizes[] = {10, 100, 500, 1000, 5000};
+
+  printf("Fleet simulation: %.1f h, interval %u s, jitter +-%u s%s\n", hours,
+         FETCH_INTERVAL_MS / 1000, FETCH_JITTER_MS / 1000,
+         outage ? ", 5 min 503 outage at 1 h" : "");
+  printf("%7s | %28s | %28s\n", "", "legacy (fixed 5 min)",
+         "phase + jitter + hints");
+  printf("%7s | %8s %8s %10s | %8s %8s %10s\n", "boards", "peak/s", "p99/s",
+         "requests", "peak/s", "p99/s", "requests");
+
+  for (int boards : fleetSizes) {
+    std::mt19937 rng(12345);
+    Result legacy = simulateLegacy(boards, durationMs, rng, outage);
+    Result sched = simulateScheduled(boards, durationMs, rng, outage);
+    printf("%7d | %8u %8.0f %10u | %8u %8.0f %10u\n", boards,
+           legacy.peakPerSecond, legacy.p99PerSecond, legacy.requests,
+           sched.peakPerSecond, sched.p99PerSecond, sched.requests);
+  }
+  printf("mean rate with %d boards: %.2f req/s\n", fleetSizes[4],
+         fleetSizes[4] * 1000.0 / FETCH_INTERVAL_MS);
+  return 0;
+}
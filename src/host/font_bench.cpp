@@ -0,0 +1,164 @@
+// =================================================================
+// FONT BENCHMARK (host build)
+// Glyphs per second drawn the DMD32 way (font decoded column by column,
+// one writePixel per pixel) vs packed fonts (one shift and two ORs per
+// glyph row), on the same text and the same 2x1 panel wall. Both are
+// first rendered and compared pixel by pixel.
+//
+//   .pio/build/font_bench/program
+// =================================================================
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "fonts/Arial14.h"
+#include "fonts/SystemFont5x7.h"
+#include "framebuffer.h"
+#include "packed_font.h"
+
+#define ACROSS 2
+#define DOWN 1
+#define WIDTH (32 * ACROSS)
+#define HEIGHT (16 * DOWN)
+
+// =================================================================
+// DMD32 (stessi passi di DMD::writePixel e DMD::drawChar)
+// =================================================================
+static uint8_t legacyRam[ACROSS * DOWN * 4 * 16];
+
+static void legacyWritePixel(int x, int y, bool on) {
+  if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+    return;
+  int panel = x / 32 + ACROSS * (y / 16);
+  x = x % 32 + panel * 32;
+  y = y % 16;
+  int pointer = x / 8 + y * (ACROSS * DOWN * 4);
+  uint8_t bit = 0x80 >> (x & 7);
+  if (on)
+    legacyRam[pointer] &= ~bit; // LED acceso = bit a 0
+  else
+    legacyRam[pointer] |= bit;
+}
+
+static int legacyDrawChar(const uint8_t *font, int x, int y, uint8_t c) {
+  uint8_t height = pgm_read_byte(font + 3);
+  uint8_t first = pgm_read_byte(font + 4);
+  uint8_t count = pgm_read_byte(font + 5);
+  if (c < first || c >= first + count)
+    return -1;
+  c -= first;
+  uint8_t bytes = (height + 7) / 8;
+  uint8_t width;
+  size_t index = 0;
+  if (pgm_read_byte(font) == 0 && pgm_read_byte(font + 1) == 0) {
+    width = pgm_read_byte(font + 2);
+    index = c * bytes * width + 6;
+  } else {
+    for (uint8_t i = 0; i < c; i++)
+      index += pgm_read_byte(font + 6 + i);
+    index = index * bytes + count + 6;
+    width = pgm_read_byte(font + 6 + c);
+  }
+  for (int j = 0; j < width; j++) {
+    for (int i = bytes - 1; i >= 0; i--) {
+      uint8_t data = pgm_read_byte(font + index + j + i * width);
+      int offset = i * 8;
+      if (i == bytes - 1 && bytes > 1)
+        offset = height - 8;
+      for (int k = 0; k < 8; k++) {
+        if (offset + k >= i * 8 && offset + k <= height)
+          legacyWritePixel(x + j, y + offset + k, data & (1 << k));
+      }
+    }
+  }
+  return width;
+}
+
+static int legacyDrawString(const uint8_t *font, int x, int y,
+                            const char *text) {
+  int width = 0;
+  for (const char *p = text; *p; p++) {
+    int w = legacyDrawChar(font, x + width, y, (uint8_t)*p);
+    if (w > 0) {
+      width += w;
+      for (int r = 0; r <= font[3]; r++) // Colonna di spazio
+        legacyWritePixel(x + width, y + r, false);
+      width++;
+    }
+  }
+  return width;
+}
+
+static bool legacyPixel(int x, int y) {
+  int panel = x / 32 + ACROSS * (y / 16);
+  int px = x % 32 + panel * 32;
+  int pointer = px / 8 + (y % 16) * (ACROSS * DOWN * 4);
+  return !(legacyRam[pointer] & (0x80 >> (px & 7)));
+}
+
+// =================================================================
+// BENCHMARK
+// =================================================================
+static const char *TEXT = "-> Bologna Centrale 12:34 +5'";
+#define ROUNDS 20000
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static bool compare(const char *name, const uint8_t *dmd,
+                    const PackedFont &packed, Framebuffer &fb) {
+  memset(legacyRam, 0xff, sizeof(legacyRam));
+  fb.clear();
+  legacyDrawString(dmd, 3, 1, TEXT);
+  fb.drawText(3, 1, packed, TEXT, strlen(TEXT));
+  for (int y = 0; y < HEIGHT; y++)
+    for (int x = 0; x < WIDTH; x++)
+      if (legacyPixel(x, y) != fb.pixel(x, y)) {
+        printf("%s: pixel %d,%d differs\n", name, x, y);
+        return false;
+      }
+  return true;
+}
+
+static bool bench(const char *name, const uint8_t *dmd) {
+  static uint8_t blob[16384] __attribute__((aligned(4)));
+  size_t length = packedFontFromDmd(dmd, blob, sizeof(blob));
+  PackedFont packed;
+  if (!length || !packed.attach(blob, length)) {
+    printf("%s: conversion failed\n", name);
+    return false;
+  }
+  static uint32_t words[WIDTH / 32 * HEIGHT];
+  Framebuffer fb(words, WIDTH, HEIGHT);
+  if (!compare(name, dmd, packed, fb))
+    return false;
+
+  // Entrambi scrivono in buffer statici: i disegni non vengono eliminati
+  size_t glyphs = strlen(TEXT) * (size_t)ROUNDS;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ROUNDS; i++)
+    legacyDrawString(dmd, (i % 40) - 8, 1, TEXT);
+  double legacy = glyphs / seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ROUNDS; i++)
+    fb.drawText((i % 40) - 8, 1, packed, TEXT, strlen(TEXT));
+  double fast = glyphs / seconds(start);
+
+  printf("%-10s %5zu B packed  DMD %10.0f glyph/s  packed %10.0f glyph/s"
+         "  x%.1f\n",
+         name, length, legacy, fast, fast / legacy);
+  return true;
+}
+
+int main() {
+  bool ok = bench("Arial14", Arial_14);
+  ok = bench("System5x7", System5x7) && ok;
+  return ok ? 0 : 1;
+}
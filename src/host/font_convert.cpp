@@ -0,0 +1,140 @@
+// =================================================================
+// FONT CONVERSION (host build)
+// BDF fonts to the packed row-major format (packed_font.h). DMD fonts
+// are converted by packed_font.cpp, which the board uses too.
+// =================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "packed_font.h"
+
+/**
+ * @brief Accumulates glyphs, then writes the blob.
+ */
+class PackedFontWriter {
+public:
+  PackedFontWriter(uint8_t height, uint8_t firstChar, uint8_t charCount,
+                   uint8_t spacing)
+      : glyphs(charCount) {
+    memset(&header, 0, sizeof(header));
+    header.magic[0] = PACKED_FONT_MAGIC0;
+    header.magic[1] = PACKED_FONT_MAGIC1;
+    header.version = PACKED_FONT_VERSION;
+    header.height = height;
+    header.firstChar = firstChar;
+    header.charCount = charCount;
+    header.spacing = spacing;
+    memset(glyphs.data(), 0, glyphs.size() * sizeof(PackedGlyph));
+  }
+
+  // Righe del glifo index, riempite poi con setPixel()
+  void begin(uint8_t index, uint8_t width) {
+    active = true;
+    current = index;
+    glyphs[index].width = width;
+    glyphs[index].wordsPerRow = (width + 31) / 32;
+    glyphs[index].offset = (uint16_t)rows.size();
+    rows.resize(rows.size() + glyphs[index].wordsPerRow * header.height, 0);
+  }
+
+  // I pixel seguenti vengono ignorati (carattere non incluso)
+  void discard() { active = false; }
+
+  void setPixel(int x, int y) {
+    const PackedGlyph &g = glyphs[current];
+    if (!active || x < 0 || x >= g.width || y < 0 || y >= header.height)
+      return;
+    rows[g.offset + y * g.wordsPerRow + x / 32] |= 0x80000000u >> (x % 32);
+  }
+
+  size_t write(uint8_t *out, size_t size) const {
+    size_t length = sizeof(header) + glyphs.size() * sizeof(PackedGlyph) +
+                    rows.size() * sizeof(uint32_t);
+    if (size < length || rows.size() > 0xffff)
+      return 0;
+    uint8_t *p = out;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, glyphs.data(), glyphs.size() * sizeof(PackedGlyph));
+    p += glyphs.size() * sizeof(PackedGlyph);
+    memcpy(p, rows.data(), rows.size() * sizeof(uint32_t));
+    return length;
+  }
+
+private:
+  PackedFontHeader header;
+  std::vector<PackedGlyph> glyphs;
+  std::vector<uint32_t> rows;
+  uint8_t current = 0;
+  bool active = false;
+};
+
+// =================================================================
+// BDF
+// =================================================================
+
+#define BDF_FIRST 32
+#define BDF_LAST 126
+
+static const char *nextLine(const char *line) {
+  const char *end = strchr(line, '\n');
+  return end && end[1] ? end + 1 : nullptr;
+}
+
+size_t packedFontFromBdf(const char *bdf, uint8_t *out, size_t size) {
+  int ascent = -1;
+  int descent = -1;
+  // Prima passata: metriche del font
+  for (const char *p = bdf; p; p = nextLine(p)) {
+    sscanf(p, "FONT_ASCENT %d", &ascent);
+    sscanf(p, "FONT_DESCENT %d", &descent);
+  }
+  if (ascent < 0 || descent < 0 || ascent + descent > 255)
+    return 0;
+
+  PackedFontWriter writer((uint8_t)(ascent + descent), BDF_FIRST,
+                          BDF_LAST - BDF_FIRST + 1, 0);
+  int encoding = -1;
+  int advance = 0;
+  int w = 0, h = 0, xo = 0, yo = 0;
+  int bitmapRow = -1; // >= 0 dentro BITMAP
+  for (const char *p = bdf; p; p = nextLine(p)) {
+    if (bitmapRow >= 0) {
+      if (strncmp(p, "ENDCHAR", 7) == 0) {
+        bitmapRow = -1;
+        continue;
+      }
+      // Riga esadecimale, MSB del primo byte = colonna più a sinistra
+      int top = ascent - (yo + h) + bitmapRow++;
+      int x = 0;
+      for (const char *q = p; x < w && q[0] && q[1] && q[0] != '\n';
+           q += 2) {
+        char hex[3] = {q[0], q[1], 0};
+        unsigned byte = (unsigned)strtoul(hex, nullptr, 16);
+        for (int bit = 7; bit >= 0 && x < w; bit--, x++)
+          if (byte & (1u << bit))
+            writer.setPixel(xo + x, top);
+      }
+      continue;
+    }
+    if (sscanf(p, "ENCODING %d", &encoding) == 1)
+      continue;
+    if (sscanf(p, "DWIDTH %d", &advance) == 1)
+      continue;
+    if (sscanf(p, "BBX %d %d %d %d", &w, &h, &xo, &yo) == 4)
+      continue;
+    if (strncmp(p, "BITMAP", 6) == 0) {
+      if (encoding < BDF_FIRST || encoding > BDF_LAST || advance <= 0 ||
+          advance > 255) {
+        writer.discard(); // Fuori intervallo
+      } else {
+        writer.begin((uint8_t)(encoding - BDF_FIRST), (uint8_t)advance);
+      }
+      bitmapRow = 0;
+    }
+  }
+  return writer.write(out, size);
+}
@@ -0,0 +1,216 @@
+// =================================================================
+// JSON BENCHMARK (host build)
+// Parses the same departures fixtures with ArduinoJson (document, then
+// lookups by key, as fetchData() did) and with DeparturesParser fed in
+// BodyReader-sized chunks and one byte at a time. Checks that both
+// produce the same Snapshot, then reports time per payload, throughput
+// and peak memory (ArduinoJson's pool vs the parser object).
+//
+//   pio run -e json_bench -t exec
+// =================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ArduinoJson.h>
+#include <chrono>
+#include <string>
+
+#include "departures_parser.h"
+#include "snapshot.h"
+
+#define BODY_CHUNK 128 // Il buffer di BodyReader
+
+// Conta i byte vivi del documento per riportarne il picco
+class CountingAllocator : public ArduinoJson::Allocator {
+public:
+  void *allocate(size_t size) override {
+    size_t *p = (size_t *)malloc(size + sizeof(size_t));
+    if (!p)
+      return nullptr;
+    *p = size;
+    track(size);
+    return p + 1;
+  }
+  void deallocate(void *ptr) override {
+    if (!ptr)
+      return;
+    size_t *p = (size_t *)ptr - 1;
+    live -= *p;
+    free(p);
+  }
+  void *reallocate(void *ptr, size_t size) override {
+    size_t *p = ptr ? (size_t *)ptr - 1 : nullptr;
+    size_t old = p ? *p : 0;
+    p = (size_t *)realloc(p, size + sizeof(size_t));
+    if (!p)
+      return nullptr;
+    *p = size;
+    live -= old;
+    track(size);
+    return p + 1;
+  }
+
+  size_t live = 0;
+  size_t peak = 0;
+
+private:
+  void track(size_t size) {
+    live += size;
+    if (live > peak)
+      peak = live;
+  }
+};
+
+static CountingAllocator allocator;
+
+// Il parsing di prima, con std::string al posto di String
+static bool parseDocument(const std::string &json, Snapshot &snap) {
+  memset(&snap, 0, sizeof(snap));
+  JsonDocument doc(&allocator);
+  if (deserializeJson(doc, json.data(), json.size()))
+    return false;
+
+  std::string temp = doc["weather"]["temperature"] | "";
+  std::string desc = doc["weather"]["description"] | "";
+  for (char &c : temp)
+    if (c == '^')
+      c = '\xf8';
+  snapshotCopyField(snap.weather, sizeof(snap.weather),
+                    (temp + " - " + desc).c_str());
+  snapshotCopyField(snap.stationName, sizeof(snap.stationName),
+                    doc["stationName"] | "");
+
+  JsonArray departuresArray = doc["departures"];
+  for (JsonObject train : departuresArray) {
+    if (snap.count == SNAPSHOT_MAX_DEPARTURES)
+      break;
+    DepartureRecord &d = snap.departures[snap.count++];
+    snapshotCopyField(d.type, sizeof(d.type), train["type"] | "");
+    std::string destination = "-> ";
+    destination += train["destination"] | "";
+    snapshotCopyField(d.destination, sizeof(d.destination),
+                      destination.c_str());
+    snapshotCopyField(d.departureTime, sizeof(d.departureTime),
+                      train["departureTime"] | "");
+    snapshotCopyField(d.delay, sizeof(d.delay), train["delay"] | "");
+  }
+  return true;
+}
+
+static bool parseStream(const std::string &json, Snapshot &snap,
+                        size_t chunk) {
+  DeparturesParser parser(snap);
+  for (size_t i = 0; i < json.size() && !parser.done() && !parser.failed();
+       i += chunk) {
+    size_t n = json.size() - i < chunk ? json.size() - i : chunk;
+    parser.feed(json.data() + i, n);
+  }
+  return parser.done();
+}
+
+// =================================================================
+// Fixtures
+// =================================================================
+
+// Come la risposta dell'API (limit= partenze), campi non usati compresi
+static std::string makeApi(int departures, bool pretty) {
+  const char *nl = pretty ? "\n    " : "";
+  std::string json = "{\"stationName\":\"Castelfranco Emilia\","
+                     "\"stationCode\":\"S05037\",\"weather\":{"
+                     "\"temperature\":\"18^C\",\"description\":\"Sereno\","
+                     "\"humidity\":62,\"wind\":{\"speed\":3.5,\"dir\":\"NE\"}"
+                     "},\"departures\":[";
+  for (int i = 0; i < departures; i++) {
+    char train[512];
+    snprintf(train, sizeof(train),
+             "%s%s{\"type\":\"%s\",\"number\":\"%d\",%s"
+             "\"destination\":\"%s\",%s\"departureTime\":\"%02d:%02d\","
+             "\"delay\":\"+%d\",\"platform\":\"%d\",\"cancelled\":false,"
+             "\"stops\":[\"Anzola\",\"Samoggia\",\"Bologna Borgo "
+             "Panigale\"],\"operator\":{\"name\":\"Trenitalia TPER\","
+             "\"id\":7}}",
+             i ? "," : "", nl, i % 3 ? "REG" : "RV", 17400 + i, nl,
+             i % 2 ? "Bologna Centrale" : "Piacenza", nl, 8 + i / 6,
+             i * 10 % 60, i % 7, 1 + i % 3);
+    json += train;
+  }
+  return json + "]}";
+}
+
+static std::string makeEscapes() {
+  return "{\"stationName\":\"Forl\\u00ec\",\"weather\":{\"description\":"
+         "\"Pioggia \\\"forte\\\"\",\"temperature\":\"7^C\"},"
+         "\"departures\":[{\"type\":\"FR\",\"destination\":\"Roma "
+         "Termini \\ud83d\\ude86\",\"departureTime\":\"10:05\",\"delay\":"
+         "\"+12\"},{\"destination\":\"Citt\\u00e0 di Castello\\/Arezzo "
+         "via Sansepolcro e oltre\",\"type\":\"REG\",\"delay\":\"\","
+         "\"departureTime\":\"10:17\"}]}";
+}
+
+static bool sameSnapshot(const Snapshot &a, const Snapshot &b) {
+  if (strcmp(a.weather, b.weather) || strcmp(a.stationName, b.stationName) ||
+      a.count != b.count)
+    return false;
+  for (uint8_t i = 0; i < a.count; i++) {
+    const DepartureRecord &x = a.departures[i], &y = b.departures[i];
+    if (strcmp(x.type, y.type) || strcmp(x.destination, y.destination) ||
+        strcmp(x.departureTime, y.departureTime) || strcmp(x.delay, y.delay))
+      return false;
+  }
+  return true;
+}
+
+template <class F> static double usPerParse(F parse, int rounds) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++)
+    parse();
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         rounds;
+}
+
+int main() {
+  struct {
+    const char *name;
+    std::string json;
+  } fixtures[] = {
+      {"api, 5 departures", makeApi(5, false)},
+      {"api, 8 pretty", makeApi(8, true)},
+      {"api, 40 departures", makeApi(40, false)},
+      {"escapes", makeEscapes()},
+  };
+
+  printf("DeparturesParser: %zu bytes of state\n\n",
+         sizeof(DeparturesParser));
+  printf("%-20s %6s | %10s %8s %8s | %10s %8s | %10s\n", "fixture", "bytes",
+         "ArduinoJson", "MB/s", "peak B", "stream", "MB/s", "1 B chunks");
+  for (auto &f : fixtures) {
+    Snapshot doc, stream, bytewise;
+    allocator.peak = 0;
+    if (!parseDocument(f.json, doc) ||
+        !parseStream(f.json, stream, BODY_CHUNK) ||
+        !parseStream(f.json, bytewise, 1)) {
+      printf("%s: parse failed\n", f.name);
+      return 1;
+    }
+    if (!sameSnapshot(doc, stream) || !sameSnapshot(doc, bytewise)) {
+      printf("%s: snapshots differ\n", f.name);
+      return 1;
+    }
+    int rounds = 2000000 / (int)f.json.size() + 1;
+    double docUs = usPerParse([&] { parseDocument(f.json, doc); }, rounds);
+    double streamUs = usPerParse(
+        [&] { parseStream(f.json, stream, BODY_CHUNK); }, rounds);
+    double byteUs =
+        usPerParse([&] { parseStream(f.json, bytewise, 1); }, rounds);
+    printf("%-20s %6zu | %8.2f us %8.1f %8zu | %7.2f us %8.1f | %7.2f us"
+           "  x%.1f\n",
+           f.name, f.json.size(), docUs, f.json.size() / docUs,
+           allocator.peak, streamUs, f.json.size() / streamUs, byteUs,
+           docUs / streamUs);
+  }
+  printf("\nsame snapshot from both parsers on every fixture\n");
+  return 0;
+}
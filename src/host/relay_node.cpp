@@ -0,0 +1,232 @@
+// =================================================================
+// LAN RELAY NODE (host build)
+// Runs the real RelayNode over loopback multicast, so a leader and
+// several followers can be tested on one Linux machine.
+//
+//   .pio/build/relay_node/program leader      (one terminal)
+//   .pio/build/relay_node/program follower    (as many as you like)
+//   .pio/build/relay_node/program demo        (forks 1 leader + 3
+//       followers, stops the leader and checks that followers fall back)
+//
+// Time runs 100x faster than real time so RELAY_SILENCE_MS takes ~1 s.
+// =================================================================
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "relay.h"
+
+static const uint32_t TIME_SCALE = 100;
+static const uint32_t LEADER_FETCH_MS = 60000; // Tempo simulato
+static const char *STATION = "S05037";
+
+static uint32_t simMillis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t ms = (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+  return (uint32_t)(ms * TIME_SCALE);
+}
+
+static int64_t wallUtcUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleepRealMs(uint32_t ms) { usleep(ms * 1000); }
+
+/**
+ * @brief Multicast over the loopback interface: every process joins the
+ * group on 127.0.0.1 and shares the port (SO_REUSEPORT).
+ */
+class LoopbackMulticastLink : public RelayLink {
+public:
+  LoopbackMulticastLink() : fd(-1) {
+    memset(&group, 0, sizeof(group));
+    group.sin_family = AF_INET;
+    group.sin_port = htons(RELAY_PORT);
+    char addr[16];
+    snprintf(addr, sizeof(addr), "%d.%d.%d.%d", RELAY_GROUP_A, RELAY_GROUP_B,
+             RELAY_GROUP_C, RELAY_GROUP_D);
+    inet_pton(AF_INET, addr, &group.sin_addr);
+  }
+
+  bool open() {
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+      return false;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(RELAY_PORT);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0)
+      return false;
+
+    struct in_addr loopback;
+    loopback.s_addr = htonl(INADDR_LOOPBACK);
+    struct ip_mreq mreq;
+    mreq.imr_multiaddr = group.sin_addr;
+    mreq.imr_interface = loopback;
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+      return false;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback));
+    unsigned char loop = 1;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return true;
+  }
+
+  bool send(const uint8_t *data, size_t length) override {
+    return sendto(fd, data, length, 0, (struct sockaddr *)&group,
+                  sizeof(group)) == (ssize_t)length;
+  }
+
+  int receive(uint8_t *buf, size_t size) override {
+    ssize_t n = recv(fd, buf, size, 0);
+    return n < 0 ? -1 : (int)n;
+  }
+
+private:
+  int fd;
+  struct sockaddr_in group;
+};
+
+static void fakeFetch(Snapshot &snap, uint32_t sequence) {
+  memset(&snap, 0, sizeof(snap));
+  snap.sequence = sequence;
+  snapshotCopyField(snap.weather, sizeof(snap.weather), "18^C - Sereno");
+  snapshotCopyField(snap.stationName, sizeof(snap.stationName),
+                    "Castelfranco Emilia");
+  snap.count = 3;
+  for (int i = 0; i < snap.count; i++) {
+    DepartureRecord &d = snap.departures[i];
+    snapshotCopyField(d.type, sizeof(d.type), "REG");
+    snapshotCopyField(d.destination, sizeof(d.destination), "-> Bologna C.le");
+    snprintf(d.departureTime, sizeof(d.departureTime), "%02u:%02u",
+             (8 + sequence / 6 + i) % 24, (sequence * 10) % 60);
+    snprintf(d.delay, sizeof(d.delay), "+%u", (sequence + i) % 7);
+  }
+}
+
+static int runLeader(uint32_t runForMs) {
+  LoopbackMulticastLink link;
+  if (!link.open()) {
+    perror("leader socket");
+    return 1;
+  }
+  RelayNode node(link, RELAY_LEADER, (uint32_t)getpid(), STATION,
+                 wallUtcUs);
+
+  uint32_t start = simMillis();
+  uint32_t lastFetch = start - LEADER_FETCH_MS;
+  uint32_t sequence = 0;
+  while (runForMs == 0 || simMillis() - start < runForMs) {
+    uint32_t now = simMillis();
+    if (now - lastFetch >= LEADER_FETCH_MS) {
+      Snapshot snap;
+      fakeFetch(snap, ++sequence);
+      node.publish(snap, now);
+      lastFetch = now;
+      printf("[leader %d] published #%u\n", getpid(), sequence);
+      fflush(stdout);
+    }
+    node.poll(now);
+    sleepRealMs(10);
+  }
+  printf("[leader %d] stopping, %u packets sent\n", getpid(),
+         node.sentCount());
+  return 0;
+}
+
+static int runFollower(uint32_t runForMs) {
+  LoopbackMulticastLink link;
+  if (!link.open()) {
+    perror("follower socket");
+    return 1;
+  }
+  RelayNode node(link, RELAY_FOLLOWER, (uint32_t)getpid(), STATION);
+
+  uint32_t start = simMillis();
+  bool wasSilent = true;
+  uint32_t fallbacks = 0;
+  while (runForMs == 0 || simMillis() - start < runForMs) {
+    uint32_t now = simMillis();
+    if (node.poll(now)) {
+      const Snapshot &s = node.latest();
+      printf("[follower %d] snapshot #%u: %s, %u trains, first %s %s, "
+             "clock offset %lld us\n",
+             getpid(), s.sequence, s.weather, s.count,
+             s.count ? s.departures[0].departureTime : "-",
+             s.count ? s.departures[0].delay : "",
+             (long long)(wallUtcUs() - s.utcUs));
+      fflush(stdout);
+    }
+    bool isSilent = node.silent(now);
+    if (isSilent && !wasSilent) {
+      fallbacks++;
+      printf("[follower %d] relay silent, falling back to direct fetch\n",
+             getpid());
+      fflush(stdout);
+    }
+    wasSilent = isSilent;
+    sleepRealMs(10);
+  }
+  printf("[follower %d] received %u, rejected %u, fallbacks %u\n", getpid(),
+         node.receivedCount(), node.rejectedCount(), fallbacks);
+  // Exit code per la demo: 0 se ha ricevuto dati ed è passato al fallback
+  return (node.receivedCount() > 0 && fallbacks == 1) ? 0 : 2;
+}
+
+static int runDemo() {
+  const int followers = 3;
+  const uint32_t leaderRunMs = 300000;   // 3 s reali
+  const uint32_t followerRunMs = 500000; // 5 s reali
+  pid_t pids[followers + 1];
+
+  for (int i = 0; i < followers; i++) {
+    pids[i] = fork();
+    if (pids[i] == 0)
+      exit(runFollower(followerRunMs));
+  }
+  sleepRealMs(100); // I follower si iscrivono al gruppo prima del leader
+  pids[followers] = fork();
+  if (pids[followers] == 0)
+    exit(runLeader(leaderRunMs));
+
+  int failures = 0;
+  for (int i = 0; i <= followers; i++) {
+    int status = 0;
+    waitpid(pids[i], &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      failures++;
+  }
+  printf("demo %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  const char *mode = argc > 1 ? argv[1] : "demo";
+  if (strcmp(mode, "leader") == 0)
+    return runLeader(0);
+  if (strcmp(mode, "follower") == 0)
+    return runFollower(0);
+  if (strcmp(mode, "demo") == 0)
+    return runDemo();
+  fprintf(stderr, "usage: %s leader|follower|demo\n", argv[0]);
+  return 1;
+}
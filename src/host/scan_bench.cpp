@@ -0,0 +1,136 @@
+// =================================================================
+// SCAN BENCHMARK (host build)
+// Checks that a FB_SCAN_ORDER framebuffer holds, for every scan row,
+// exactly the byte stream DMD32's scanDisplayBySPI() sends, then times
+// one scan row both ways for 1..32 panels: DMD32 gathers 4 bytes from
+// 4 rows of its RAM per SPI.transfer(), PanelDriver writes one
+// contiguous block. Only the CPU side: on the board both also wait
+// for the SPI clock (DISPLAY_BENCH=1 measures that).
+//
+//   .pio/build/scan_bench/program
+// =================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "framebuffer.h"
+
+// Registro dati SPI: ogni scrittura "esce" davvero
+static volatile uint32_t spiData;
+
+__attribute__((noinline)) static void spiTransfer(uint8_t byte) {
+  spiData = byte;
+}
+
+// Il FIFO dell'ESP32 si riempie a word da 32 bit
+__attribute__((noinline)) static void spiWrite(const uint8_t *data,
+                                               size_t length) {
+  for (size_t i = 0; i + 4 <= length; i += 4) {
+    uint32_t word;
+    memcpy(&word, data + i, 4);
+    spiData = word;
+  }
+}
+
+// =================================================================
+// DMD32: RAM row-major, 16 righe di panels * 4 byte, acceso = 0
+// =================================================================
+struct LegacyDmd {
+  int across;
+  int down;
+  std::vector<uint8_t> ram;
+
+  LegacyDmd(int across, int down)
+      : across(across), down(down), ram(across * down * 4 * 16, 0xff) {}
+
+  void writePixel(int x, int y, bool on) {
+    int panel = x / 32 + across * (y / 16);
+    x = x % 32 + panel * 32;
+    int pointer = x / 8 + (y % 16) * (across * down * 4);
+    uint8_t bit = 0x80 >> (x & 7);
+    if (on)
+      ram[pointer] &= ~bit;
+    else
+      ram[pointer] |= bit;
+  }
+
+  // Stessi indici di scanDisplayBySPI()
+  template <class Sink> void scanRow(int scanRow, Sink sink) const {
+    int rowsize = across * down * 4;
+    int offset = rowsize * scanRow;
+    int row1 = rowsize * 4, row2 = rowsize * 8, row3 = rowsize * 12;
+    for (int i = 0; i < rowsize; i++) {
+      sink(ram[offset + i + row3]);
+      sink(ram[offset + i + row2]);
+      sink(ram[offset + i + row1]);
+      sink(ram[offset + i]);
+    }
+  }
+};
+
+static bool verify() {
+  const int walls[][2] = {{1, 1}, {2, 1}, {3, 2}, {8, 4}};
+  for (auto &wall : walls) {
+    int width = 32 * wall[0], height = 16 * wall[1];
+    std::vector<uint32_t> words(width / 32 * height);
+    Framebuffer fb(words.data(), width, height, FB_SCAN_ORDER);
+    fb.clear();
+    for (int i = 0; i < 200; i++)
+      fb.fillRect(rand() % width - 4, rand() % height - 4, rand() % 20,
+                  rand() % 8, (BlitMode)(rand() % 5));
+    LegacyDmd dmd(wall[0], wall[1]);
+    for (int y = 0; y < height; y++)
+      for (int x = 0; x < width; x++)
+        dmd.writePixel(x, y, fb.pixel(x, y));
+
+    size_t block = 16 * wall[0] * wall[1];
+    for (int row = 0; row < 4; row++) {
+      std::vector<uint8_t> stream;
+      dmd.scanRow(row, [&](uint8_t b) { stream.push_back(b); });
+      if (stream.size() != block ||
+          memcmp(stream.data(), fb.bytes() + row * block, block) != 0) {
+        printf("scan row %d differs on a %dx%d wall\n", row, wall[0],
+               wall[1]);
+        return false;
+      }
+    }
+  }
+  printf("scan order matches the DMD32 stream\n");
+  return true;
+}
+
+static double nsPerRow(int panels, bool legacy) {
+  LegacyDmd dmd(panels, 1);
+  std::vector<uint32_t> words(panels * 16);
+  Framebuffer fb(words.data(), 32 * panels, 16, FB_SCAN_ORDER);
+  fb.clear();
+  size_t block = 16 * panels;
+  int rounds = 4000000 / panels;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    if (legacy)
+      dmd.scanRow(i & 3, spiTransfer);
+    else
+      spiWrite(fb.bytes() + (i & 3) * block, block);
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / rounds;
+}
+
+int main() {
+  if (!verify())
+    return 1;
+  printf("\n%7s %12s %12s\n", "panels", "DMD32", "scan order");
+  for (int panels = 1; panels <= 32; panels *= 2) {
+    double legacy = nsPerRow(panels, true);
+    double fast = nsPerRow(panels, false);
+    printf("%7d %9.1f ns %9.1f ns  x%.1f\n", panels, legacy, fast,
+           legacy / fast);
+  }
+  return 0;
+}
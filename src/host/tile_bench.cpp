@@ -0,0 +1,182 @@
+// =================================================================
+// TILE BENCHMARK (host build)
+// Checks that a frame rendered per tile (1 and 2 workers, both
+// layouts) matches the same calls drawn directly, then times one
+// animation-like frame (clear, two text lines and an icon per row of
+// panels) against the panel count, with 1 and 2 workers. The second
+// worker is a thread woken through a condition variable, as the board
+// wakes its task with a notification. Needs 2 host cores to show a
+// speedup; DISPLAY_BENCH=1 runs the same scaling on the board.
+//
+//   .pio/build/tile_bench/program
+// =================================================================
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fonts/SystemFont5x7.h"
+#include "framebuffer.h"
+#include "packed_font.h"
+#include "tile_renderer.h"
+
+static const uint32_t ICON[16] = {
+    0x0ff00000, 0x1ff80000, 0x381c0000, 0x300c0000, 0x3ffc0000, 0x3ffc0000,
+    0x33cc0000, 0x3ffc0000, 0x1ff80000, 0x0c300000, 0x18180000, 0x300c0000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000};
+static const Sprite ICON_SPRITE = {ICON, 16, 16, 1};
+
+// Il secondo worker: aspetta la sveglia, poi help()
+class HelperThread {
+public:
+  explicit HelperThread(TileRenderer &renderer)
+      : renderer(renderer), pending(false), quit(false),
+        thread([this] { run(); }) {
+    renderer.setHelper(wake, this);
+  }
+  ~HelperThread() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quit = true;
+    }
+    cv.notify_one();
+    thread.join();
+    renderer.setHelper(nullptr, nullptr);
+  }
+
+private:
+  static void wake(void *arg) {
+    HelperThread *self = (HelperThread *)arg;
+    {
+      std::lock_guard<std::mutex> lock(self->mutex);
+      self->pending = true;
+    }
+    self->cv.notify_one();
+  }
+  void run() {
+    for (;;) {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this] { return pending || quit; });
+      if (quit)
+        return;
+      pending = false;
+      lock.unlock();
+      renderer.help();
+    }
+  }
+
+  TileRenderer &renderer;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool pending;
+  bool quit;
+  std::thread thread;
+};
+
+// Un frame "da animazione": testo su tutta la larghezza, un'icona
+static void recordFrame(TileFrame &frame, const PackedFont &font, int width,
+                        int height, int step) {
+  static const char TEXT[] = "R 12:34 +5' Bologna Centrale - Modena - "
+                             "Castelfranco Emilia - Piacenza - Milano ";
+  int chars = width / 6 < (int)sizeof(TEXT) - 1 ? width / 6
+                                                 : (int)sizeof(TEXT) - 1;
+  frame.reset();
+  frame.clear();
+  for (int band = 0; band < height; band += 16) {
+    frame.drawText(2 - step % 7, band + step % 3, font, TEXT, chars,
+                   BLIT_NORMAL);
+    frame.drawText(8, band + 8, font, TEXT + 12, chars / 2, BLIT_OR);
+    frame.blit(width - 16 - step % 5, band, ICON_SPRITE, BLIT_XOR);
+  }
+}
+
+static void drawDirect(Framebuffer &fb, const PackedFont &font, int step) {
+  static TileFrame frame;
+  recordFrame(frame, font, fb.width(), fb.height(), step);
+  fb.clearClip();
+  frame.rasterize(fb, 0, 0, fb.width(), fb.height());
+}
+
+static bool verify(const PackedFont &font) {
+  const int walls[][2] = {{1, 1}, {2, 1}, {4, 2}, {8, 4}};
+  static TileFrame frame;
+  for (auto &wall : walls) {
+    for (int layout = 0; layout < 2; layout++) {
+      int width = 32 * wall[0], height = 16 * wall[1];
+      std::vector<uint32_t> a(width / 32 * height), b(a.size());
+      Framebuffer direct(a.data(), width, height, (FramebufferLayout)layout);
+      Framebuffer tiled(b.data(), width, height, (FramebufferLayout)layout);
+      TileRenderer renderer(tiled);
+      for (int workers = 1; workers <= 2; workers++) {
+        HelperThread *helper =
+            workers == 2 ? new HelperThread(renderer) : nullptr;
+        for (int step = 0; step < 50; step++) {
+          direct.clear();
+          drawDirect(direct, font, step);
+          recordFrame(frame, font, width, height, step);
+          renderer.render(frame);
+          if (a != b || frame.overflowed()) {
+            printf("tiles differ: wall %dx%d layout %d, %d workers\n",
+                   wall[0], wall[1], layout, workers);
+            return false;
+          }
+        }
+        delete helper;
+      }
+    }
+  }
+  printf("tiled frames match direct drawing\n");
+  return true;
+}
+
+static double usPerFrame(TileRenderer &renderer, const PackedFont &font,
+                         int width, int height) {
+  static TileFrame frame;
+  const int rounds = 2000;
+  double total = 0;
+  for (int i = 0; i < rounds; i++) {
+    recordFrame(frame, font, width, height, i);
+    auto start = std::chrono::steady_clock::now();
+    renderer.render(frame);
+    total += std::chrono::duration<double, std::micro>(
+                 std::chrono::steady_clock::now() - start)
+                 .count();
+  }
+  return total / rounds;
+}
+
+int main() {
+  static uint8_t blob[8192] __attribute__((aligned(4)));
+  PackedFont font;
+  if (!font.attach(blob, packedFontFromDmd(System5x7, blob, sizeof(blob)))) {
+    printf("font conversion failed\n");
+    return 1;
+  }
+  if (!verify(font))
+    return 1;
+
+  printf("\nhost cores: %u\n", std::thread::hardware_concurrency());
+  printf("%7s %7s %12s %12s\n", "panels", "wall", "1 worker", "2 workers");
+  const int walls[][2] = {{1, 1}, {2, 1}, {4, 1}, {8, 1},
+                          {8, 2}, {8, 4}, {8, 8}};
+  for (auto &wall : walls) {
+    int width = 32 * wall[0], height = 16 * wall[1];
+    std::vector<uint32_t> words(width / 32 * height);
+    Framebuffer fb(words.data(), width, height, FB_SCAN_ORDER);
+    TileRenderer renderer(fb);
+    double one = usPerFrame(renderer, font, width, height);
+    double two;
+    {
+      HelperThread helper(renderer);
+      two = usPerFrame(renderer, font, width, height);
+    }
+    printf("%7d %4dx%-2d %9.1f us %9.1f us  x%.2f  (helper: %u tiles)\n",
+           wall[0] * wall[1], wall[0], wall[1], one, two, one / two,
+           renderer.helperTiles());
+  }
+  return 0;
+}
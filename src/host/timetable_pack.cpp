@@ -0,0 +1,108 @@
+// =================================================================
+// TIMETABLE PACKER (host build)
+// Turns a station timetable into an image for the "timetable" flash
+// partition (see timetable.h) and checks it with the real Timetable.
+//
+//   .pio/build/timetable_pack/program S05037 orario.csv timetable.bin
+//   esptool.py write_flash 0x3E0000 timetable.bin
+//
+// CSV: one departure per line, "HH:MM,type,destination"; blank lines
+// and lines starting with # are skipped.
+// =================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "timetable.h"
+
+static void copyField(char *dst, size_t size, const char *src) {
+  memset(dst, 0, size);
+  memcpy(dst, src, strnlen(src, size)); // Senza terminatore se è pieno
+}
+
+static char *trim(char *s) {
+  while (*s == ' ' || *s == '\t')
+    s++;
+  char *end = s + strlen(s);
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' ||
+                     end[-1] == '\n'))
+    *--end = '\0';
+  return s;
+}
+
+static bool parseLine(char *line, TimetableEntry &e) {
+  char *time = strtok(line, ",");
+  char *type = strtok(nullptr, ",");
+  char *destination = strtok(nullptr, "\n");
+  unsigned hour, minute;
+  if (!time || !type || !destination ||
+      sscanf(time, "%u:%u", &hour, &minute) != 2 || hour > 23 || minute > 59)
+    return false;
+  e.minute = (uint16_t)(hour * 60 + minute);
+  copyField(e.type, sizeof(e.type), trim(type));
+  copyField(e.destination, sizeof(e.destination), trim(destination));
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 4) {
+    fprintf(stderr, "usage: %s <station code> <timetable.csv> <out.bin>\n",
+            argv[0]);
+    return 2;
+  }
+  const char *station = argv[1];
+
+  FILE *in = fopen(argv[2], "r");
+  if (!in) {
+    perror(argv[2]);
+    return 1;
+  }
+  std::vector<TimetableEntry> entries;
+  char line[256];
+  int lineNumber = 0;
+  while (fgets(line, sizeof(line), in)) {
+    lineNumber++;
+    char *text = trim(line);
+    if (!*text || *text == '#')
+      continue;
+    TimetableEntry e;
+    if (!parseLine(text, e)) {
+      fprintf(stderr, "%s:%d: expected HH:MM,type,destination\n", argv[2],
+              lineNumber);
+      return 1;
+    }
+    entries.push_back(e);
+  }
+  fclose(in);
+
+  std::vector<uint8_t> image(timetableImageSize(entries.size()));
+  size_t length = timetableBuild(station, entries.data(), entries.size(),
+                                 image.data(), image.size());
+  if (!length) {
+    fprintf(stderr, "too many departures (max %d)\n", TIMETABLE_MAX_ENTRIES);
+    return 1;
+  }
+
+  // Rilegge l'immagine come farà la scheda
+  Timetable table;
+  if (!table.attach(image.data(), length, station)) {
+    fprintf(stderr, "image does not validate\n");
+    return 1;
+  }
+  Snapshot snap = {};
+  table.upcoming(8 * 60, snap);
+  printf("%u departures, %zu bytes. From 08:00:\n", table.count(), length);
+  for (uint8_t i = 0; i < snap.count; i++)
+    printf("  %s %-6s %s\n", snap.departures[i].departureTime,
+           snap.departures[i].type, snap.departures[i].destination);
+
+  FILE *out = fopen(argv[3], "wb");
+  if (!out || fwrite(image.data(), 1, length, out) != length) {
+    perror(argv[3]);
+    return 1;
+  }
+  fclose(out);
+  return 0;
+}
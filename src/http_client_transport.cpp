@@ -0,0 +1,89 @@
+#include "http_transport.h"
+
+#include <HTTPClient.h>
+
+#define HEADER_MAX 3
+#define HEADER_VALUE_MAX 64
+
+/**
+ * @brief HttpTransport over the Arduino HTTPClient. HTTP/1.0 keeps the
+ * server from answering chunked, so the body can be streamed straight
+ * from the socket.
+ */
+class HttpClientTransport : public HttpTransport {
+public:
+  HttpClientTransport() : headerCount(0), remaining(-1), active(false) {}
+
+  int get(const char *url, const char *const *headerKeys, size_t count,
+          uint32_t timeoutMs) override {
+    end();
+    http.setTimeout(timeoutMs);
+    http.setConnectTimeout(timeoutMs);
+    http.useHTTP10(true);
+    if (!http.begin(url))
+      return HTTP_TRANSPORT_BAD_URL;
+    active = true;
+
+    headerCount = count < HEADER_MAX ? count : HEADER_MAX;
+    http.collectHeaders((const char **)headerKeys, headerCount);
+    int code = http.GET();
+    for (size_t i = 0; i < headerCount; i++) {
+      String value = code > 0 ? http.header(headerKeys[i]) : String();
+      strncpy(values[i], value.c_str(), HEADER_VALUE_MAX - 1);
+      values[i][HEADER_VALUE_MAX - 1] = '\0';
+    }
+    remaining = code > 0 ? http.getSize() : 0; // -1: fino alla chiusura
+    return code;
+  }
+
+  const char *header(size_t index) override {
+    return index < headerCount ? values[index] : "";
+  }
+
+  int read(uint8_t *buf, size_t size, uint32_t timeoutMs) override {
+    if (!active || remaining == 0)
+      return 0;
+    WiFiClient *stream = http.getStreamPtr();
+    if (!stream)
+      return HTTP_TRANSPORT_CONNECTION_LOST;
+
+    uint32_t start = millis();
+    while (!stream->available()) {
+      if (!stream->connected())
+        return remaining > 0 ? HTTP_TRANSPORT_TRUNCATED : 0;
+      if (millis() - start >= timeoutMs)
+        return HTTP_TRANSPORT_TIMEOUT;
+      delay(1);
+    }
+
+    size_t n = stream->available();
+    if (n > size)
+      n = size;
+    if (remaining > 0 && n > (size_t)remaining)
+      n = remaining;
+    int got = stream->read(buf, n);
+    if (got <= 0)
+      return HTTP_TRANSPORT_CONNECTION_LOST;
+    if (remaining > 0)
+      remaining -= got;
+    return got;
+  }
+
+  void end() override {
+    if (active)
+      http.end();
+    active = false;
+  }
+
+private:
+  HTTPClient http;
+  char values[HEADER_MAX][HEADER_VALUE_MAX];
+  size_t headerCount;
+  int remaining;
+  bool active;
+};
+
+HttpTransport &httpClientTransport() {
+  static HttpClientTransport transport;
+  return transport;
+}
@@ -0,0 +1,140 @@
+#include "http_fetch.h"
+
+#include <string.h>
+
+const char *fetchStatusName(FetchStatus status) {
+  switch (status) {
+  case FETCH_OK:
+    return "ok";
+  case FETCH_BAD_URL:
+    return "bad url";
+  case FETCH_CONNECT_FAILED:
+    return "connect failed";
+  case FETCH_HTTP_ERROR:
+    return "http error";
+  case FETCH_BODY_FAILED:
+    return "body failed";
+  case FETCH_PARSE_FAILED:
+    return "parse failed";
+  }
+  return "?";
+}
+
+// =================================================================
+// BODY READER
+// =================================================================
+
+BodyReader::BodyReader(HttpTransport &transport, int64_t deadlineUs,
+                       int64_t (*monoUs)())
+    : transport(transport), deadlineUs(deadlineUs), monoUs(monoUs),
+      tapFn(nullptr), pos(0), length(0), total(0), err(0), done(false) {}
+
+bool BodyReader::refill() {
+  if (done)
+    return false;
+
+  int64_t leftUs = deadlineUs - monoUs();
+  if (leftUs <= 0) {
+    err = HTTP_TRANSPORT_DEADLINE;
+    done = true;
+    return false;
+  }
+  // La singola lettura non può sforare la scadenza complessiva
+  uint32_t timeoutMs = FETCH_READ_TIMEOUT_MS;
+  if (leftUs / 1000 < timeoutMs)
+    timeoutMs = (uint32_t)(leftUs / 1000) + 1;
+
+  int n = transport.read(buf, sizeof(buf), timeoutMs);
+  if (n <= 0) {
+    if (n < 0)
+      err = (n == HTTP_TRANSPORT_TIMEOUT && monoUs() >= deadlineUs)
+                ? HTTP_TRANSPORT_DEADLINE
+                : n;
+    done = true;
+    return false;
+  }
+  if (tapFn)
+    tapFn(buf, n);
+  pos = 0;
+  length = n;
+  total += n;
+  return true;
+}
+
+int BodyReader::read() {
+  if (pos == length && !refill())
+    return -1;
+  return buf[pos++];
+}
+
+size_t BodyReader::readBytes(char *out, size_t want) {
+  size_t copied = 0;
+  while (copied < want) {
+    if (pos == length && !refill())
+      break;
+    size_t n = length - pos;
+    if (n > want - copied)
+      n = want - copied;
+    memcpy(out + copied, buf + pos, n);
+    pos += n;
+    copied += n;
+  }
+  return copied;
+}
+
+size_t BodyReader::readChunk(const char *&data) {
+  if (pos == length && !refill())
+    return 0;
+  data = (const char *)buf + pos;
+  size_t n = length - pos;
+  pos = length;
+  return n;
+}
+
+// =================================================================
+// FETCH
+// =================================================================
+
+FetchResult httpFetch(HttpTransport &transport, const char *url,
+                      BodyParser parser, void *context, int64_t (*monoUs)(),
+                      void (*tap)(const uint8_t *, size_t)) {
+  // Il Date header sincronizza l'orologio, gli altri guidano lo scheduler
+  static const char *const headerKeys[] = {"Date", "Retry-After",
+                                           "Cache-Control"};
+  FetchResult r = {};
+  r.sentUs = monoUs();
+
+  r.code = transport.get(url, headerKeys, 3, FETCH_READ_TIMEOUT_MS);
+  r.headersUs = monoUs();
+
+  if (r.code == HTTP_TRANSPORT_BAD_URL) {
+    r.status = FETCH_BAD_URL;
+  } else if (r.code <= 0) {
+    r.status = FETCH_CONNECT_FAILED;
+  } else {
+    strncpy(r.date, transport.header(0), sizeof(r.date) - 1);
+    r.hints.retryAfterS = parseRetryAfterSeconds(transport.header(1));
+    r.hints.maxAgeS = parseCacheControlMaxAge(transport.header(2));
+
+    if (r.code != 200) {
+      r.status = FETCH_HTTP_ERROR;
+    } else {
+      BodyReader body(transport, r.sentUs + FETCH_DEADLINE_MS * 1000LL,
+                      monoUs);
+      body.setTap(tap);
+      bool parsed = parser(body, context);
+      r.bodyBytes = body.bytesRead();
+      if (body.error()) {
+        // Il parser può fallire o no: con il corpo a metà non ci fidiamo
+        r.status = FETCH_BODY_FAILED;
+        r.code = body.error();
+      } else {
+        r.status = parsed ? FETCH_OK : FETCH_PARSE_FAILED;
+      }
+    }
+  }
+
+  transport.end();
+  r.doneUs = monoUs();
+  return r;
+}
@@ -0,0 +1,411 @@
+#include "lean_http.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool leanHttpParseUrl(const char *url, char *host, size_t hostSize,
+                      uint16_t &port, const char *&path) {
+  const char *p;
+  if (strncmp(url, "https://", 8) == 0) {
+    p = url + 8;
+    port = 443;
+  } else if (strncmp(url, "http://", 7) == 0) {
+    p = url + 7;
+    port = 80;
+  } else {
+    return false;
+  }
+
+  size_t n = strcspn(p, ":/?");
+  if (n == 0 || n >= hostSize)
+    return false;
+  memcpy(host, p, n);
+  host[n] = '\0';
+  p += n;
+
+  if (*p == ':') {
+    char *end;
+    unsigned long value = strtoul(p + 1, &end, 10);
+    if (end == p + 1 || value == 0 || value > 65535)
+      return false;
+    port = (uint16_t)value;
+    p = end;
+  }
+  path = *p ? p : "/";
+  return *path == '/' || *path == '?';
+}
+
+static bool equalsIgnoreCase(const char *a, const char *b, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i]))
+      return false;
+  }
+  return b[length] == '\0';
+}
+
+LeanHttpTransport::LeanHttpTransport(HttpSocket &socket)
+    : socket(socket), port(0), open(false), reusable(false), connects(0),
+      keys(nullptr), keyCount(0), bufPos(0), bufLen(0), status(0),
+      mode(BODY_NONE), chunkState(CHUNK_SIZE), remaining(0),
+      finished(true) {
+  host[0] = '\0';
+}
+
+// =================================================================
+// REQUEST & HEADERS
+// =================================================================
+
+int LeanHttpTransport::get(const char *url, const char *const *headerKeys,
+                           size_t headerCount, uint32_t timeoutMs) {
+  end();
+
+  char newHost[LEAN_HTTP_HOST_MAX];
+  uint16_t newPort;
+  const char *path;
+  if (!leanHttpParseUrl(url, newHost, sizeof(newHost), newPort, path) ||
+      strlen(path) >= LEAN_HTTP_PATH_MAX)
+    return HTTP_TRANSPORT_BAD_URL;
+
+  keys = headerKeys;
+  keyCount = headerCount < LEAN_HTTP_HEADERS_MAX ? headerCount
+                                                 : LEAN_HTTP_HEADERS_MAX;
+  for (size_t i = 0; i < LEAN_HTTP_HEADERS_MAX; i++)
+    values[i][0] = '\0';
+
+  bool sameHost = open && port == newPort && strcmp(host, newHost) == 0;
+  if (sameHost && reusable && socket.connected()) {
+    int code = request(path, timeoutMs);
+    // Il server può aver chiuso la connessione inattiva proprio ora:
+    // un solo nuovo tentativo su un socket fresco
+    if (code != HTTP_TRANSPORT_CONNECTION_LOST)
+      return code;
+  }
+
+  if (!reconnect(newHost, newPort, timeoutMs))
+    return HTTP_TRANSPORT_REFUSED;
+  return request(path, timeoutMs);
+}
+
+// Connessione aperta e pronta, senza richieste in corso: la prossima
+// get() allo stesso host la riusa
+bool LeanHttpTransport::prewarm(const char *url, uint32_t timeoutMs) {
+  end();
+  char newHost[LEAN_HTTP_HOST_MAX];
+  uint16_t newPort;
+  const char *path;
+  if (!leanHttpParseUrl(url, newHost, sizeof(newHost), newPort, path))
+    return false;
+  bool sameHost = open && port == newPort && strcmp(host, newHost) == 0;
+  if (sameHost && reusable && socket.connected())
+    return true;
+  if (!reconnect(newHost, newPort, timeoutMs))
+    return false;
+  reusable = true;
+  finished = true;
+  return true;
+}
+
+bool LeanHttpTransport::reconnect(const char *newHost, uint16_t newPort,
+                                  uint32_t timeoutMs) {
+  socket.stop();
+  open = false;
+  strcpy(host, newHost);
+  port = newPort;
+  if (!socket.connect(host, port, timeoutMs))
+    return false;
+  open = true;
+  connects++;
+  return true;
+}
+
+int LeanHttpTransport::request(const char *path, uint32_t timeoutMs) {
+  char head[LEAN_HTTP_PATH_MAX + LEAN_HTTP_HOST_MAX + 128];
+  int n = snprintf(head, sizeof(head),
+                   "GET %s HTTP/1.1\r\n"
+                   "Host: %s\r\n"
+                   "User-Agent: ESP32-Train-Board\r\n"
+                   "Accept-Encoding: identity\r\n"
+                   "Connection: keep-alive\r\n"
+                   "\r\n",
+                   path, host);
+  if (n <= 0 || (size_t)n >= sizeof(head))
+    return HTTP_TRANSPORT_BAD_URL;
+  if (socket.write((const uint8_t *)head, n) != n)
+    return HTTP_TRANSPORT_CONNECTION_LOST;
+
+  bufPos = bufLen = 0;
+  status = 0;
+  mode = BODY_CLOSE;
+  chunkState = CHUNK_SIZE;
+  remaining = 0;
+  reusable = true;
+  finished = false;
+  return readHeaders(timeoutMs);
+}
+
+/**
+ * @brief Reads and parses header lines as they arrive. Each line is
+ * handled and dropped, so the buffer only has to hold one at a time.
+ */
+int LeanHttpTransport::readHeaders(uint32_t timeoutMs) {
+  bool skipping = false; // Riga più lunga del buffer: la scartiamo
+  size_t lineStart = 0;
+  size_t scan = 0;
+
+  while (true) {
+    while (scan + 1 < bufLen) {
+      if (buf[scan] != '\r' || buf[scan + 1] != '\n') {
+        scan++;
+        continue;
+      }
+      char *line = (char *)buf + lineStart;
+      size_t length = scan - lineStart;
+      scan += 2;
+      lineStart = scan;
+      if (skipping) {
+        skipping = false;
+        continue;
+      }
+      if (length == 0) {
+        // Fine degli header: ciò che resta nel buffer è già corpo
+        bufPos = lineStart;
+        if (status == 204 || status == 304)
+          mode = BODY_NONE;
+        if (mode == BODY_LENGTH && remaining == 0)
+          mode = BODY_NONE;
+        finished = mode == BODY_NONE;
+        if (mode == BODY_CLOSE)
+          reusable = false;
+        return status;
+      }
+      line[length] = '\0';
+      if (!headerLine(line, length))
+        return HTTP_TRANSPORT_CONNECTION_LOST; // Risposta non HTTP
+    }
+
+    // Compatta: le righe già lette non servono più
+    if (lineStart > 0) {
+      memmove(buf, buf + lineStart, bufLen - lineStart);
+      bufLen -= lineStart;
+      scan -= lineStart;
+      lineStart = 0;
+    }
+    if (bufLen == sizeof(buf)) {
+      // Tiene l'ultimo byte: potrebbe essere il '\r' del terminatore
+      skipping = true;
+      buf[0] = buf[bufLen - 1];
+      bufLen = 1;
+      scan = 0;
+    }
+
+    int n = socket.read(buf + bufLen, sizeof(buf) - bufLen, timeoutMs);
+    if (n <= 0)
+      return n == 0 ? HTTP_TRANSPORT_CONNECTION_LOST : n;
+    bufLen += n;
+  }
+}
+
+bool LeanHttpTransport::headerLine(char *line, size_t length) {
+  if (status == 0) {
+    // "HTTP/1.1 200 OK"
+    if (length < 12 || strncmp(line, "HTTP/1.", 7) != 0)
+      return false;
+    status = atoi(line + 9);
+    if (line[7] == '0')
+      reusable = false; // HTTP/1.0: niente keep-alive implicito
+    return status > 0;
+  }
+
+  char *colon = strchr(line, ':');
+  if (!colon)
+    return true;
+  size_t nameLength = colon - line;
+  char *value = colon + 1;
+  while (*value == ' ' || *value == '\t')
+    value++;
+  size_t valueLength = strlen(value);
+  while (valueLength && (value[valueLength - 1] == ' '))
+    value[--valueLength] = '\0';
+
+  if (equalsIgnoreCase(line, "Content-Length", nameLength)) {
+    if (mode != BODY_CHUNKED) {
+      mode = BODY_LENGTH;
+      remaining = (uint32_t)strtoul(value, NULL, 10);
+    }
+  } else if (equalsIgnoreCase(line, "Transfer-Encoding", nameLength)) {
+    if (strstr(value, "chunked"))
+      mode = BODY_CHUNKED; // Ha la precedenza su Content-Length
+  } else if (equalsIgnoreCase(line, "Connection", nameLength)) {
+    if (strstr(value, "close"))
+      reusable = false;
+  }
+
+  for (size_t i = 0; i < keyCount; i++) {
+    if (equalsIgnoreCase(line, keys[i], nameLength)) {
+      size_t n = valueLength;
+      if (n > LEAN_HTTP_VALUE_MAX - 1)
+        n = LEAN_HTTP_VALUE_MAX - 1;
+      memcpy(values[i], value, n);
+      values[i][n] = '\0';
+    }
+  }
+  return true;
+}
+
+const char *LeanHttpTransport::header(size_t index) {
+  return index < keyCount ? values[index] : "";
+}
+
+// =================================================================
+// BODY
+// =================================================================
+
+/**
+ * @brief Next byte of the raw stream (buffer first, then the socket).
+ * @return The byte, or a negative HTTP_TRANSPORT_* code.
+ */
+int LeanHttpTransport::nextByte(uint32_t timeoutMs) {
+  if (bufPos == bufLen) {
+    int n = socket.read(buf, sizeof(buf), timeoutMs);
+    if (n <= 0)
+      return n == 0 ? HTTP_TRANSPORT_TRUNCATED : n;
+    bufPos = 0;
+    bufLen = n;
+  }
+  return buf[bufPos++];
+}
+
+/**
+ * @brief Raw body bytes: leftovers from the header read first, then
+ * straight from the socket into the caller's buffer.
+ */
+int LeanHttpTransport::readRaw(uint8_t *out, size_t size,
+                               uint32_t timeoutMs) {
+  if (bufPos < bufLen) {
+    size_t n = bufLen - bufPos;
+    if (n > size)
+      n = size;
+    memcpy(out, buf + bufPos, n);
+    bufPos += n;
+    return (int)n;
+  }
+  return socket.read(out, size, timeoutMs);
+}
+
+int LeanHttpTransport::readChunked(uint8_t *out, size_t size,
+                                   uint32_t timeoutMs) {
+  while (true) {
+    switch (chunkState) {
+    case CHUNK_SIZE: {
+      // "1a2f[;estensioni]\r\n"
+      uint32_t chunkSize = 0;
+      int digits = 0;
+      int c;
+      while ((c = nextByte(timeoutMs)) >= 0 && isxdigit(c)) {
+        int digit = isdigit(c) ? c - '0' : (c | 0x20) - 'a' + 10;
+        chunkSize = chunkSize * 16 + digit;
+        digits++;
+      }
+      while (c >= 0 && c != '\n')
+        c = nextByte(timeoutMs);
+      if (c < 0)
+        return c;
+      if (digits == 0)
+        return HTTP_TRANSPORT_CONNECTION_LOST;
+      remaining = chunkSize;
+      chunkState = chunkSize ? CHUNK_DATA : CHUNK_TRAILER;
+      break;
+    }
+    case CHUNK_DATA: {
+      size_t want = size < remaining ? size : remaining;
+      int n = readRaw(out, want, timeoutMs);
+      if (n <= 0)
+        return n == 0 ? HTTP_TRANSPORT_TRUNCATED : n;
+      remaining -= n;
+      if (remaining == 0)
+        chunkState = CHUNK_DATA_END;
+      return n;
+    }
+    case CHUNK_DATA_END: {
+      int c;
+      while ((c = nextByte(timeoutMs)) >= 0 && c != '\n')
+        ;
+      if (c < 0)
+        return c;
+      chunkState = CHUNK_SIZE;
+      break;
+    }
+    case CHUNK_TRAILER: {
+      // Eventuali trailer, poi la riga vuota finale
+      size_t lineLength = 0;
+      int c;
+      while ((c = nextByte(timeoutMs)) >= 0) {
+        if (c == '\n') {
+          if (lineLength == 0)
+            break;
+          lineLength = 0;
+        } else if (c != '\r') {
+          lineLength++;
+        }
+      }
+      if (c < 0)
+        return c;
+      finished = true;
+      return 0;
+    }
+    }
+  }
+}
+
+int LeanHttpTransport::read(uint8_t *out, size_t size, uint32_t timeoutMs) {
+  if (finished || !open)
+    return 0;
+
+  int n;
+  switch (mode) {
+  case BODY_LENGTH:
+    n = readRaw(out, size < remaining ? size : remaining, timeoutMs);
+    if (n == 0)
+      n = HTTP_TRANSPORT_TRUNCATED;
+    if (n > 0) {
+      remaining -= n;
+      finished = remaining == 0;
+    }
+    break;
+  case BODY_CHUNKED:
+    n = readChunked(out, size, timeoutMs);
+    break;
+  case BODY_CLOSE:
+    n = readRaw(out, size, timeoutMs);
+    if (n == 0)
+      finished = true;
+    break;
+  default:
+    n = 0;
+    finished = true;
+    break;
+  }
+  if (n < 0)
+    reusable = false;
+  return n;
+}
+
+void LeanHttpTransport::end() {
+  if (!open)
+    return;
+  if (!finished && reusable) {
+    // Il parser si ferma alla '}' finale: il terminatore dei chunk è
+    // quasi sempre già arrivato, leggerlo tiene viva la connessione
+    uint8_t scratch[64];
+    for (int i = 0; i < 8 && !finished; i++) {
+      if (read(scratch, sizeof(scratch), 50) < 0)
+        break;
+    }
+  }
+  if (!finished || !reusable) {
+    socket.stop();
+    open = false;
+  }
+}
@@ -0,0 +1,7 @@
+#include "lean_http.h"
+#include "tls_socket.h"
+
+HttpTransport &leanHttpsTransport() {
+  static LeanHttpTransport transport(tlsSocket());
+  return transport;
+}
@@ -0,0 +1,264 @@
+#include "log.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdio.h>
+
+// =================================================================
+// LOCK-FREE RING BUFFER
+// Bounded multi-producer / single-consumer queue: every slot carries a
+// sequence number, so producers on both cores (loop, WiFi events) only
+// need one compare-and-swap to reserve a slot and never take a lock.
+// =================================================================
+struct LogSlot {
+  std::atomic<uint32_t> seq;
+  LogRecord rec;
+};
+
+static LogSlot logRing[LOG_RING_SLOTS];
+static std::atomic<uint32_t> logHead(0);
+static uint32_t logTail = 0; // Solo il drain task la modifica
+static std::atomic<uint32_t> logDropped(0);
+static SemaphoreHandle_t logDrainMutex = NULL; // Serializza i consumer
+
+static const uint32_t LOG_RING_MASK = LOG_RING_SLOTS - 1;
+static_assert((LOG_RING_SLOTS & LOG_RING_MASK) == 0,
+              "LOG_RING_SLOTS must be a power of two");
+
+static bool logRingInit() {
+  for (uint32_t i = 0; i < LOG_RING_SLOTS; i++)
+    logRing[i].seq.store(i, std::memory_order_relaxed);
+  return true;
+}
+// Inizializzato prima di setup(), così anche i log precoci finiscono nel ring
+static bool logRingReady = logRingInit();
+
+static const uint32_t LOG_DRAIN_PERIOD_MS = 20;
+static const size_t LOG_LINE_SIZE = 256;
+
+uint32_t logMillis() { return millis(); }
+
+uint32_t logDroppedCount() {
+  return logDropped.load(std::memory_order_relaxed);
+}
+
+bool logPush(const LogRecord &rec) {
+  uint32_t pos = logHead.load(std::memory_order_relaxed);
+  LogSlot *slot;
+  for (;;) {
+    slot = &logRing[pos & LOG_RING_MASK];
+    uint32_t seq = slot->seq.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      if (logHead.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // Ring pieno: meglio perdere una riga che bloccare il chiamante
+      logDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = logHead.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Copia solo la parte usata degli argomenti
+  slot->rec.timestamp = rec.timestamp;
+  slot->rec.fmt = rec.fmt;
+  slot->rec.level = rec.level;
+  slot->rec.length = rec.length;
+  memcpy(slot->rec.args, rec.args, rec.length);
+  slot->seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+static bool logPop(LogRecord &out) {
+  LogSlot &slot = logRing[logTail & LOG_RING_MASK];
+  if (slot.seq.load(std::memory_order_acquire) != logTail + 1)
+    return false;
+  out = slot.rec;
+  slot.seq.store(logTail + LOG_RING_SLOTS, std::memory_order_release);
+  logTail++;
+  return true;
+}
+
+// =================================================================
+// DEFERRED FORMATTING
+// =================================================================
+
+/**
+ * @brief Expands a binary record into text, one conversion at a time.
+ * Length modifiers in the format string are ignored: the stored argument
+ * tag decides how the value is printed.
+ * @return Number of characters written to out (excluding terminator).
+ */
+static size_t logFormat(const LogRecord &rec, char *out, size_t size) {
+  static const char LEVEL_CHARS[] = "-EWIDV";
+  size_t n = snprintf(out, size, "[%6lu.%03lu][%c] ",
+                      (unsigned long)(rec.timestamp / 1000),
+                      (unsigned long)(rec.timestamp % 1000),
+                      LEVEL_CHARS[rec.level < 6 ? rec.level : 0]);
+
+  const uint8_t *arg = rec.args;
+  const uint8_t *argEnd = rec.args + rec.length;
+  const char *p = rec.fmt;
+
+  while (*p && n < size - 1) {
+    if (*p != '%') {
+      out[n++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[n++] = '%';
+      p += 2;
+      continue;
+    }
+
+    // Copia flags, larghezza e precisione; salta i modificatori di lunghezza
+    char spec[16];
+    size_t s = 0;
+    spec[s++] = *p++;
+    while (*p && strchr("-+ #0123456789.", *p) && s < sizeof(spec) - 4)
+      spec[s++] = *p++;
+    while (*p && strchr("hlLzjt", *p))
+      p++;
+    char conv = *p ? *p++ : 'd';
+
+    size_t room = size - n;
+    if (arg >= argEnd) {
+      n += snprintf(out + n, room, "?");
+    } else {
+      uint8_t tag = *arg++;
+      switch (tag) {
+      case LOG_ARG_I32:
+      case LOG_ARG_U32: {
+        uint32_t v;
+        memcpy(&v, arg, sizeof(v));
+        arg += sizeof(v);
+        spec[s] = conv;
+        spec[s + 1] = '\0';
+        if (conv == 'c' || conv == 'd' || conv == 'i')
+          n += snprintf(out + n, room, spec, (int)v);
+        else
+          n += snprintf(out + n, room, spec, (unsigned)v);
+        break;
+      }
+      case LOG_ARG_I64:
+      case LOG_ARG_U64: {
+        uint64_t v;
+        memcpy(&v, arg, sizeof(v));
+        arg += sizeof(v);
+        spec[s] = 'l';
+        spec[s + 1] = 'l';
+        spec[s + 2] = (conv == 'c') ? 'd' : conv;
+        spec[s + 3] = '\0';
+        if (tag == LOG_ARG_I64)
+          n += snprintf(out + n, room, spec, (long long)v);
+        else
+          n += snprintf(out + n, room, spec, (unsigned long long)v);
+        break;
+      }
+      case LOG_ARG_F64: {
+        double v;
+        memcpy(&v, arg, sizeof(v));
+        arg += sizeof(v);
+        spec[s] = strchr("eEfgG", conv) ? conv : 'g';
+        spec[s + 1] = '\0';
+        n += snprintf(out + n, room, spec, v);
+        break;
+      }
+      case LOG_ARG_STR: {
+        uint8_t len = *arg++;
+        const char *str = (const char *)arg;
+        arg += len + 1;
+        spec[s] = 's';
+        spec[s + 1] = '\0';
+        n += snprintf(out + n, room, spec, str);
+        break;
+      }
+      case LOG_ARG_PTR: {
+        const void *v;
+        memcpy(&v, arg, sizeof(v));
+        arg += sizeof(v);
+        n += snprintf(out + n, room, "%p", v);
+        break;
+      }
+      default:
+        arg = argEnd; // Record corrotto, smetti di leggere argomenti
+        break;
+      }
+    }
+    if (n >= size)
+      n = size - 1;
+  }
+
+  // Niente newline doppi: il formato può già terminare con '\n'
+  if (n > 0 && out[n - 1] == '\n')
+    n--;
+  out[n++] = '\n';
+  out[n] = '\0';
+  return n;
+}
+
+static void logDrainAll() {
+  static LogRecord rec;
+  static char line[LOG_LINE_SIZE + 1];
+  static uint32_t reportedDropped = 0;
+
+  if (!logDrainMutex)
+    return;
+  xSemaphoreTake(logDrainMutex, portMAX_DELAY);
+  while (logPop(rec)) {
+    size_t len = logFormat(rec, line, LOG_LINE_SIZE);
+    Serial.write((const uint8_t *)line, len);
+  }
+
+  uint32_t dropped = logDroppedCount();
+  if (dropped != reportedDropped) {
+    Serial.printf("[log] %lu records dropped\n",
+                  (unsigned long)(dropped - reportedDropped));
+    reportedDropped = dropped;
+  }
+  xSemaphoreGive(logDrainMutex);
+}
+
+static void logTask(void *) {
+  for (;;) {
+    logDrainAll();
+    vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+  }
+}
+
+/**
+ * @brief Starts the low-priority drain task. Records queued before this
+ * call are kept and printed as soon as the task runs.
+ */
+void logInit() {
+  (void)logRingReady;
+  logDrainMutex = xSemaphoreCreateMutex();
+
+  // Core 0, priorità minima: il loop() gira sul core 1 e non viene mai
+  // rallentato dalla seriale
+  xTaskCreatePinnedToCore(logTask, "log", 3072, NULL, tskIDLE_PRIORITY + 1,
+                          NULL, 0);
+}
+
+/**
+ * @brief Drains the ring synchronously (e.g. right before a restart).
+ */
+void logFlush() {
+  logDrainAll();
+  Serial.flush();
+}
+
+/**
+ * @brief Writes a large blob straight to the serial port. Debug only:
+ * this blocks for as long as the UART needs, so it's compiled out unless
+ * LOG_PAYLOAD_DUMP is set.
+ */
+void logDump(const char *label, const char *data, size_t length) {
+  logFlush();
+  Serial.printf("----- %s (%u bytes) -----\n", label, (unsigned)length);
+  Serial.write((const uint8_t *)data, length);
+  Serial.println("\n-----");
+}
@@ -1,15 +1,40 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
-#include <HTTPClient.h>
 #include <WiFi.h>
-#include <esp_wifi.h>
+#include <esp_heap_caps.h>
 #include <time.h>
 
-// Include your custom DMD library and a font
-#include "fonts/Arial14.h"
+// Fonts and icons (DMD font format, converted at boot if needed)
+#include "assets.h"
 #include "fonts/SystemFont5x7.h"
-#include <DMD32.h>
 #include <secrets.h>
+#if ASSETS_BUILTIN
+#include "fonts/Arial14.h"
+#include "icons.h"
+#endif
+
+#include "connectivity.h"
+#include "data_feed.h"
+#include "data_provider.h"
+#include "display.h"
+#include "display_bench.h"
+#include "fetch_aligner.h"
+#include "fetch_bench.h"
+#include "fetch_scheduler.h"
+#include "freshness.h"
+#include "http_fetch.h"
+#include "lean_http.h"
+#include "log.h"
+#include "packed_font.h"
+#include "panel.h"
+#include "panel_stress.h"
+#include "power.h"
+#include "relay.h"
+#include "scene.h"
+#include "snapshot.h"
+#include "tile_renderer.h"
+#include "time_source.h"
+#include "timetable.h"
+#include "tls_socket.h"
 
 // =================================================================
 // WIFI & API CONFIGURATION
@@ -25,14 +50,41 @@ const char *password = WIFI_PASSWORD;
 const char *apiUrl =
     "https://arduino-train-api.bitrey.it/departures/" TRAIN_STATION_CODE
     "?limit=5&key=" API_KEY;
+// Same request without departures, for the weather and station feeds
+const char *apiMetaUrl =
+    "https://arduino-train-api.bitrey.it/departures/" TRAIN_STATION_CODE
+    "?limit=0&key=" API_KEY;
+
+JsonApiProvider jsonProvider(leanHttpsTransport(), apiUrl, apiMetaUrl);
+
+// Departures source: the JSON API, or a GTFS-RT feed set in secrets.h
+#ifdef GTFS_RT_URL
+#ifndef GTFS_RT_STOP_ID
+#define GTFS_RT_STOP_ID TRAIN_STATION_CODE
+#endif
+#ifndef GTFS_RT_STATION_NAME
+#define GTFS_RT_STATION_NAME GTFS_RT_STOP_ID
+#endif
+GtfsRtProvider gtfsProvider(leanHttpTransport(), GTFS_RT_URL,
+                            GTFS_RT_STOP_ID, GTFS_RT_STATION_NAME,
+                            timeSourceUtcUs);
+DataProvider &departuresProvider = gtfsProvider;
+#else
+DataProvider &departuresProvider = jsonProvider;
+#endif
 
 // =================================================================
 // DISPLAY CONFIGURATION
 // =================================================================
 #define DISPLAYS_ACROSS 2
 #define DISPLAYS_DOWN 1
-DMD dmd(DISPLAYS_ACROSS,
-        DISPLAYS_DOWN); // Using default pins as per your README
+// Same default pins as DMD32 (see panel.h); the framebuffer is kept in
+// the panels' scan order and drawn through the DMD32-style Display
+PanelDriver panel(DISPLAYS_ACROSS, DISPLAYS_DOWN);
+// Frames recorded between beginFrame() and endFrame() are rasterized
+// per panel, on both cores from TILE_MIN_PARALLEL panels up
+TileRenderer tiles(panel.framebuffer());
+Display display(panel.framebuffer(), &tiles);
 
 #define TEXT_Y_POS 2     // Y position for Arial14 font
 #define TEXT_Y_SYS_POS 4 // Y position for System5x7 font
@@ -47,21 +99,67 @@ FontType currentFont = FONT_ARIAL_14;
 int currentYOffset = TEXT_Y_POS;
 
 // =================================================================
-// TIMER FOR DMD REFRESH ISR
+// TIME & DATA MANAGEMENT
 // =================================================================
-hw_timer_t *dmd_timer = NULL;
+const long fetchInterval = 5 * 60 * 1000;    // 5 minutes in milliseconds
+const long weatherInterval = 60 * 60 * 1000; // Il meteo cambia ogni ora
+const long fetchJitter = 30 * 1000;          // +-30 s per period
+
+// One feed per part of the screen, each with its own TTL, cache and
+// backoff; the station name is fetched once per boot. Phase from the
+// MAC + jitter: boards powered together don't fetch together
+DataFeed departuresFeed("departures", departuresProvider,
+                        SNAPSHOT_DEPARTURES, fetchInterval, fetchJitter);
+DataFeed weatherFeed("weather", jsonProvider, SNAPSHOT_WEATHER,
+                     weatherInterval, fetchJitter);
+DataFeed stationFeed("station", departuresProvider, SNAPSHOT_STATION,
+                     DATA_FEED_ONCE, fetchJitter);
+DataFeeds dataFeeds;
+
+// The departures fetch waits for the display: displayCycle() opens a
+// gate before the header scene (pre-warm) and one before the
+// departures (fetch), and loop() runs them between two scene ticks
+FetchAligner fetchAligner;
+enum FetchGate { GATE_NONE, GATE_PREWARM, GATE_FETCH };
+FetchGate fetchGate = GATE_NONE;
+uint32_t alignedFetches = 0;
+uint32_t prewarms = 0;
+uint32_t prewarmFailures = 0;
 
 // =================================================================
-// TIME & DATA MANAGEMENT
+// LAN RELAY
+// With RELAY_ROLE=RELAY_LEADER (platformio.ini) this board multicasts
+// every parsed response; RELAY_FOLLOWER boards show it instead of
+// calling the API, and fetch by themselves only if the leader is silent.
 // =================================================================
-unsigned long lastDataFetch = 0;
-const long fetchInterval = 5 * 60 * 1000; // 5 minutes in milliseconds
+#if RELAY_ROLE != RELAY_OFF
+RelayNode relay(relayWiFiLink(), RELAY_ROLE, (uint32_t)ESP.getEfuseMac(),
+                TRAIN_STATION_CODE, timeSourceUtcUs);
+uint32_t relaySequence = 0;
+#endif
+bool relayFeeding = false; // Il leader trasmette: niente fetch propri
+const unsigned long RELAY_POLL_INTERVAL = 500; // 0.5 secondi
+
+// =================================================================
+// FETCH HEAP REPORT
+// Free heap around each fetch. The low point is right after parsing,
+// with the TLS session alive. The providers parse straight into the
+// snapshot, so limit= in apiUrl no longer costs heap: the departures
+// kept are bounded by SNAPSHOT_MAX_DEPARTURES.
+// =================================================================
+const uint32_t FETCH_HEAP_RESERVE = 20 * 1024; // Per Wi-Fi, lwIP e log
+struct FetchHeap {
+  uint32_t freeBefore;
+  uint32_t freeAtPeak;   // Con la sessione TLS viva
+  uint32_t largestBlock; // Blocco contiguo più grande al picco
+};
+FetchHeap fetchHeap;
 
 // Timezone configuration for Italy (CET/CEST with automatic DST)
 const char *TZ_INFO = "CET-1CEST,M3.5.0,M10.5.0/3"; // Europe/Rome timezone
 
 // =================================================================
-// Local clock variables, synced from NTP with timezone
+// Local clock variables, synced from the API Date header with timezone
 // =================================================================
 int currentHour = 0;
 int currentMinute = 0;
@@ -73,6 +171,14 @@ int currentSecond = 0;
 String weatherString = "Loading...";
 String stationName = ""; // Station name from API
 
+// Ultimi dati live (fetch o relay): se mancano o sono troppo vecchi il
+// tabellone mostra l'orario programmato della partizione timetable
+bool liveData = false;
+unsigned long liveDataMs = 0;
+bool showingScheduled = false;
+// Dalla richiesta al primo frame, ed età delle partenze mostrate
+DataFreshness freshness;
+
 // =================================================================
 // Train data structure
 // =================================================================
@@ -85,7 +191,9 @@ struct TrainInfo {
 std::vector<TrainInfo> departures;
 
 // =================================================================
-// Display State Machine
+// Display scenes
+// Each scene is a coroutine run by sceneRunner; currentState only
+// records which one is on screen.
 // =================================================================
 enum DisplayState {
   STATE_SHOW_TIME,
@@ -94,95 +202,51 @@ enum DisplayState {
   STATE_SHOW_DEPARTURES
 };
 DisplayState currentState = STATE_SHOW_TIME;
-// DisplayState currentState = STATE_SHOW_DEPARTURES_HEADER; // debug
-unsigned long stateChangeTimestamp = 0;
-int currentTrainIndex = 0;
 
-// =================================================================
-// Train icon bitmap (16x16 pixels)
-// =================================================================
-const unsigned char trainIconBitmap[] PROGMEM = {
-    0xf0, 0x07, 0xc0, 0x03, 0x80, 0x01, 0x9e, 0x79, 0x9e, 0x79, 0x9e,
-    0x79, 0x9e, 0x79, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x98, 0x19,
-    0x98, 0x19, 0x88, 0x11, 0xc0, 0x03, 0xf3, 0xcf, 0xe7, 0xe7};
+static uint32_t sceneMillis() { return millis(); }
+static uint32_t sceneMicros() { return micros(); }
+SceneRunner sceneRunner(sceneMillis, sceneMicros);
+SceneStats displayCycleStats("cycle");
+SceneStats indicatorStats("indicator");
 
 // =================================================================
-// DMD REFRESH ISR
-// This function is called by a hardware timer to refresh the display
+// FONTS & ICONS
+// Packed fonts in the asset partition (see loadAssets()); the train
+// icon is 16x16 pixels.
 // =================================================================
-void IRAM_ATTR triggerScan() { dmd.scanDisplayBySPI(); }
+PackedFont fontLarge;
+PackedFont fontSmall;
+uint32_t trainIconRows[16];
+Sprite trainIcon = {};
 
 // =================================================================
 // Constanti
 // =================================================================
 const unsigned long TIME_DISPLAY_DURATION = 10000; // 10 secondi
 const unsigned long INFO_HOLD_DURATION = 2500;     // 2.5 secondi
-
-// =================================================================
-// WIFI CONNECTION - ROBUST VERSION
-// =================================================================
-bool connectToWiFiRobust(int maxRetries = 3) {
-  for (int retry = 0; retry < maxRetries; retry++) {
-    Serial.printf("\n=== WiFi Connection Attempt %d/%d ===\n", retry + 1,
-                  maxRetries);
-
-    // FULL reset del WiFi stack
-    WiFi.disconnect(true);
-    WiFi.mode(WIFI_OFF);
-    delay(1000);
-
-    // Riaccendi WiFi
-    WiFi.mode(WIFI_STA);
-    WiFi.setHostname("ESP32-Train-Board"); // Imposta hostname
-
-    // Power management aggressivo per stabilità
-    esp_wifi_set_ps(WIFI_PS_NONE); // Disabilita power saving
-
-    WiFi.begin(ssid, password);
-
-    // Attendi connessione
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-      delay(500);
-      Serial.print(".");
-      attempts++;
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("\nConnected!");
-      Serial.printf("IP: %s\n", WiFi.localIP().toString().c_str());
-      Serial.printf("RSSI: %d dBm\n", WiFi.RSSI());
-
-      // Forza DNS multipli
-      IPAddress dns1(8, 8, 8, 8);
-      IPAddress dns2(1, 1, 1, 1);
-      WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE, dns1, dns2);
-
-      delay(2000); // Dai tempo al DNS di inizializzare
-
-      Serial.printf("DNS1: %s\n", WiFi.dnsIP(0).toString().c_str());
-      Serial.printf("DNS2: %s\n", WiFi.dnsIP(1).toString().c_str());
-
-      return true;
-    }
-
-    Serial.println("\n✗ Failed, retrying...");
-    delay(2000);
-  }
-
-  return false;
-}
+const unsigned long STATS_DUMP_INTERVAL = 60000;   // 1 minuto
+const unsigned long LIVE_DATA_MAX_AGE = 15 * 60000; // 15 minuti
 
 // =================================================================
 // FORWARD DECLARATIONS
 // =================================================================
 void setFont(FontType font);
-void fetchData();
-void displayScrollingText(const String &text, int left = (32 * DISPLAYS_ACROSS),
-                          int top = -1);
-void animateSlideUp(const String &outgoingText, const String &incomingText);
-void animateTrainSlideUp(const TrainInfo *outgoingTrain,
-                         const TrainInfo *incomingTrain);
+void loadAssets();
+uint8_t fetchData(Snapshot &snap, uint8_t only);
+void runFetch(uint8_t only);
+void runFetchGate();
+void applySnapshot(const Snapshot &snap, uint8_t fields = SNAPSHOT_ALL);
+void markLiveData();
+void dumpFeedStats();
+void logDataTimeline();
+void drawStaleMarker();
+void applyTimetable(int minuteOfDay);
+SceneTask displayCycle();
+SceneTask connectivityIndicator();
+SceneTask scrollText(String text, int left = (32 * DISPLAYS_ACROSS),
+                     int top = -1);
+SceneTask animateSlideUp(String outgoingText, String incomingText);
+SceneTask animateTrainSlideUp(TrainInfo outgoingTrain, TrainInfo incomingTrain);
 
 // =================================================================
 // SETUP
@@ -190,243 +254,337 @@ void animateTrainSlideUp(const TrainInfo *outgoingTrain,
 void setup() {
   Serial.begin(115200);
   delay(1000);
+  logInit();
 
-  Serial.println("\n\n=== Train Board Starting ===");
-
-  // Connessione robusta
-  if (!connectToWiFiRobust(3)) {
-    Serial.println("\n!!! FATAL: Cannot connect to WiFi !!!");
-    Serial.println("Restarting in 10 seconds...");
-    delay(10000);
-    ESP.restart();
-  }
+  LOG_I("=== Train Board Starting ===");
+  powerInit();
 
-  // Configure the timer (but don't start it yet)
-  dmd_timer = timerBegin(40000); // 40kHz timer frequency
-
-  if (dmd_timer) {
-    // Attach the ISR function to the timer
-    timerAttachInterrupt(dmd_timer, &triggerScan);
-    Serial.println("DMD refresh timer configured");
-  }
+  // Buffer TLS allocati subito, finché l'heap non è frammentato
+  tlsSocket();
+  timetableFlash(TRAIN_STATION_CODE); // Mappata una volta sola
+  loadAssets();
+#if DISPLAY_BENCH
+  displayBenchRun();
+#endif
 
-  // Initialize the display BEFORE starting the timer
-  dmd.clearScreen(true);
+  // Connessione in background: il primo fetch parte appena c'è l'IP
+  connectivityBegin(ssid, password, "ESP32-Train-Board");
+  dataFeeds.add(departuresFeed);
+  dataFeeds.add(weatherFeed);
+  dataFeeds.add(stationFeed);
+  dataFeeds.begin(millis(), ESP.getEfuseMac(), esp_random());
+  LOG_I("Fetch phase: %lu s",
+        (unsigned long)(departuresFeed.phaseMs() / 1000));
+
+  // Initialize the display BEFORE starting the refresh timer
+  if (!panel.begin())
+    LOG_E("Panel driver not started");
+#if TILE_WORKERS > 1
+  tileWorkerStart(tiles);
+#endif
+  display.clearScreen(true);
   delay(100);
 
   // =================================================================
-  // TIMEZONE & NTP SETUP
+  // TIMEZONE & CLOCK SETUP
   // =================================================================
-  // Configure the ESP32's internal NTP client.
-  configTime(0, 0, "pool.ntp.org");
-
-  // Set the timezone environment variable.
-  setenv("TZ", TZ_INFO, 1);
-  tzset();
-  Serial.println(
-      "Timezone configured for Europe/Rome (CET/CEST with automatic DST)");
-
-  // Wait for the time to be synchronized.
-  struct tm timeinfo;
-  Serial.print("Waiting for NTP time sync");
-  while (!getLocalTime(&timeinfo)) {
-    Serial.print(".");
-    delay(1000);
-  }
-  Serial.println("\nTime synchronized!");
-
-  // Now that we have the time, get the initial values.
-  getLocalTime(&timeinfo); // Call it again to populate the struct
-  currentHour = timeinfo.tm_hour;
-  currentMinute = timeinfo.tm_min;
-  currentSecond = timeinfo.tm_sec;
-  Serial.printf("Initial time: %02d:%02d:%02d\n", currentHour, currentMinute,
-                currentSecond);
-
-  // Fetch initial data BEFORE starting the timer
-  fetchData();
-
-  // Start the timer at the END of setup (as per demo)
-  if (dmd_timer) {
-    timerAlarm(dmd_timer, 12, true, 0);
-    Serial.println("DMD refresh timer started");
-  }
+  // The clock is seeded from the Date header of the first API response;
+  // NTP is optional (USE_NTP) and never waited on.
+  timeSourceInit(TZ_INFO);
+  LOG_I("Timezone configured for Europe/Rome (CET/CEST with automatic DST)");
+
+  // Start the refresh timer at the END of setup (as per demo); its ISR
+  // runs from IRAM, see panel.h
+  powerAcquireScanLock(); // APB stabile finché il refresh è attivo
+  if (panel.start())
+    LOG_I("Panel refresh timer started");
+#if PANEL_STRESS
+  panelStressRun(panel);
+#endif
 
-  // Set the starting timestamp for the first state
-  stateChangeTimestamp = millis();
+  // Start the display cycle and the Wi-Fi indicator next to it
+  sceneRunner.add(displayCycleStats, displayCycle());
+  sceneRunner.add(indicatorStats, connectivityIndicator());
 }
 
 // =================================================================
 // MAIN LOOP
 // =================================================================
 void loop() {
-  // Check WiFi health ogni tanto
-  static unsigned long lastWiFiCheck = 0;
-  if (millis() - lastWiFiCheck > 30000) { // Ogni 30 secondi
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("!!! WiFi disconnected in loop !!!");
-      if (!connectToWiFiRobust(2)) {
-        Serial.println("Cannot recover, restarting...");
-        delay(5000);
-        ESP.restart();
-      }
-    }
-    lastWiFiCheck = millis(); // Aggiorna DOPO il check
+  connectivityPoll();
+
+  // Check if it's time to fetch new data. Without a link the fetch stays
+  // due and runs as soon as the connection comes back.
+#if FETCH_BENCH
+  static bool benchDone = false;
+  if (!benchDone && connectivityUp()) {
+    PowerBoost boost;
+    fetchBenchRun(apiUrl);
+    benchDone = true;
   }
+#endif
 
-  // Check if it's time to fetch new data
-  if (millis() - lastDataFetch >= fetchInterval) {
-    fetchData();
+  // Un fetch delle partenze che scade prima del prossimo tabellone lo
+  // aspetta, al cancello aperto da displayCycle()
+  uint8_t fetchable = SNAPSHOT_ALL;
+  if (fetchAligner.hold(millis(), departuresFeed.nextFetchMs()))
+    fetchable &= ~SNAPSHOT_DEPARTURES;
+  bool fetchDue = dataFeeds.due(millis(), fetchable);
+#if RELAY_ROLE == RELAY_FOLLOWER
+  // Finché il leader trasmette il fetch resta in sospeso: parte da solo
+  // appena il leader tace
+  if (relay.poll(millis())) {
+    // Il leader ha l'ora dal Date header: latenza LAN trascurabile
+    timeSourceFromReference(relay.latest().utcUs, timeSourceMonoUs(), 600000);
+    applySnapshot(relay.latest());
+    markLiveData();
+    // Richiesta del leader sconosciuta: l'età parte dalla ricezione
+    int64_t nowUs = timeSourceMonoUs();
+    freshness.onData({nowUs, nowUs, nowUs, 0, timeSourceUtcUs()});
+    LOG_I("Relay snapshot #%lu applied",
+          (unsigned long)relay.latest().sequence);
+  }
+  relayFeeding = !relay.silent(millis());
+#endif
+  if (fetchGate != GATE_NONE) {
+    if (connectivityUp() && !relayFeeding)
+      runFetchGate();
+    fetchGate = GATE_NONE;
+  }
+  if (fetchDue && connectivityUp() && !relayFeeding) {
+    runFetch(fetchable);
+    fetchDue = dataFeeds.due(millis(), fetchable); // Un altro provider
+    LOG_D("Next fetch in %ld s",
+          (long)(dataFeeds.nextFetchMs(millis(), fetchable) - millis()) /
+              1000);
   }
 
-  // Get local time with timezone applied
+#if RELAY_ROLE == RELAY_LEADER
+  relay.poll(millis()); // Ripete l'ultimo snapshot per chi si è perso
+#endif
+
+  // Get local time with timezone applied (non-blocking)
   struct tm timeinfo;
-  if (getLocalTime(&timeinfo)) {
+  if (timeSourceLocalTime(&timeinfo)) {
     currentHour = timeinfo.tm_hour;
     currentMinute = timeinfo.tm_min;
     currentSecond = timeinfo.tm_sec;
   }
 
-  // Run the display state machine
-
-  switch (currentState) {
-  case STATE_SHOW_TIME: {
-    // Variabili statiche che mantengono lo stato tra le chiamate al loop
-    static unsigned long enterTime = 0;
-    static bool firstEntry = true;
-    static int lastDisplayedSecond = -1;
-
-    // Entrata nello stato (una volta sola)
-    if (stateChangeTimestamp != 0) {
-      enterTime = millis();     // Salva quando siamo entrati
-      stateChangeTimestamp = 0; // Reset del flag
-      firstEntry = true;        // Marca come prima entry
-      lastDisplayedSecond = -1; // Forza ridisegno immediato
-      dmd.clearScreen(true);    // Pulisci schermo
-      setFont(FONT_ARIAL_14);   // Imposta font grande
-      Serial.println("Entered STATE_SHOW_TIME");
-    }
+  // Senza dati live recenti, l'orario programmato (ricalcolato solo al
+  // cambio di minuto: le scene leggono departures come sempre)
+  if (!liveData || millis() - liveDataMs >= LIVE_DATA_MAX_AGE) {
+    if (timeSourceSynced())
+      applyTimetable(currentHour * 60 + currentMinute);
+  }
+
+  // Run the display scenes (non-blocking: each one yields back here)
+  sceneRunner.tick();
+
+  static unsigned long lastStatsDump = 0;
+  if (millis() - lastStatsDump >= STATS_DUMP_INTERVAL) {
+    sceneRunner.dumpStats();
+    powerDumpStats();
+    connectivityDumpStats();
+    panel.dumpStats();
+    dumpFeedStats();
+#if RELAY_ROLE != RELAY_OFF
+    LOG_I("Relay: sent %lu, received %lu, rejected %lu",
+          (unsigned long)relay.sentCount(),
+          (unsigned long)relay.receivedCount(),
+          (unsigned long)relay.rejectedCount());
+#endif
+    lastStatsDump = millis();
+  }
+
+  // Dormi fino alla prossima scadenza (frame, fetch, statistiche) invece
+  // di girare a vuoto; gli eventi WiFi svegliano il loop in anticipo
+  uint32_t deadline = sceneRunner.nextWakeMs();
+  uint32_t deadlines[] = {(uint32_t)(lastStatsDump + STATS_DUMP_INTERVAL),
+                          (uint32_t)(millis() + RELAY_POLL_INTERVAL),
+                          dataFeeds.nextFetchMs(millis(), fetchable)};
+  int count = RELAY_ROLE == RELAY_OFF ? 1 : 2;
+  // Con un fetch in attesa di rete (o del leader) la scadenza è già
+  // passata: ci sveglia l'evento di connessione o il poll del relay
+  if (!fetchDue)
+    deadlines[count++] = dataFeeds.nextFetchMs(millis(), fetchable);
+  for (int i = 0; i < count; i++) {
+    if ((int32_t)(deadlines[i] - deadline) < 0)
+      deadline = deadlines[i];
+  }
+  powerIdleUntil(deadline);
+}
 
-    // Aggiornamento dell'ora (ogni secondo)
+// =================================================================
+// SCENES
+// =================================================================
+
+/**
+ * @brief Shows the clock, redrawing only when the second changes.
+ */
+SceneTask showTimeScene() {
+  static SceneStats stats("time");
+  SceneScope scope(stats);
+  currentState = STATE_SHOW_TIME;
+  LOG_D("Entered STATE_SHOW_TIME");
+
+  unsigned long enterTime = millis();
+  int lastDisplayedSecond = -1; // Forza ridisegno immediato
+  bool firstEntry = true;
+  display.clearScreen(true);
+  setFont(FONT_ARIAL_14); // Imposta font grande
+
+  while (millis() - enterTime <= TIME_DISPLAY_DURATION) {
     // Ridisegna solo se il secondo è cambiato
     if (currentSecond != lastDisplayedSecond) {
-      dmd.clearScreen(true);
+      display.beginFrame();
+      display.clearScreen(true);
 
       // Crea la stringa dell'ora formato HH:MM:SS
       char timeBuffer[9];
-      sprintf(timeBuffer, "%02d:%02d:%02d", currentHour, currentMinute,
-              currentSecond);
+      if (timeSourceSynced()) {
+        sprintf(timeBuffer, "%02d:%02d:%02d", currentHour, currentMinute,
+                currentSecond);
+      } else {
+        strcpy(timeBuffer, "--:--:--"); // Ora non ancora disponibile
+      }
 
       // Disegna l'ora al centro (circa)
-      dmd.drawString(10, currentYOffset, timeBuffer, strlen(timeBuffer),
-                     GRAPHICS_NORMAL);
+      display.drawString(10, currentYOffset, timeBuffer, strlen(timeBuffer),
+                         BLIT_NORMAL);
+      display.endFrame();
 
-      lastDisplayedSecond =
-          currentSecond; // Ricorda quale secondo abbiamo mostrato
+      lastDisplayedSecond = currentSecond;
 
       if (firstEntry) {
-        Serial.printf("Displaying time: %s\n", timeBuffer);
+        LOG_D("Displaying time: %s", timeBuffer);
         firstEntry = false;
       }
     }
 
-    // Uscita dallo stato (dopo 10 secondi)
-    if (millis() - enterTime > TIME_DISPLAY_DURATION) {
-      Serial.println("Time display duration elapsed, moving to weather");
-      currentState = STATE_SHOW_WEATHER;
-      stateChangeTimestamp = millis(); // Segnala cambio stato
-      lastDisplayedSecond = -1;        // Reset per la prossima volta
-    }
-    break;
+    // Nulla da fare fino al prossimo secondo
+    co_await sleepFor(timeSourceMsToNextSecond());
   }
 
-  case STATE_SHOW_WEATHER: {
-    // Per il meteo, lo scroll va ancora bene perché può essere lungo
-    setFont(FONT_ARIAL_14); // Ensure normal font for weather
-    dmd.clearScreen(true);
-    displayScrollingText(weatherString);
-    currentState = STATE_SHOW_DEPARTURES_HEADER;
-    stateChangeTimestamp = millis();
-    break;
-  }
+  LOG_D("Time display duration elapsed, moving to weather");
+}
 
-  case STATE_SHOW_DEPARTURES_HEADER: {
-    dmd.clearScreen(true);
-    delay(50); // Brief pause to ensure clear completes
-    setFont(FONT_SYSTEM_5X7);
+SceneTask showWeatherScene() {
+  static SceneStats stats("weather");
+  SceneScope scope(stats);
+  currentState = STATE_SHOW_WEATHER;
 
-    // Disegna l'icona del treno
-    dmd.drawBitmap(0, 0, trainIconBitmap, 16, 16, GRAPHICS_NORMAL);
+  // Per il meteo, lo scroll va ancora bene perché può essere lungo
+  setFont(FONT_ARIAL_14); // Ensure normal font for weather
+  display.clearScreen(true);
+  co_await scrollText(weatherString);
+}
 
-    // Scroll the station name on the second line
-    String text = "Treni da " + (stationName.length() > 0 ? stationName : "CF");
-    displayScrollingText(text);
+SceneTask showDeparturesHeaderScene() {
+  static SceneStats stats("header");
+  SceneScope scope(stats);
+  currentState = STATE_SHOW_DEPARTURES_HEADER;
 
-    currentState = STATE_SHOW_DEPARTURES;
-    stateChangeTimestamp = millis();
-    break;
-  }
+  display.clearScreen(true);
+  co_await sleepFor(50); // Brief pause to ensure clear completes
+  setFont(FONT_SYSTEM_5X7);
 
-  case STATE_SHOW_DEPARTURES: {
-    if (departures.empty()) {
-      dmd.clearScreen(true);
-      dmd.drawString(2, 0, "Nessun", 6, GRAPHICS_NORMAL);
-      dmd.drawString(2, 8, "treno :(", 8, GRAPHICS_NORMAL);
-      delay(INFO_HOLD_DURATION);
-      currentState = STATE_SHOW_TIME;
-      // Usa un valore non-zero per triggerare il redraw dell'ora
-      stateChangeTimestamp = 1;
-      break;
-    }
+  // Disegna l'icona del treno
+  if (trainIcon.rows)
+    display.drawBitmap(0, 0, trainIcon, BLIT_NORMAL);
 
-    static int lastShownTrainIndex = -1;
+  // Scroll the station name on the second line
+  String text = (showingScheduled ? "Orario treni da " : "Treni da ") +
+                (stationName.length() > 0 ? stationName : "CF");
+  co_await scrollText(text);
+}
 
-    if (currentTrainIndex < departures.size()) {
-      setFont(FONT_SYSTEM_5X7); // Usa il font più piccolo
+SceneTask showDeparturesScene() {
+  static SceneStats stats("departures");
+  SceneScope scope(stats);
+  currentState = STATE_SHOW_DEPARTURES;
+
+  // Copia locale: un fetch può aggiornare departures durante l'animazione
+  std::vector<TrainInfo> trains = departures;
+  fetchAligner.onDeparturesShown(millis());
+  freshness.onShown(timeSourceMonoUs(), liveData && !showingScheduled);
+
+  if (trains.empty()) {
+    display.clearScreen(true);
+    display.drawString(2, 0, "Nessun", 6, BLIT_NORMAL);
+    display.drawString(2, 8, "treno :(", 8, BLIT_NORMAL);
+    co_await sleepFor(INFO_HOLD_DURATION);
+    co_return;
+  }
 
-      TrainInfo &train = departures[currentTrainIndex];
+  setFont(FONT_SYSTEM_5X7); // Usa il font più piccolo
 
-      // Se è il primo treno, mostralo direttamente senza animazione
-      if (lastShownTrainIndex == -1) {
-        dmd.clearScreen(true);
+  for (size_t i = 0; i < trains.size(); i++) {
+    TrainInfo &train = trains[i];
 
-        // Prima riga: destinazione
-        dmd.drawString(2, 0, train.destination.c_str(),
-                       train.destination.length(), GRAPHICS_NORMAL);
+    if (i == 0) {
+      // Il primo treno viene mostrato direttamente senza animazione
+      display.beginFrame();
+      display.clearScreen(true);
 
-        // Seconda riga: orario e ritardo
-        String timeAndDelay = train.departureTime + " " + train.delay;
-        dmd.drawString(TRAIN_DEP_TIME_X_OFFSET, 8, timeAndDelay.c_str(),
-                       timeAndDelay.length(), GRAPHICS_NORMAL);
+      // Prima riga: destinazione
+      display.drawString(2, 0, train.destination.c_str(),
+                         train.destination.length(), BLIT_NORMAL);
 
-        delay(INFO_HOLD_DURATION * 1.5);
-        lastShownTrainIndex = currentTrainIndex;
-        currentTrainIndex++;
-      } else {
-        // Anima dalla entry precedente a quella corrente
-        TrainInfo *prevTrain = &departures[lastShownTrainIndex];
-        animateTrainSlideUp(prevTrain, &train);
-
-        // Tieni ferma la nuova entry per un po'
-        delay(INFO_HOLD_DURATION * 1.5);
-        lastShownTrainIndex = currentTrainIndex;
-        currentTrainIndex++;
-      }
+      // Seconda riga: orario e ritardo
+      String timeAndDelay = train.departureTime + " " + train.delay;
+      display.drawString(TRAIN_DEP_TIME_X_OFFSET, 8, timeAndDelay.c_str(),
+                         timeAndDelay.length(), BLIT_NORMAL);
+      drawStaleMarker();
+      display.endFrame();
+      if (!showingScheduled && freshness.onRendered(timeSourceMonoUs()))
+        logDataTimeline();
+    } else {
+      // Anima dalla entry precedente a quella corrente
+      co_await animateTrainSlideUp(trains[i - 1], train);
+    }
 
-      // Se era l'ultimo treno, torna al font normale
-      if (currentTrainIndex >= departures.size()) {
-        setFont(FONT_ARIAL_14);
-      }
+    // Tieni ferma la entry per un po'
+    co_await sleepFor(INFO_HOLD_DURATION * 1.5);
+  }
 
-    } else {
-      currentState = STATE_SHOW_TIME;
-      // Usa un valore non-zero per triggerare il redraw dell'ora
-      stateChangeTimestamp = 1;
-      currentTrainIndex = 0;    // Reset per il prossimo ciclo
-      lastShownTrainIndex = -1; // Reset anche questo
+  // Dopo l'ultimo treno, torna al font normale
+  setFont(FONT_ARIAL_14);
+}
+
+/**
+ * @brief Blinks the top-right pixel while the Wi-Fi link is down. Runs as
+ * its own root scene, interleaved with the display cycle; the display
+ * composites the pixel over every frame the other scenes draw.
+ */
+SceneTask connectivityIndicator() {
+  const int x = 32 * DISPLAYS_ACROSS - 1;
+  bool lit = false;
+  for (;;) {
+    if (!connectivityUp()) {
+      lit = !lit;
+      display.setIndicator(x, 0, lit);
+    } else if (lit) {
+      lit = false;
+      display.setIndicator(x, 0, false);
     }
-    break;
+    co_await sleepFor(250);
   }
+}
+
+/**
+ * @brief The main display loop: time, weather, header, departures.
+ */
+SceneTask displayCycle() {
+  for (;;) {
+    co_await showTimeScene();
+    co_await showWeatherScene();
+    fetchGate = GATE_PREWARM; // loop() lo esegue prima del prossimo tick
+    co_await nextFrame();
+    co_await showDeparturesHeaderScene();
+    fetchGate = GATE_FETCH;
+    co_await nextFrame();
+    co_await showDeparturesScene();
   }
 }
 
@@ -434,6 +592,55 @@ void loop() {
 // HELPER FUNCTIONS
 // =================================================================
 
+/**
+ * @brief Attaches a packed font from the asset partition or, if it is
+ * missing, converts the compiled-in DMD font into the heap.
+ * @return false if neither is available.
+ */
+static bool loadFont(PackedFont &font, const char *name,
+                     const uint8_t *builtin) {
+  size_t size = 0;
+  const uint8_t *blob = assetsFlash().find(name, ASSET_FONT_PACKED, &size);
+  if (blob && font.attach(blob, size))
+    return true;
+  if (!builtin)
+    return false;
+  size = packedFontDmdSize(builtin);
+  uint8_t *copy = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  if (copy && packedFontFromDmd(builtin, copy, size) &&
+      font.attach(copy, size)) {
+    LOG_W("%s missing from the partition, converted the built-in (%u B)",
+          name, (unsigned)size);
+    return true;
+  }
+  heap_caps_free(copy);
+  return false;
+}
+
+/**
+ * @brief Points the fonts and icons at the asset partition, falling back
+ * to the compiled-in copies (System5x7 is always compiled in).
+ */
+void loadAssets() {
+  AssetBitmap icon = {};
+  bool found = assetsFlash().bitmap("icon/train", icon);
+#if ASSETS_BUILTIN
+  if (!found) {
+    icon = {16, 16, trainIconBitmap};
+    LOG_W("Train icon missing from the partition, using the built-in");
+  }
+  const uint8_t *arial = Arial_14;
+#else
+  const uint8_t *arial = nullptr;
+#endif
+  if (icon.bits && icon.width <= 32 && icon.height <= 16)
+    trainIcon = spriteFromBytes(icon.bits, icon.width, icon.height,
+                                trainIconRows);
+  loadFont(fontSmall, "glyphs/system5x7", System5x7);
+  if (!loadFont(fontLarge, "glyphs/arial14", arial))
+    fontLarge = fontSmall;
+}
+
 /**
  * @brief Changes the display font and updates the current Y offset.
  * @param font The font to switch to (FONT_ARIAL_14, or FONT_SYSTEM_5X7).
@@ -443,168 +650,349 @@ void setFont(FontType font) {
 
   switch (font) {
   case FONT_ARIAL_14:
-    dmd.selectFont(Arial_14);
+    display.selectFont(fontLarge);
     currentYOffset = TEXT_Y_POS;
     break;
   case FONT_SYSTEM_5X7:
-    dmd.selectFont(System5x7);
+    display.selectFont(fontSmall);
     currentYOffset = TEXT_Y_SYS_POS;
     break;
   }
 }
 
+#if LOG_PAYLOAD_DUMP
+static void logPayloadChunk(const uint8_t *data, size_t length) {
+  LOG_PAYLOAD("Payload", (const char *)data, length);
+}
+#endif
+
+static int64_t fetchMonoUs() { return timeSourceMonoUs(); }
+
+/**
+ * @brief Logs the heap low point of the last fetch and what is left
+ * above the reserve.
+ */
+static void logFetchHeap() {
+  const TlsStats &tls = tlsSocketStats();
+  uint32_t spare = fetchHeap.freeAtPeak > FETCH_HEAP_RESERVE
+                       ? fetchHeap.freeAtPeak - FETCH_HEAP_RESERVE
+                       : 0;
+  LOG_I("Heap: free %lu -> %lu at peak (largest block %lu)",
+        (unsigned long)fetchHeap.freeBefore,
+        (unsigned long)fetchHeap.freeAtPeak,
+        (unsigned long)fetchHeap.largestBlock);
+  LOG_I("Heap headroom: %lu B above the reserve; TLS handshake %lu ms%s, "
+        "fragment %lu",
+        (unsigned long)spare, (unsigned long)tls.lastHandshakeMs,
+        tls.lastResumed ? " (resumed)" : "",
+        (unsigned long)tls.fragmentLimit);
+}
+
 /**
- * @brief Fetches data from the API and parses the JSON response.
+ * @brief Fetches the due feeds in only, marks fresh departures as live
+ * and hands the result to the relay.
  */
-void fetchData() {
-  Serial.println("Fetching new data...");
+void runFetch(uint8_t only) {
+  static Snapshot snap; // ~700 byte, fuori dallo stack del loop
+  uint8_t refreshed = fetchData(snap, only);
+  if (refreshed & SNAPSHOT_DEPARTURES)
+    markLiveData();
+#if RELAY_ROLE == RELAY_LEADER
+  if (refreshed) {
+    snap.sequence = ++relaySequence;
+    relay.publish(snap, millis());
+  }
+#endif
+}
+
+/**
+ * @brief Runs the gate opened by displayCycle(): before the header
+ * scene, opens the connection if the departures fall due by the next
+ * departures scene; before the departures, runs the held fetch.
+ */
+void runFetchGate() {
+  uint32_t now = millis();
+  if (fetchGate == GATE_PREWARM) {
+    if (!fetchAligner.dueBeforeDepartures(now, departuresFeed.nextFetchMs()))
+      return;
+    PowerBoost boost; // Handshake TLS
+    prewarms++;
+    bool ok = departuresFeed.provider().prewarm(SNAPSHOT_DEPARTURES,
+                                                FETCH_READ_TIMEOUT_MS);
+    if (!ok)
+      prewarmFailures++;
+    LOG_D("Pre-warm %s in %lu ms", ok ? "done" : "failed",
+          (unsigned long)(millis() - now));
+  } else if (departuresFeed.due(now)) {
+    alignedFetches++;
+    runFetch(SNAPSHOT_ALL);
+  }
+}
+
+/**
+ * @brief Runs the request of the due data feeds (see DataFeeds::fetch())
+ * and puts the refreshed parts on screen.
+ * @param snap Filled with the merged feed caches, what the screen shows.
+ * @param only SnapshotField mask of the feeds that may be fetched.
+ * @return SnapshotField mask of the parts refreshed, 0 on failure.
+ */
+uint8_t fetchData(Snapshot &snap, uint8_t only) {
+  PowerBoost boost; // Frequenza massima per TLS e parsing
+  LOG_I("Fetching new data...");
 
   // Check WiFi PRIMA di tentare HTTP
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi not connected, skipping fetch");
+  if (!connectivityUp()) {
+    LOG_W("WiFi not connected, skipping fetch");
     weatherString = "WiFi Down";
-    return;
+    return 0;
   }
 
-  HTTPClient http;
-  http.setTimeout(15000); // Timeout esplicito
-
-  if (!http.begin(apiUrl)) { // Check se begin() fallisce
-    Serial.println("http.begin() failed (DNS?)");
+  memset(&fetchHeap, 0, sizeof(fetchHeap));
+  fetchHeap.freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#if LOG_PAYLOAD_DUMP
+  void (*tap)(const uint8_t *, size_t) = logPayloadChunk;
+#else
+  void (*tap)(const uint8_t *, size_t) = nullptr;
+#endif
+  uint8_t refreshed = 0;
+  FetchResult r =
+      dataFeeds.fetch(millis(), snap, refreshed, fetchMonoUs, tap, only);
+  fetchHeap.freeAtPeak = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  fetchHeap.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+  if (r.date[0])
+    timeSourceFromHttpDate(r.date, r.sentUs, r.headersUs);
+
+  switch (r.status) {
+  case FETCH_OK:
+    // Le parti non aggiornate restano quelle in cache nei feed
+    dataFeeds.merge(snap);
+    applySnapshot(snap, refreshed);
+    if (refreshed & SNAPSHOT_DEPARTURES) {
+      // Primo byte: status line e header (il body arriva subito dopo)
+      int64_t utcUs = timeSourceUtcUs();
+      if (utcUs)
+        utcUs -= timeSourceMonoUs() - r.sentUs;
+      freshness.onData({r.sentUs, r.headersUs, timeSourceMonoUs(), 0, utcUs});
+    }
+    LOG_I("Data parsed successfully (%s%s%s%u bytes, %lld ms)",
+          refreshed & SNAPSHOT_DEPARTURES ? "departures, " : "",
+          refreshed & SNAPSHOT_WEATHER ? "weather, " : "",
+          refreshed & SNAPSHOT_STATION ? "station, " : "", r.bodyBytes,
+          (r.doneUs - r.sentUs) / 1000);
+    if (r.code)
+      logFetchHeap();
+    return refreshed;
+  case FETCH_BAD_URL:
+    LOG_E("http.begin() failed (DNS?)");
     weatherString = "DNS Error";
-    http.end();
+    break;
+  case FETCH_CONNECT_FAILED:
+    LOG_E("[HTTP] GET... failed, error: %d", r.code);
+    weatherString = "Connection Failed";
+    break;
+  case FETCH_HTTP_ERROR:
+    LOG_E("[HTTP] GET... failed, code: %d", r.code);
+    weatherString = "HTTP Error " + String(r.code);
+    break;
+  case FETCH_BODY_FAILED:
+    LOG_E("Body interrupted after %u bytes (error %d)", r.bodyBytes, r.code);
+    weatherString = "Connection Failed";
+    break;
+  case FETCH_PARSE_FAILED:
+    weatherString = String(dataFeeds.lastProvider()->name()) + " Error";
+    break;
+  }
+  return 0;
+}
+
+/**
+ * @brief Replaces the displayed data with a snapshot (from the feeds or
+ * the relay).
+ * @param fields SnapshotField mask of the parts to replace.
+ */
+void applySnapshot(const Snapshot &snap, uint8_t fields) {
+  // Anche dopo un errore: la stringa del meteo torna quella in cache
+  weatherString = snap.weather;
+  if (fields & SNAPSHOT_STATION)
+    stationName = snap.stationName;
+  if (!(fields & SNAPSHOT_DEPARTURES))
     return;
+  departures.clear();
+  for (uint8_t i = 0; i < snap.count; i++) {
+    const DepartureRecord &d = snap.departures[i];
+    departures.push_back({d.type, d.destination, d.departureTime, d.delay});
   }
+}
 
-  Serial.print("Requesting URL: ");
-  Serial.println(apiUrl);
-  int httpCode = http.GET();
-
-  if (httpCode > 0) {
-    if (httpCode == HTTP_CODE_OK) {
-      String payload = http.getString();
-      Serial.println("Payload received:");
-      Serial.println(payload);
-
-      // Clear old train data
-      departures.clear();
-      departures.shrink_to_fit(); // Libera davvero la memoria
-
-      // Parse JSON
-      JsonDocument doc; // Allocate memory for the JSON object
-      DeserializationError error = deserializeJson(doc, payload);
-
-      if (error) {
-        Serial.print("deserializeJson() failed: ");
-        Serial.println(error.c_str());
-        weatherString = "JSON Error";
-        return;
-      }
+/**
+ * @brief Logs each data feed (refreshes, failures, age), the body
+ * bytes downloaded since boot extrapolated to a day, and the age of the
+ * departures when they are shown (with its histogram).
+ */
+void dumpFeedStats() {
+  uint32_t now = millis();
+  for (size_t i = 0; i < dataFeeds.size(); i++) {
+    const DataFeed &f = dataFeeds.feed(i);
+    LOG_I("Feed %s (%s): %lu ok, %lu failed, age %ld s",
+          f.name(), f.provider().name(), (unsigned long)f.refreshes(),
+          (unsigned long)f.failures(),
+          f.hasData() ? (long)(now - f.refreshedMs()) / 1000 : -1L);
+  }
+  uint64_t perDay = now ? dataFeeds.bodyBytes() * 86400000ULL / now : 0;
+  LOG_I("Feeds: %lu requests, %llu body bytes since boot (~%llu KB/day)",
+        (unsigned long)dataFeeds.requests(),
+        (unsigned long long)dataFeeds.bodyBytes(),
+        (unsigned long long)(perDay / 1024));
+
+  const DataAgeStats &age = freshness.ageStats();
+  LOG_I("Data age at display: last %lu s, mean %lu s, max %lu s "
+        "(%lu shown, %lu without live data)",
+        (unsigned long)age.lastMs / 1000,
+        (unsigned long)(age.shown ? age.sumMs / age.shown / 1000 : 0),
+        (unsigned long)age.maxMs / 1000, (unsigned long)age.shown,
+        (unsigned long)age.noData);
+  char histogram[128];
+  freshnessFormatHistogram(age, histogram, sizeof(histogram));
+  LOG_I("Data age histogram: %s", histogram);
+  LOG_I("Request to first frame: last %lu ms, max %lu ms",
+        (unsigned long)freshness.lastLatencyMs(),
+        (unsigned long)freshness.maxLatencyMs());
+  LOG_I("Cycle %lu ms; %lu fetches at the departures gate, %lu pre-warms "
+        "(%lu failed)",
+        (unsigned long)fetchAligner.cycleMs(), (unsigned long)alignedFetches,
+        (unsigned long)prewarms, (unsigned long)prewarmFailures);
+}
 
-      // Parse weather
-      String temp = doc["weather"]["temperature"];
-      String desc = doc["weather"]["description"];
-      temp.replace("^", "\xf8"); // Replace ^ with degree symbol if your font
-                                 // supports it (SystemFont5x7 does)
-      weatherString = temp + " - " + desc;
-
-      // Parse station name
-      const char *stationNameStr = doc["stationName"];
-      if (stationNameStr) {
-        stationName = String(stationNameStr);
-        Serial.print("Station name: ");
-        Serial.println(stationName);
-      }
+/**
+ * @brief Logs the timeline of the departures just drawn for the first
+ * time: when they were requested (local time) and the steps to the
+ * panel, in ms from the request.
+ */
+void logDataTimeline() {
+  const DataTimeline &t = freshness.timeline();
+  char at[12] = "--:--:--";
+  if (t.requestUtcUs) {
+    time_t secs = (time_t)(t.requestUtcUs / 1000000);
+    struct tm local;
+    localtime_r(&secs, &local);
+    strftime(at, sizeof(at), "%H:%M:%S", &local);
+  }
+  LOG_I("Departures on screen: requested %s, first byte +%lld ms, "
+        "parsed +%lld ms, drawn +%lld ms",
+        at, (t.firstByteUs - t.requestUs) / 1000,
+        (t.parsedUs - t.requestUs) / 1000,
+        (t.renderedUs - t.requestUs) / 1000);
+}
 
-      // Parse departures
-      JsonArray departuresArray = doc["departures"];
-      for (JsonObject train : departuresArray) {
-        TrainInfo newTrain;
-        newTrain.type = train["type"].as<String>();
-        newTrain.destination = "-> " + train["destination"].as<String>();
-        newTrain.departureTime = train["departureTime"].as<String>();
-        newTrain.delay = train["delay"].as<String>();
-        departures.push_back(newTrain);
-      }
+/**
+ * @brief Lights the bottom-right pixel of the frame being drawn when the
+ * live departures are older than FRESHNESS_STALE_MARKER_S.
+ */
+void drawStaleMarker() {
+#if FRESHNESS_STALE_MARKER_S
+  if (!liveData || showingScheduled)
+    return;
+  if (freshness.ageMs(timeSourceMonoUs()) < FRESHNESS_STALE_MARKER_S * 1000u)
+    return;
+  display.writePixel(32 * DISPLAYS_ACROSS - 1, 15, BLIT_NORMAL, true);
+#endif
+}
 
-      Serial.println("Data parsed successfully");
+/**
+ * @brief Records that the departures on screen are live.
+ */
+void markLiveData() {
+  liveData = true;
+  liveDataMs = millis();
+  showingScheduled = false;
+}
 
-    } else {
-      Serial.printf("[HTTP] GET... failed, error: %s\n",
-                    http.errorToString(httpCode).c_str());
-      weatherString = "HTTP Error " + String(httpCode);
-    }
-  } else {
-    Serial.printf("[HTTP] GET... failed, error: %s\n",
-                  http.errorToString(httpCode).c_str());
-    weatherString = "Connection Failed";
-  }
+/**
+ * @brief Shows the scheduled departures from minuteOfDay on, if the
+ * timetable partition has them. Does nothing within the same minute.
+ */
+void applyTimetable(int minuteOfDay) {
+  static int shownMinute = -1;
+  if (showingScheduled && minuteOfDay == shownMinute)
+    return;
+  const Timetable &table = timetableFlash(TRAIN_STATION_CODE);
+  if (!table.valid())
+    return;
 
-  http.end();
-  lastDataFetch = millis();
+  static Snapshot snap; // Solo le partenze: meteo e stazione restano
+  table.upcoming(minuteOfDay, snap);
+  departures.clear();
+  for (uint8_t i = 0; i < snap.count; i++) {
+    const DepartureRecord &d = snap.departures[i];
+    departures.push_back({d.type, d.destination, d.departureTime, d.delay});
+  }
+  if (!showingScheduled)
+    LOG_I("Live data missing or stale, showing the timetable");
+  showingScheduled = true;
+  shownMinute = minuteOfDay;
 }
 
 /**
  * @brief Displays a string of text scrolling from right to left.
- * This is a blocking function and will run until the text has scrolled off
- * screen.
+ * Completes when the text has scrolled off screen.
  * @param text The text to display.
  * @param left The left position where marquee starts (default: screen width).
  * @param top The top position where marquee is displayed (default:
  * currentYOffset).
  */
-void displayScrollingText(const String &text, int left, int top) {
+SceneTask scrollText(String text, int left, int top) {
   // Use currentYOffset if top is not specified
   int yPos = (top == -1) ? currentYOffset : top;
 
   // Clear before starting marquee
-  dmd.clearScreen(true);
-  delay(10); // Brief pause
-
-  dmd.drawMarquee(text.c_str(), text.length(), left, yPos);
-
-  long start = millis();
-  long timer = start;
-  bool ret = false;
-  while (!ret) {
-    // Check for Wi-Fi connection or other background tasks if needed
-    if ((millis() - timer) > 35) { // Control scroll speed
-      ret = dmd.stepMarquee(-1, 0);
-      timer = millis();
-    }
+  display.clearScreen(true);
+  co_await sleepFor(10); // Brief pause
+
+  display.drawMarquee(text.c_str(), text.length(), left, yPos);
+
+  // Control scroll speed
+  for (;;) {
+    co_await sleepFor(35);
+    display.beginFrame();
+    bool wrapped = display.stepMarquee(-1, 0);
+    display.endFrame();
+    if (wrapped)
+      break;
   }
 
   // Clear after marquee completes
-  dmd.clearScreen(true);
+  display.clearScreen(true);
 }
 
 /**
  * @brief Anima una transizione "slide up" tra due stringhe di testo.
  * @param outgoingText Il testo che sta uscendo dallo schermo (verso l'alto).
  * @param incomingText Il testo che sta entrando nello schermo (dal basso).
- * @param animSpeed Velocità dell'animazione in millisecondi (valore più basso =
- * più veloce).
  */
-void animateSlideUp(const String &outgoingText, const String &incomingText) {
+SceneTask animateSlideUp(String outgoingText, String incomingText) {
   const int animSpeed = 25;
   const int screenHeight = 16; // Altezza standard di un pannello DMD
 
   for (int y = 0; y <= screenHeight; y++) {
-    dmd.clearScreen(true);
+    display.beginFrame();
+    display.clearScreen(true);
 
     // Disegna il testo in uscita che scorre verso l'alto
     if (outgoingText.length() > 0) {
-      dmd.drawString(2, currentYOffset - y, outgoingText.c_str(),
-                     outgoingText.length(), GRAPHICS_NORMAL);
+      display.drawString(2, currentYOffset - y, outgoingText.c_str(),
+                         outgoingText.length(), BLIT_NORMAL);
     }
 
     // Disegna il testo in entrata che scorre dal basso
     if (incomingText.length() > 0) {
-      dmd.drawString(2, currentYOffset + screenHeight - y, incomingText.c_str(),
-                     incomingText.length(), GRAPHICS_NORMAL);
+      display.drawString(2, currentYOffset + screenHeight - y,
+                         incomingText.c_str(), incomingText.length(),
+                         BLIT_NORMAL);
     }
+    display.endFrame();
 
-    delay(animSpeed);
+    co_await sleepFor(animSpeed);
   }
 }
 
@@ -613,62 +1001,59 @@ void animateSlideUp(const String &outgoingText, const String &incomingText) {
  * @param outgoingTrain Il treno che sta uscendo dallo schermo (verso l'alto).
  * @param incomingTrain Il treno che sta entrando nello schermo (dal basso).
  */
-void animateTrainSlideUp(const TrainInfo *outgoingTrain,
-                         const TrainInfo *incomingTrain) {
+SceneTask animateTrainSlideUp(TrainInfo outgoingTrain,
+                              TrainInfo incomingTrain) {
   const int animSpeed = 20;    // Velocità dell'animazione in ms
   const int screenHeight = 16; // Altezza standard di un pannello DMD
 
   // Prepara le stringhe per entrambi i treni
-  String outDest = outgoingTrain ? outgoingTrain->destination : "";
-  String outTime =
-      outgoingTrain
-          ? (outgoingTrain->departureTime + " " + outgoingTrain->delay)
-          : "";
-
-  String inDest = incomingTrain ? incomingTrain->destination : "";
-  String inTime =
-      incomingTrain
-          ? (incomingTrain->departureTime + " " + incomingTrain->delay)
-          : "";
+  String outDest = outgoingTrain.destination;
+  String outTime = outgoingTrain.departureTime + " " + outgoingTrain.delay;
+
+  String inDest = incomingTrain.destination;
+  String inTime = incomingTrain.departureTime + " " + incomingTrain.delay;
 
   // Anima pixel per pixel
   for (int y = 0; y <= screenHeight; y++) {
-    dmd.clearScreen(true);
+    display.beginFrame();
+    display.clearScreen(true);
 
     // Disegna il treno in uscita che scorre verso l'alto
-    if (outgoingTrain && outDest.length() > 0) {
+    if (outDest.length() > 0) {
       // Destinazione (riga 1 -> sale)
       int outDestY = 0 - y;
       if (outDestY > -8) { // Solo se ancora visibile
-        dmd.drawString(2, outDestY, outDest.c_str(), outDest.length(),
-                       GRAPHICS_NORMAL);
+        display.drawString(2, outDestY, outDest.c_str(), outDest.length(),
+                           BLIT_NORMAL);
       }
 
       // Orario e ritardo (riga 2 -> sale)
       int outTimeY = 8 - y;
       if (outTimeY > -8 && outTimeY < screenHeight) { // Solo se ancora visibile
-        dmd.drawString(TRAIN_DEP_TIME_X_OFFSET, outTimeY, outTime.c_str(),
-                       outTime.length(), GRAPHICS_NORMAL);
+        display.drawString(TRAIN_DEP_TIME_X_OFFSET, outTimeY, outTime.c_str(),
+                           outTime.length(), BLIT_NORMAL);
       }
     }
 
     // Disegna il treno in entrata che scorre dal basso
-    if (incomingTrain && inDest.length() > 0) {
+    if (inDest.length() > 0) {
       // Destinazione (entra da sotto)
       int inDestY = screenHeight - y;
       if (inDestY < screenHeight && inDestY > -8) { // Solo se visibile
-        dmd.drawString(2, inDestY, inDest.c_str(), inDest.length(),
-                       GRAPHICS_NORMAL);
+        display.drawString(2, inDestY, inDest.c_str(), inDest.length(),
+                           BLIT_NORMAL);
       }
 
       // Orario e ritardo (entra da sotto, 8px più in basso)
       int inTimeY = (screenHeight + 8) - y;
       if (inTimeY < screenHeight && inTimeY > -8) { // Solo se visibile
-        dmd.drawString(TRAIN_DEP_TIME_X_OFFSET, inTimeY, inTime.c_str(),
-                       inTime.length(), GRAPHICS_NORMAL);
+        display.drawString(TRAIN_DEP_TIME_X_OFFSET, inTimeY, inTime.c_str(),
+                           inTime.length(), BLIT_NORMAL);
       }
     }
+    drawStaleMarker();
+    display.endFrame();
 
-    delay(animSpeed);
+    co_await sleepFor(animSpeed);
   }
 }
@@ -0,0 +1,115 @@
+#include "net_connect.h"
+
+#include <Arduino.h>
+#include <errno.h>
+#include <esp_netif.h>
+#include <lwip/dns.h>
+#include <lwip/sockets.h>
+#include <string.h>
+
+// =================================================================
+// DNS
+// dns_gethostbyname() gira nel task tcpip e richiama quando ha finito:
+// il loop aspetta la risposta al massimo fino alla scadenza. Una query
+// alla volta (solo il loop si connette); il numero scarta le risposte
+// arrivate dopo che il loop ha smesso di aspettarle.
+// =================================================================
+static volatile uint32_t dnsQuery = 0;
+static volatile bool dnsDone = false;
+static ip_addr_t dnsAddr;
+
+struct DnsStart {
+  const char *host;
+  err_t err;
+};
+
+static void dnsFound(const char *, const ip_addr_t *ip, void *arg) {
+  if ((uint32_t)(uintptr_t)arg != dnsQuery)
+    return;
+  if (ip)
+    dnsAddr = *ip;
+  else
+    ip_addr_set_zero(&dnsAddr);
+  dnsDone = true;
+}
+
+static esp_err_t dnsStart(void *context) {
+  DnsStart &start = *(DnsStart *)context;
+  start.err = dns_gethostbyname_addrtype(start.host, &dnsAddr, dnsFound,
+                                         (void *)(uintptr_t)dnsQuery,
+                                         LWIP_DNS_ADDRTYPE_IPV4);
+  return ESP_OK;
+}
+
+/**
+ * @brief IPv4 address of host (network order), 0 if unknown or not
+ * resolved by the deadline.
+ */
+static uint32_t resolve(const char *host, uint32_t start,
+                        uint32_t timeoutMs) {
+  ip4_addr_t literal;
+  if (ip4addr_aton(host, &literal))
+    return ip4_addr_get_u32(&literal);
+
+  dnsQuery = dnsQuery + 1;
+  dnsDone = false;
+  DnsStart query = {host, ERR_OK};
+  if (esp_netif_tcpip_exec(dnsStart, &query) != ESP_OK)
+    return 0;
+  if (query.err == ERR_INPROGRESS) {
+    while (!dnsDone && millis() - start < timeoutMs)
+      delay(5);
+    if (!dnsDone)
+      return 0;
+  } else if (query.err != ERR_OK) {
+    return 0;
+  }
+  return IP_IS_V4(&dnsAddr) ? ip4_addr_get_u32(ip_2_ip4(&dnsAddr)) : 0;
+}
+
+int netConnect(mbedtls_net_context *net, const char *host, uint16_t port,
+               uint32_t timeoutMs) {
+  uint32_t start = millis();
+  uint32_t addr = resolve(host, start, timeoutMs);
+  if (!addr)
+    return MBEDTLS_ERR_NET_UNKNOWN_HOST;
+
+  int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd < 0)
+    return MBEDTLS_ERR_NET_SOCKET_FAILED;
+  net->fd = fd;
+
+  struct sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(port);
+  to.sin_addr.s_addr = addr;
+
+  // Non bloccante per il SYN: select() aspetta al massimo il resto
+  mbedtls_net_set_nonblock(net);
+  int ret = ::connect(fd, (struct sockaddr *)&to, sizeof(to));
+  if (ret < 0 && errno == EINPROGRESS) {
+    uint32_t elapsed = millis() - start;
+    uint32_t left = elapsed < timeoutMs ? timeoutMs - elapsed : 0;
+    struct timeval tv = {(time_t)(left / 1000),
+                         (suseconds_t)(left % 1000) * 1000};
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(fd, &writable);
+    int error = ETIMEDOUT;
+    socklen_t size = sizeof(error);
+    if (select(fd + 1, NULL, &writable, NULL, &tv) == 1)
+      getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size);
+    ret = error == 0 ? 0 : -1;
+  }
+  if (ret < 0) {
+    mbedtls_net_free(net);
+    return MBEDTLS_ERR_NET_CONNECT_FAILED;
+  }
+  mbedtls_net_set_block(net);
+
+  // Un server che smette di leggere non blocca send() all'infinito
+  struct timeval sendTimeout = {(time_t)(timeoutMs / 1000),
+                                (suseconds_t)(timeoutMs % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+  return 0;
+}
@@ -0,0 +1,135 @@
+#include "packed_font.h"
+
+#include <string.h>
+
+PackedFont::PackedFont() : header(nullptr), glyphs(nullptr), rows(nullptr) {}
+
+bool PackedFont::attach(const uint8_t *data, size_t size) {
+  header = nullptr;
+  if (!data || ((uintptr_t)data & 3) || size < sizeof(PackedFontHeader))
+    return false;
+
+  const PackedFontHeader *h = (const PackedFontHeader *)data;
+  size_t rowsStart =
+      sizeof(PackedFontHeader) + h->charCount * sizeof(PackedGlyph);
+  if (h->magic[0] != PACKED_FONT_MAGIC0 ||
+      h->magic[1] != PACKED_FONT_MAGIC1 ||
+      h->version != PACKED_FONT_VERSION || size < rowsStart)
+    return false;
+
+  // Ogni glifo deve stare nel blob: dopo, glyph() non controlla più
+  const PackedGlyph *g = (const PackedGlyph *)(data + sizeof(*h));
+  size_t words = (size - rowsStart) / 4;
+  for (uint8_t i = 0; i < h->charCount; i++) {
+    if (g[i].width == 0)
+      continue;
+    if (g[i].wordsPerRow != (g[i].width + 31) / 32 ||
+        g[i].offset + (size_t)g[i].wordsPerRow * h->height > words)
+      return false;
+  }
+
+  header = h;
+  glyphs = g;
+  rows = (const uint32_t *)(data + rowsStart);
+  return true;
+}
+
+bool PackedFont::glyph(uint8_t c, GlyphBits &out) const {
+  if (!header || c < header->firstChar ||
+      c - header->firstChar >= header->charCount)
+    return false;
+  const PackedGlyph &g = glyphs[c - header->firstChar];
+  if (g.width == 0)
+    return false;
+  out.width = g.width;
+  out.height = header->height;
+  out.wordsPerRow = g.wordsPerRow;
+  out.rows = rows + g.offset;
+  return true;
+}
+
+int PackedFont::advance(uint8_t c) const {
+  GlyphBits g;
+  return glyph(c, g) ? g.width + header->spacing : 0;
+}
+
+int PackedFont::textWidth(const char *text, size_t length) const {
+  int width = 0;
+  for (size_t i = 0; i < length; i++)
+    width += advance((uint8_t)text[i]);
+  return width;
+}
+
+// =================================================================
+// DMD
+// Header: size u16 (0 = larghezza fissa) | width | height | first |
+// count | larghezze [count] se proporzionale | colonne di byte, LSB in
+// alto, una riga di byte ogni 8 pixel di altezza
+// =================================================================
+
+static uint8_t dmdWidth(const uint8_t *dmd, uint8_t c) {
+  bool proportional = dmd[0] != 0 || dmd[1] != 0;
+  return proportional ? dmd[6 + c] : dmd[2];
+}
+
+size_t packedFontDmdSize(const uint8_t *dmd) {
+  size_t words = 0;
+  for (uint8_t c = 0; c < dmd[5]; c++)
+    words += (dmdWidth(dmd, c) + 31) / 32 * dmd[3];
+  return sizeof(PackedFontHeader) + dmd[5] * sizeof(PackedGlyph) +
+         words * sizeof(uint32_t);
+}
+
+size_t packedFontFromDmd(const uint8_t *dmd, uint8_t *out, size_t size) {
+  bool proportional = dmd[0] != 0 || dmd[1] != 0;
+  uint8_t height = dmd[3];
+  uint8_t count = dmd[5];
+  int bytes = (height + 7) / 8;
+  const uint8_t *data = dmd + 6 + (proportional ? count : 0);
+  size_t length = packedFontDmdSize(dmd);
+  if (size < length || ((uintptr_t)out & 3))
+    return 0;
+
+  memset(out, 0, length);
+  PackedFontHeader *header = (PackedFontHeader *)out;
+  header->magic[0] = PACKED_FONT_MAGIC0;
+  header->magic[1] = PACKED_FONT_MAGIC1;
+  header->version = PACKED_FONT_VERSION;
+  header->height = height;
+  header->firstChar = dmd[4];
+  header->charCount = count;
+  header->spacing = 1;
+  PackedGlyph *glyphs = (PackedGlyph *)(out + sizeof(*header));
+  uint32_t *rows = (uint32_t *)(glyphs + count);
+
+  size_t offset = 0;
+  for (uint8_t c = 0; c < count; c++) {
+    uint8_t width = dmdWidth(dmd, c);
+    if (width == 0)
+      continue;
+    if (offset > 0xffff)
+      return 0;
+    PackedGlyph &g = glyphs[c];
+    g.width = width;
+    g.wordsPerRow = (width + 31) / 32;
+    g.offset = (uint16_t)offset;
+    uint32_t *glyph = rows + offset;
+    for (int page = 0; page < bytes; page++) {
+      // Come DMD32: l'ultima riga di byte è allineata al fondo del glifo
+      int top = page * 8;
+      if (page == bytes - 1 && bytes > 1)
+        top = height - 8;
+      for (int x = 0; x < width; x++) {
+        uint8_t column = data[page * width + x];
+        for (int k = 0; k < 8; k++) {
+          int y = top + k;
+          if (y >= page * 8 && y < height && (column & (1 << k)))
+            glyph[y * g.wordsPerRow + x / 32] |= 0x80000000u >> (x % 32);
+        }
+      }
+    }
+    data += width * bytes;
+    offset += (size_t)g.wordsPerRow * height;
+  }
+  return length;
+}
@@ -0,0 +1,175 @@
+#include "panel.h"
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <driver/gptimer.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+#include <soc/spi_struct.h>
+
+#include "log.h"
+
+static_assert(PANEL_PIN_NOE < 32 && PANEL_PIN_A < 32 && PANEL_PIN_B < 32 &&
+                  PANEL_PIN_LATCH < 32,
+              "scan() drives the control pins through GPIO_OUT_W1TS/W1TC");
+
+#define PIN_MASK(pin) (1u << (pin))
+
+// SPI (VSPI) del core Arduino è la periferica SPI3
+#define spiHw SPI3
+
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Come spiWriteNL(), ma in IRAM: al più 64 byte per transazione
+static inline void IRAM_ATTR spiSend(const uint8_t *data, size_t length) {
+  while (length) {
+    size_t chunk = length < 64 ? length : 64;
+    const uint32_t *src = (const uint32_t *)data; // Blocchi allineati a 16
+    for (size_t i = 0; i < chunk / 4; i++)
+      spiHw.data_buf[i] = src[i];
+    spiHw.mosi_dlen.usr_mosi_dbitlen = chunk * 8 - 1;
+    spiHw.miso_dlen.usr_miso_dbitlen = 0;
+    spiHw.cmd.usr = 1;
+    while (spiHw.cmd.usr) {
+    }
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+static bool IRAM_ATTR onScanAlarm(gptimer_handle_t,
+                                  const gptimer_alarm_event_data_t *,
+                                  void *driver) {
+  ((PanelDriver *)driver)->scan();
+  return false; // Nessun task da svegliare
+}
+
+PanelDriver::PanelDriver(int across, int down)
+    : across(across), down(down), words(nullptr),
+      fb(nullptr, 32 * across, 16 * down, FB_SCAN_ORDER), timer(nullptr),
+      scanBytes(nullptr), blockBytes(16 * across * down),
+      periodUs(PANEL_SCAN_PERIOD_US), lastScanUs(0), phase(0), window() {}
+
+PanelDriver::~PanelDriver() {
+  if (timer) {
+    gptimer_stop(timer);
+    gptimer_disable(timer);
+    gptimer_del_timer(timer);
+  }
+  heap_caps_free(words);
+}
+
+bool PanelDriver::begin() {
+  if (!words) {
+    // 64 byte per pannello, in RAM interna: la legge l'ISR anche a
+    // cache disattivata
+    words = (uint32_t *)heap_caps_malloc(
+        fb.size(), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!words) {
+      LOG_E("Panel: no memory for %d panels", panels());
+      return false;
+    }
+    fb = Framebuffer(words, 32 * across, 16 * down, FB_SCAN_ORDER);
+  }
+  fb.clear();
+
+  const uint8_t pins[] = {PANEL_PIN_NOE, PANEL_PIN_A, PANEL_PIN_B,
+                          PANEL_PIN_LATCH};
+  for (uint8_t pin : pins) {
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+  }
+  SPI.begin(PANEL_PIN_CLK, -1, PANEL_PIN_DATA, -1);
+  SPI.setFrequency(PANEL_SPI_HZ);
+  SPI.setDataMode(SPI_MODE0);
+  SPI.setBitOrder(MSBFIRST);
+  phase = 0;
+  scanBytes = fb.bytes(); // Da qui scan() è attivo
+  return true;
+}
+
+bool PanelDriver::start(uint32_t period) {
+  if (!scanBytes || timer)
+    return false;
+  periodUs = period;
+  gptimer_config_t config = {};
+  config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  config.direction = GPTIMER_COUNT_UP;
+  config.resolution_hz = 1000000;
+  gptimer_event_callbacks_t callbacks = {};
+  callbacks.on_alarm = onScanAlarm;
+  gptimer_alarm_config_t alarm = {};
+  alarm.alarm_count = period;
+  alarm.flags.auto_reload_on_alarm = true;
+  if (gptimer_new_timer(&config, &timer) != ESP_OK) {
+    timer = nullptr;
+    LOG_E("Panel: no free timer");
+    return false;
+  }
+  if (gptimer_register_event_callbacks(timer, &callbacks, this) != ESP_OK ||
+      gptimer_set_alarm_action(timer, &alarm) != ESP_OK ||
+      gptimer_enable(timer) != ESP_OK || gptimer_start(timer) != ESP_OK) {
+    LOG_E("Panel: refresh timer setup failed");
+    return false;
+  }
+#if !CONFIG_GPTIMER_ISR_IRAM_SAFE
+  LOG_W("Panel refresh stops during flash writes "
+        "(CONFIG_GPTIMER_ISR_IRAM_SAFE not set)");
+#endif
+  return true;
+}
+
+// Stessa sequenza di DMD32: dati, righe spente, latch, indirizzo
+// della riga (A, B), righe accese
+void IRAM_ATTR PanelDriver::scan() {
+  if (!scanBytes)
+    return;
+  int64_t start = esp_timer_get_time();
+  spiSend(scanBytes + phase * blockBytes, blockBytes);
+  REG_WRITE(GPIO_OUT_W1TC_REG, PIN_MASK(PANEL_PIN_NOE));
+  REG_WRITE(GPIO_OUT_W1TS_REG, PIN_MASK(PANEL_PIN_LATCH));
+  REG_WRITE(GPIO_OUT_W1TC_REG, PIN_MASK(PANEL_PIN_LATCH));
+  uint32_t high = (phase & 1 ? PIN_MASK(PANEL_PIN_A) : 0) |
+                  (phase & 2 ? PIN_MASK(PANEL_PIN_B) : 0);
+  REG_WRITE(GPIO_OUT_W1TS_REG, high);
+  REG_WRITE(GPIO_OUT_W1TC_REG,
+            (PIN_MASK(PANEL_PIN_A) | PIN_MASK(PANEL_PIN_B)) & ~high);
+  REG_WRITE(GPIO_OUT_W1TS_REG, PIN_MASK(PANEL_PIN_NOE));
+  phase = (phase + 1) & 3;
+
+  int64_t end = esp_timer_get_time();
+  uint32_t us = (uint32_t)(end - start);
+  uint32_t gap = lastScanUs ? (uint32_t)(start - lastScanUs) : 0;
+  lastScanUs = start;
+  taskENTER_CRITICAL_ISR(&statsMux);
+  window.rows++;
+  window.totalUs += us;
+  if (us > window.maxUs)
+    window.maxUs = us;
+  if (gap > window.maxGapUs)
+    window.maxGapUs = gap;
+  if (gap > periodUs + periodUs / 2)
+    window.missed += (gap + periodUs / 2) / periodUs - 1;
+  taskEXIT_CRITICAL_ISR(&statsMux);
+}
+
+PanelScanStats PanelDriver::takeStats() {
+  taskENTER_CRITICAL(&statsMux);
+  PanelScanStats copy = window;
+  window = {};
+  taskEXIT_CRITICAL(&statsMux);
+  return copy;
+}
+
+void PanelDriver::dumpStats() {
+  PanelScanStats s = takeStats();
+  LOG_I("Scan: %lu rows, %lu.%02lu us avg, %lu us max (%d panels), "
+        "%lu missed, max gap %lu us",
+        (unsigned long)s.rows,
+        (unsigned long)(s.rows ? s.totalUs / s.rows : 0),
+        (unsigned long)(s.rows ? (uint64_t)s.totalUs * 100 / s.rows % 100
+                               : 0),
+        (unsigned long)s.maxUs, panels(), (unsigned long)s.missed,
+        (unsigned long)s.maxGapUs);
+}
@@ -0,0 +1,53 @@
+#include "panel_stress.h"
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include "log.h"
+
+#define STRESS_SECTOR 4096
+#define STRESS_PAGE 256
+
+void panelStressRun(PanelDriver &panel) {
+  const esp_partition_t *partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+  if (!partition) {
+    LOG_W("Panel stress: no spiffs partition to write to");
+    return;
+  }
+  static uint8_t page[STRESS_PAGE];
+  memset(page, 0x5a, sizeof(page));
+
+  // L'ultimo settore: lontano dall'inizio di un eventuale file system
+  uint32_t offset = partition->size - STRESS_SECTOR;
+  uint32_t rewrites = 0;
+  int64_t flashUs = 0;
+  panel.takeStats();
+  int64_t start = esp_timer_get_time();
+  while (esp_timer_get_time() - start < PANEL_STRESS_SECONDS * 1000000LL) {
+    int64_t t = esp_timer_get_time();
+    if (esp_partition_erase_range(partition, offset, STRESS_SECTOR) !=
+        ESP_OK) {
+      LOG_W("Panel stress: erase failed");
+      break;
+    }
+    for (uint32_t p = 0; p < STRESS_SECTOR; p += STRESS_PAGE)
+      esp_partition_write(partition, offset + p, page, STRESS_PAGE);
+    flashUs += esp_timer_get_time() - t;
+    rewrites++;
+    delay(1); // Lascia girare gli altri task
+  }
+  PanelScanStats s = panel.takeStats();
+  int64_t elapsedUs = esp_timer_get_time() - start;
+
+  LOG_I("Panel stress: %lu sector rewrites, %lu ms of %lu ms in flash ops",
+        (unsigned long)rewrites, (unsigned long)(flashUs / 1000),
+        (unsigned long)(elapsedUs / 1000));
+  LOG_I("Panel stress: %lu scans, %lu missed (expected %lu), max gap %lu us",
+        (unsigned long)s.rows, (unsigned long)s.missed,
+        (unsigned long)(elapsedUs / PANEL_SCAN_PERIOD_US),
+        (unsigned long)s.maxGapUs);
+  logFlush();
+}
@@ -0,0 +1,132 @@
+#include "power.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+#include "log.h"
+
+static TaskHandle_t loopTaskHandle = NULL;
+
+// Contatori della finestra di statistiche corrente
+static int64_t windowStartUs = 0;
+static int64_t idleUs = 0;
+static int64_t boostUs = 0;
+static int64_t boostSinceUs = 0;
+static int boostDepth = 0;
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t cpuLock = NULL;
+static esp_pm_lock_handle_t apbLock = NULL;
+#endif
+
+// =================================================================
+// Modello di consumo (stima, solo SoC: esclude radio e pannelli LED)
+// Corrente con CPU attiva ~ 13 mA + 0.23 mA/MHz, in idle ~ 20 mA a
+// 80 MHz (datasheet ESP32, modem sleep)
+// =================================================================
+static const float SUPPLY_VOLTAGE = 3.3f;
+static const float IDLE_CURRENT_MA = 20.0f;
+
+static float activeCurrentMa(int mhz) { return 13.0f + 0.23f * mhz; }
+
+void powerInit() {
+  loopTaskHandle = xTaskGetCurrentTaskHandle();
+  windowStartUs = esp_timer_get_time();
+
+#if CONFIG_PM_ENABLE
+  esp_pm_config_t config = {};
+  config.max_freq_mhz = POWER_MAX_FREQ_MHZ;
+  config.min_freq_mhz = POWER_MIN_FREQ_MHZ;
+  config.light_sleep_enable = false; // Il refresh del display non si ferma
+  esp_err_t err = esp_pm_configure(&config);
+  if (err != ESP_OK) {
+    LOG_W("esp_pm_configure failed: %d", err);
+    return;
+  }
+  esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "boost", &cpuLock);
+  esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "scan", &apbLock);
+  LOG_I("DFS enabled: %d-%d MHz", POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ);
+#else
+  LOG_W("CONFIG_PM_ENABLE not set, CPU stays at %lu MHz",
+        (unsigned long)ESP.getCpuFreqMHz());
+#endif
+}
+
+void powerIdleUntil(uint32_t deadlineMs) {
+  int32_t waitMs = (int32_t)(deadlineMs - millis());
+  if (waitMs <= 0)
+    return;
+
+  int64_t start = esp_timer_get_time();
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+  idleUs += esp_timer_get_time() - start;
+}
+
+void powerWake() {
+  if (loopTaskHandle)
+    xTaskNotifyGive(loopTaskHandle);
+}
+
+PowerBoost::PowerBoost() {
+  if (boostDepth++ == 0) {
+    boostSinceUs = esp_timer_get_time();
+#if CONFIG_PM_ENABLE
+    if (cpuLock)
+      esp_pm_lock_acquire(cpuLock);
+#endif
+  }
+}
+
+PowerBoost::~PowerBoost() {
+  if (--boostDepth == 0) {
+#if CONFIG_PM_ENABLE
+    if (cpuLock)
+      esp_pm_lock_release(cpuLock);
+#endif
+    boostUs += esp_timer_get_time() - boostSinceUs;
+  }
+}
+
+void powerAcquireScanLock() {
+#if CONFIG_PM_ENABLE
+  if (apbLock)
+    esp_pm_lock_acquire(apbLock);
+#endif
+}
+
+void powerDumpStats() {
+  int64_t now = esp_timer_get_time();
+  int64_t window = now - windowStartUs;
+  if (window <= 0)
+    return;
+
+  float idleShare = (float)idleUs / window;
+  float boostShare = (float)boostUs / window;
+  float busyShare = 1.0f - idleShare;
+
+#if CONFIG_PM_ENABLE
+  int lowMhz = POWER_MIN_FREQ_MHZ;
+#else
+  int lowMhz = ESP.getCpuFreqMHz();
+#endif
+
+  // Il tempo in boost è a frequenza massima, il resto del lavoro a quella
+  // minima, l'idle alla corrente di modem sleep
+  float lowBusy = busyShare > boostShare ? busyShare - boostShare : 0.0f;
+  float currentMa = boostShare * activeCurrentMa(POWER_MAX_FREQ_MHZ) +
+                    lowBusy * activeCurrentMa(lowMhz) +
+                    idleShare * IDLE_CURRENT_MA;
+
+  LOG_I("loop cpu %5.2f%% (boost %5.2f%%), est. SoC power %.0f mW",
+        busyShare * 100.0f, boostShare * 100.0f,
+        currentMa * SUPPLY_VOLTAGE);
+
+  windowStartUs = now;
+  idleUs = 0;
+  boostUs = 0;
+}
@@ -0,0 +1,81 @@
+#include "relay.h"
+
+#include <string.h>
+
+RelayNode::RelayNode(RelayLink &link, int role, uint32_t nodeId,
+                     const char *stationCode, int64_t (*utcUsFn)())
+    : link(link), nodeRole(role), id(nodeId), station(stationCode),
+      utcNow(utcUsFn), haveSnapshot(false), lastSentMs(0), lastHeardMs(0),
+      everHeard(false), started(false), startMs(0), lastLeader(0),
+      lastSequence(0), sent(0), received(0), rejected(0) {
+  memset(&snapshot, 0, sizeof(snapshot));
+}
+
+void RelayNode::broadcast(uint32_t nowMs) {
+  if (utcNow)
+    snapshot.utcUs = utcNow();
+  uint8_t packet[SNAPSHOT_WIRE_MAX];
+  size_t length = snapshotEncode(snapshot, id, station, packet, sizeof(packet));
+  if (length && link.send(packet, length))
+    sent++;
+  lastSentMs = nowMs;
+}
+
+void RelayNode::publish(const Snapshot &snap, uint32_t nowMs) {
+  if (nodeRole != RELAY_LEADER)
+    return;
+  snapshot = snap;
+  haveSnapshot = true;
+  broadcast(nowMs);
+}
+
+bool RelayNode::poll(uint32_t nowMs) {
+  if (!started) {
+    started = true;
+    startMs = nowMs;
+  }
+  if (nodeRole == RELAY_LEADER) {
+    if (haveSnapshot && nowMs - lastSentMs >= RELAY_REPEAT_MS)
+      broadcast(nowMs);
+    return false;
+  }
+  if (nodeRole != RELAY_FOLLOWER)
+    return false;
+
+  bool updated = false;
+  uint8_t packet[SNAPSHOT_WIRE_MAX];
+  int length;
+  while ((length = link.receive(packet, sizeof(packet))) >= 0) {
+    Snapshot incoming;
+    uint32_t leader;
+    if (!snapshotDecode(packet, length, station, incoming, leader)) {
+      rejected++;
+      continue;
+    }
+
+    received++;
+    lastHeardMs = nowMs;
+    everHeard = true;
+
+    // Le ripetizioni dello stesso snapshot tengono vivo il leader ma non
+    // vanno riapplicate; un leader nuovo o riavviato riparte da capo
+    if (leader == lastLeader && incoming.sequence == lastSequence &&
+        haveSnapshot)
+      continue;
+
+    lastLeader = leader;
+    lastSequence = incoming.sequence;
+    snapshot = incoming;
+    haveSnapshot = true;
+    updated = true;
+  }
+  return updated;
+}
+
+bool RelayNode::silent(uint32_t nowMs) const {
+  if (nodeRole != RELAY_FOLLOWER)
+    return true;
+  if (!everHeard)
+    return !started || nowMs - startMs > RELAY_BOOT_GRACE_MS;
+  return nowMs - lastHeardMs > RELAY_SILENCE_MS;
+}
@@ -0,0 +1,65 @@
+#include "relay.h"
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+#include "log.h"
+
+/**
+ * @brief UDP multicast link on the station interface. The socket is
+ * (re)opened lazily, so it survives Wi-Fi reconnects.
+ */
+class WiFiUdpRelayLink : public RelayLink {
+public:
+  WiFiUdpRelayLink()
+      : group(RELAY_GROUP_A, RELAY_GROUP_B, RELAY_GROUP_C, RELAY_GROUP_D),
+        open(false) {}
+
+  bool send(const uint8_t *data, size_t length) override {
+    if (!ensureOpen())
+      return false;
+    if (!udp.beginPacket(group, RELAY_PORT))
+      return false;
+    udp.write(data, length);
+    return udp.endPacket();
+  }
+
+  int receive(uint8_t *buf, size_t size) override {
+    if (!ensureOpen())
+      return -1;
+    int length = udp.parsePacket();
+    if (length <= 0)
+      return -1;
+    if ((size_t)length > size) {
+      udp.flush(); // Troppo grande: non è uno dei nostri
+      return 0;
+    }
+    return udp.read(buf, length);
+  }
+
+private:
+  bool ensureOpen() {
+    if (!WiFi.isConnected()) {
+      if (open) {
+        udp.stop();
+        open = false;
+      }
+      return false;
+    }
+    if (!open) {
+      open = udp.beginMulticast(group, RELAY_PORT);
+      if (open)
+        LOG_I("Relay multicast group joined");
+    }
+    return open;
+  }
+
+  WiFiUDP udp;
+  IPAddress group;
+  bool open;
+};
+
+RelayLink &relayWiFiLink() {
+  static WiFiUdpRelayLink link;
+  return link;
+}
@@ -0,0 +1,108 @@
+#include "scene.h"
+
+#include "log.h"
+
+SceneStats *SceneStats::first = nullptr;
+
+SceneStats::SceneStats(const char *name)
+    : name(name), cpuUs(0), slices(0), maxSliceUs(0), next(first) {
+  first = this;
+}
+
+SceneRunner::SceneRunner(ClockFn millisFn, ClockFn microsFn)
+    : millisFn(millisFn), microsFn(microsFn), running(nullptr),
+      statsSinceUs(0) {
+  for (int i = 0; i < SCENE_MAX_ROOTS; i++) {
+    roots[i].top = nullptr;
+    roots[i].resumePoint = nullptr;
+    roots[i].wakeAtMs = 0;
+    roots[i].stats = nullptr;
+  }
+}
+
+bool SceneRunner::add(SceneStats &stats, SceneTask task) {
+  for (int i = 0; i < SCENE_MAX_ROOTS; i++) {
+    if (!roots[i].top) {
+      std::coroutine_handle<> h = task.release();
+      roots[i].top = h;
+      roots[i].resumePoint = h;
+      roots[i].wakeAtMs = millisFn();
+      roots[i].stats = &stats;
+      return true;
+    }
+  }
+  LOG_E("SceneRunner: no free slot for %s", stats.name);
+  return false;
+}
+
+void SceneRunner::tick() {
+  if (statsSinceUs == 0)
+    statsSinceUs = microsFn();
+
+  for (int i = 0; i < SCENE_MAX_ROOTS; i++) {
+    SceneRoot &root = roots[i];
+    if (!root.top || (int32_t)(millisFn() - root.wakeAtMs) < 0)
+      continue;
+
+    running = &root;
+    uint32_t start = microsFn();
+    root.resumePoint.resume();
+    uint32_t slice = microsFn() - start;
+    running = nullptr;
+
+    // Il tempo va alla scena attiva alla fine della fetta
+    SceneStats *stats = root.stats;
+    stats->cpuUs += slice;
+    stats->slices++;
+    if (slice > stats->maxSliceUs)
+      stats->maxSliceUs = slice;
+
+    if (root.top.done()) {
+      root.top.destroy();
+      root.top = nullptr;
+    }
+  }
+}
+
+uint32_t SceneRunner::nextWakeMs() const {
+  uint32_t now = millisFn();
+  uint32_t earliest = now + 1000; // Nessuna scena: ricontrolla tra 1 s
+  for (int i = 0; i < SCENE_MAX_ROOTS; i++) {
+    if (roots[i].top && (int32_t)(roots[i].wakeAtMs - earliest) < 0)
+      earliest = roots[i].wakeAtMs;
+  }
+  return earliest;
+}
+
+/**
+ * @brief Logs CPU time per scene since the previous dump, then resets.
+ */
+void SceneRunner::dumpStats() {
+  uint32_t now = microsFn();
+  uint32_t window = now - statsSinceUs;
+  if (window == 0)
+    return;
+
+  for (SceneStats *s = SceneStats::first; s; s = s->next) {
+    if (s->slices == 0)
+      continue;
+    LOG_I("scene %-12s cpu %6lu ms (%5.2f%%) slices %5lu max %5lu us", s->name,
+          (unsigned long)(s->cpuUs / 1000), s->cpuUs * 100.0f / window,
+          (unsigned long)s->slices, (unsigned long)s->maxSliceUs);
+    s->cpuUs = 0;
+    s->slices = 0;
+    s->maxSliceUs = 0;
+  }
+  statsSinceUs = now;
+}
+
+SceneScope::SceneScope(SceneStats &stats) : root(sceneRunner.current()) {
+  previous = root ? root->stats : nullptr;
+  if (root)
+    root->stats = &stats;
+}
+
+SceneScope::~SceneScope() {
+  if (root && previous)
+    root->stats = previous;
+}
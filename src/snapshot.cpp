@@ -0,0 +1,176 @@
+#include "snapshot.h"
+
+#include <string.h>
+
+// Formato (little endian):
+//   magic "TRB" | version | station hash u32 | leader id u32 | sequence u32
+//   utc us i64 | count u8 | stringhe (len u8 + byte) | crc32 u32
+static const uint8_t SNAPSHOT_MAGIC[3] = {'T', 'R', 'B'};
+static const uint8_t SNAPSHOT_VERSION = 1;
+
+static uint32_t fnv1a(const char *s) {
+  uint32_t h = 2166136261u;
+  while (*s) {
+    h ^= (uint8_t)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+uint32_t snapshotCrc32(const uint8_t *data, size_t length) {
+  uint32_t crc = 0xffffffffu;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int k = 0; k < 8; k++)
+      crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+void snapshotCopyField(char *dst, size_t size, const char *src) {
+  if (!src)
+    src = "";
+  size_t n = strnlen(src, size - 1);
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+// =================================================================
+// Writer / reader con controllo dei limiti
+// =================================================================
+struct WireWriter {
+  uint8_t *buf;
+  size_t size;
+  size_t pos;
+  bool overflow;
+
+  void bytes(const void *p, size_t n) {
+    if (pos + n > size) {
+      overflow = true;
+      return;
+    }
+    memcpy(buf + pos, p, n);
+    pos += n;
+  }
+  void u8(uint8_t v) { bytes(&v, 1); }
+  void u32(uint32_t v) {
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16),
+                    (uint8_t)(v >> 24)};
+    bytes(b, 4);
+  }
+  void i64(int64_t v) {
+    u32((uint32_t)v);
+    u32((uint32_t)((uint64_t)v >> 32));
+  }
+  void str(const char *s, size_t field) {
+    size_t n = strnlen(s, field - 1);
+    u8((uint8_t)n);
+    bytes(s, n);
+  }
+};
+
+struct WireReader {
+  const uint8_t *buf;
+  size_t size;
+  size_t pos;
+  bool underflow;
+
+  bool bytes(void *p, size_t n) {
+    if (pos + n > size) {
+      underflow = true;
+      return false;
+    }
+    memcpy(p, buf + pos, n);
+    pos += n;
+    return true;
+  }
+  uint8_t u8() {
+    uint8_t v = 0;
+    bytes(&v, 1);
+    return v;
+  }
+  uint32_t u32() {
+    uint8_t b[4] = {0, 0, 0, 0};
+    bytes(b, 4);
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+  }
+  int64_t i64() {
+    uint64_t lo = u32();
+    uint64_t hi = u32();
+    return (int64_t)(lo | (hi << 32));
+  }
+  void str(char *dst, size_t field) {
+    uint8_t n = u8();
+    if (n >= field || !bytes(dst, n)) {
+      underflow = true;
+      dst[0] = '\0';
+      return;
+    }
+    dst[n] = '\0';
+  }
+};
+
+size_t snapshotEncode(const Snapshot &snap, uint32_t leaderId,
+                      const char *stationCode, uint8_t *buf, size_t size) {
+  WireWriter w = {buf, size, 0, false};
+  w.bytes(SNAPSHOT_MAGIC, 3);
+  w.u8(SNAPSHOT_VERSION);
+  w.u32(fnv1a(stationCode));
+  w.u32(leaderId);
+  w.u32(snap.sequence);
+  w.i64(snap.utcUs);
+
+  uint8_t count = snap.count < SNAPSHOT_MAX_DEPARTURES
+                      ? snap.count
+                      : SNAPSHOT_MAX_DEPARTURES;
+  w.u8(count);
+  w.str(snap.weather, sizeof(snap.weather));
+  w.str(snap.stationName, sizeof(snap.stationName));
+  for (uint8_t i = 0; i < count; i++) {
+    const DepartureRecord &d = snap.departures[i];
+    w.str(d.type, sizeof(d.type));
+    w.str(d.destination, sizeof(d.destination));
+    w.str(d.departureTime, sizeof(d.departureTime));
+    w.str(d.delay, sizeof(d.delay));
+  }
+  if (w.overflow)
+    return 0;
+
+  w.u32(snapshotCrc32(buf, w.pos));
+  return w.overflow ? 0 : w.pos;
+}
+
+bool snapshotDecode(const uint8_t *buf, size_t length,
+                    const char *stationCode, Snapshot &snap,
+                    uint32_t &leaderId) {
+  const size_t minLength = 4 + 12 + 8 + 1 + 2 + 4; // Header, 0 treni, CRC
+  if (length < minLength || memcmp(buf, SNAPSHOT_MAGIC, 3) != 0 ||
+      buf[3] != SNAPSHOT_VERSION)
+    return false;
+
+  WireReader crcReader = {buf, length, length - 4, false};
+  if (crcReader.u32() != snapshotCrc32(buf, length - 4))
+    return false;
+
+  WireReader r = {buf, length - 4, 4, false};
+  if (r.u32() != fnv1a(stationCode))
+    return false; // Altra stazione sulla stessa rete
+
+  leaderId = r.u32();
+  snap.sequence = r.u32();
+  snap.utcUs = r.i64();
+  snap.count = r.u8();
+  if (snap.count > SNAPSHOT_MAX_DEPARTURES)
+    return false;
+
+  r.str(snap.weather, sizeof(snap.weather));
+  r.str(snap.stationName, sizeof(snap.stationName));
+  for (uint8_t i = 0; i < snap.count; i++) {
+    DepartureRecord &d = snap.departures[i];
+    r.str(d.type, sizeof(d.type));
+    r.str(d.destination, sizeof(d.destination));
+    r.str(d.departureTime, sizeof(d.departureTime));
+    r.str(d.delay, sizeof(d.delay));
+  }
+  return !r.underflow && r.pos == length - 4;
+}
@@ -0,0 +1,93 @@
+#include <Arduino.h>
+#include <errno.h>
+#include <lwip/sockets.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+
+#include "lean_http.h"
+#include "log.h"
+#include "net_connect.h"
+
+// =================================================================
+// PLAIN TCP SOCKET
+// HttpSocket without TLS, for feeds served on the LAN (http://). Uses
+// the same mbedtls_net_* calls and bounded connect as the TLS socket
+// underneath.
+// =================================================================
+
+class PlainTcpSocket : public HttpSocket {
+public:
+  PlainTcpSocket() : isOpen(false), ioTimeoutMs(0) { mbedtls_net_init(&net); }
+
+  bool connect(const char *host, uint16_t port, uint32_t timeoutMs) override {
+    stop();
+    // Un host della LAN spento costa il timeout, non quello del sistema
+    int ret = netConnect(&net, host, port, timeoutMs);
+    if (ret != 0) {
+      LOG_W("TCP connect to %s:%u failed: -0x%04x", host, port,
+            (unsigned)-ret);
+      return false;
+    }
+    isOpen = true;
+    ioTimeoutMs = timeoutMs;
+    return true;
+  }
+
+  bool connected() override {
+    if (!isOpen)
+      return false;
+    uint8_t probe; // Come in tls_socket.cpp: 0 = chiusa dal server
+    int n = recv(net.fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      stop();
+      return false;
+    }
+    return true;
+  }
+
+  int write(const uint8_t *data, size_t length) override {
+    uint32_t start = millis();
+    size_t sent = 0;
+    while (sent < length) {
+      int ret = mbedtls_net_send(&net, data + sent, length - sent);
+      if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        if (millis() - start >= ioTimeoutMs)
+          return -1;
+        continue;
+      }
+      if (ret <= 0)
+        return -1;
+      sent += ret;
+    }
+    return (int)sent;
+  }
+
+  int read(uint8_t *buf, size_t size, uint32_t timeoutMs) override {
+    if (!isOpen)
+      return 0;
+    int ret = mbedtls_net_recv_timeout(&net, buf, size, timeoutMs);
+    if (ret >= 0)
+      return ret;
+    if (ret == MBEDTLS_ERR_SSL_TIMEOUT || ret == MBEDTLS_ERR_SSL_WANT_READ)
+      return HTTP_TRANSPORT_TIMEOUT;
+    return HTTP_TRANSPORT_CONNECTION_LOST;
+  }
+
+  void stop() override {
+    if (!isOpen)
+      return;
+    mbedtls_net_free(&net);
+    isOpen = false;
+  }
+
+private:
+  mbedtls_net_context net;
+  bool isOpen;
+  uint32_t ioTimeoutMs; // Quello di connect(), anche per write()
+};
+
+HttpTransport &leanHttpTransport() {
+  static PlainTcpSocket socket;
+  static LeanHttpTransport transport(socket);
+  return transport;
+}
@@ -0,0 +1,168 @@
+#include "tile_renderer.h"
+
+#include <string.h>
+
+// =================================================================
+// TileFrame
+// =================================================================
+
+TileFrame::TileFrame() : count(0), textUsed(0), overflow(false) {}
+
+void TileFrame::reset() {
+  count = 0;
+  textUsed = 0;
+  overflow = false;
+}
+
+TileFrame::Command *TileFrame::add(Kind kind, int x, int y, int width,
+                                   int height, BlitMode mode) {
+  if (count == TILE_FRAME_COMMANDS) {
+    overflow = true;
+    return nullptr;
+  }
+  Command &c = commands[count++];
+  memset(&c, 0, sizeof(c));
+  c.kind = kind;
+  c.mode = mode;
+  c.x = x;
+  c.y = y;
+  c.width = width;
+  c.height = height;
+  return &c;
+}
+
+bool TileFrame::clear() {
+  return add(CMD_CLEAR, 0, 0, INT16_MAX, INT16_MAX, BLIT_NOR) != nullptr;
+}
+
+bool TileFrame::fillRect(int x, int y, int width, int height,
+                         BlitMode mode) {
+  return add(CMD_FILL, x, y, width, height, mode) != nullptr;
+}
+
+bool TileFrame::blit(int x, int y, const Sprite &sprite, BlitMode mode) {
+  Command *c = add(CMD_BLIT, x, y, sprite.width, sprite.height, mode);
+  if (!c)
+    return false;
+  c->source = sprite.rows;
+  c->wordsPerRow = sprite.wordsPerRow;
+  return true;
+}
+
+bool TileFrame::drawText(int x, int y, const PackedFont &font,
+                         const char *text, size_t length, BlitMode mode) {
+  if (textUsed + length > sizeof(texts)) {
+    overflow = true;
+    return false;
+  }
+  Command *c = add(CMD_TEXT, x, y, font.textWidth(text, length),
+                   font.height(), mode);
+  if (!c)
+    return false;
+  memcpy(texts + textUsed, text, length);
+  c->source = &font;
+  c->text = textUsed;
+  c->length = length;
+  textUsed += length;
+  return true;
+}
+
+void TileFrame::rasterize(Framebuffer &fb, int x, int y, int width,
+                          int height) const {
+  for (size_t i = 0; i < count; i++) {
+    const Command &c = commands[i];
+    if (c.kind != CMD_CLEAR &&
+        (c.x >= x + width || c.x + c.width <= x || c.y >= y + height ||
+         c.y + c.height <= y))
+      continue; // Non tocca questo tile
+    switch (c.kind) {
+    case CMD_CLEAR:
+      fb.fillRect(x, y, width, height, BLIT_NOR);
+      break;
+    case CMD_FILL:
+      fb.fillRect(c.x, c.y, c.width, c.height, c.mode);
+      break;
+    case CMD_BLIT: {
+      Sprite sprite = {(const uint32_t *)c.source, (uint16_t)c.width,
+                       (uint16_t)c.height, c.wordsPerRow};
+      fb.blit(c.x, c.y, sprite, c.mode);
+      break;
+    }
+    case CMD_TEXT:
+      fb.drawText(c.x, c.y, *(const PackedFont *)c.source, texts + c.text,
+                  c.length, c.mode);
+      break;
+    }
+  }
+}
+
+// =================================================================
+// TileRenderer
+// =================================================================
+
+TileRenderer::TileRenderer(Framebuffer &fb)
+    : fb(fb), wake(nullptr), wakeArg(nullptr), barrierWait(nullptr),
+      barrierFinished(nullptr), barrierArg(nullptr), current(nullptr),
+      tileCount(0), next(0), done(0), helped(0) {}
+
+void TileRenderer::setHelper(WakeFn fn, void *arg) {
+  wakeArg = arg;
+  wake = fn;
+}
+
+void TileRenderer::setBarrier(WakeFn wait, WakeFn finished, void *arg) {
+  barrierArg = arg;
+  barrierFinished = finished;
+  barrierWait = wait;
+}
+
+int TileRenderer::tiles() const {
+  return fb.wordsPerRow() * (fb.height() / 16);
+}
+
+// Un tile = un pannello; la copia di fb porta il clip del tile
+int TileRenderer::runTiles() {
+  int count = tileCount.load();
+  int across = fb.wordsPerRow();
+  int mine = 0;
+  for (;;) {
+    int i = next.fetch_add(1);
+    if (i >= count)
+      break;
+    const TileFrame *frame = current.load();
+    int x = (i % across) * 32, y = (i / across) * 16;
+    Framebuffer view = fb;
+    view.setClip(x, y, 32, 16);
+    frame->rasterize(view, x, y, 32, 16);
+    done.fetch_add(1);
+    mine++;
+  }
+  return mine;
+}
+
+void TileRenderer::render(const TileFrame &frame) {
+  int count = tiles();
+  // Prima frame e contatori, poi next: un worker che prende un tile
+  // vede già il frame nuovo
+  current.store(&frame);
+  tileCount.store(count);
+  done.store(0);
+  next.store(0);
+  if (wake && count >= TILE_MIN_PARALLEL)
+    wake(wakeArg);
+  runTiles();
+  // Barriera: l'altro worker sta finendo il suo ultimo tile. Di solito
+  // bastano pochi giri; se è stato interrotto (Wi-Fi, lwIP) ci si blocca
+  for (int spin = 0; done.load() < count; spin++) {
+    if (barrierWait && spin >= TILE_BARRIER_SPIN)
+      barrierWait(barrierArg);
+  }
+}
+
+void TileRenderer::help() {
+  int mine = runTiles();
+  helped.fetch_add(mine);
+  // Se l'ultimo tile è stato suo, il chiamante può essere bloccato
+  if (mine && barrierFinished && done.load() == tileCount.load())
+    barrierFinished(barrierArg);
+}
@@ -0,0 +1,47 @@
+#include <Arduino.h>
+#include <freertos/semphr.h>
+
+#include "log.h"
+#include "tile_renderer.h"
+
+// Sotto Wi-Fi e lwIP (core 0): il worker cede a loro, la barriera di
+// render() aspetta al più il tile che sta rasterizzando
+#define TILE_WORKER_PRIORITY (tskIDLE_PRIORITY + 2)
+
+static void tileWorkerTask(void *arg) {
+  TileRenderer *renderer = (TileRenderer *)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    renderer->help();
+  }
+}
+
+static void wakeTileWorker(void *task) { xTaskNotifyGive((TaskHandle_t)task); }
+
+// Barriera bloccante: un semaforo, non le notifiche del loop task (sono
+// di powerWake()). Un give rimasto dal frame prima fa solo un giro in più
+static void waitTileWorker(void *done) {
+  xSemaphoreTake((SemaphoreHandle_t)done, 1);
+}
+
+static void tileWorkerFinished(void *done) {
+  xSemaphoreGive((SemaphoreHandle_t)done);
+}
+
+bool tileWorkerStart(TileRenderer &renderer, int core) {
+  SemaphoreHandle_t done = xSemaphoreCreateBinary();
+  if (!done) {
+    LOG_E("Tile worker not started");
+    return false;
+  }
+  TaskHandle_t task = NULL;
+  if (xTaskCreatePinnedToCore(tileWorkerTask, "tiles", 3072, &renderer,
+                              TILE_WORKER_PRIORITY, &task, core) != pdPASS) {
+    vSemaphoreDelete(done);
+    LOG_E("Tile worker not started");
+    return false;
+  }
+  renderer.setBarrier(waitTileWorker, tileWorkerFinished, done);
+  renderer.setHelper(wakeTileWorker, task);
+  return true;
+}
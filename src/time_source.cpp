@@ -0,0 +1,177 @@
+#include "time_source.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#if USE_NTP
+#include <esp_sntp.h>
+#endif
+
+#include "disciplined_clock.h"
+#include "log.h"
+
+static DisciplinedClock wallClock;
+// Il clock viene aggiornato dal task di rete (SNTP) e letto dal loop()
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+
+static int64_t clockUtcNow() {
+  taskENTER_CRITICAL(&clockMux);
+  int64_t utc = wallClock.utcAt(timeSourceMonoUs());
+  taskEXIT_CRITICAL(&clockMux);
+  return utc;
+}
+
+static void clockSync(int64_t monoUs, int64_t utcUs, int64_t uncertaintyUs) {
+  taskENTER_CRITICAL(&clockMux);
+  wallClock.sync(monoUs, utcUs, uncertaintyUs, TIME_STEP_THRESHOLD_US);
+  taskEXIT_CRITICAL(&clockMux);
+}
+
+// =================================================================
+// HTTP DATE PARSING
+// =================================================================
+
+// Giorni dal 1970-01-01 (algoritmo "days from civil" di H. Hinnant)
+static int64_t daysFromCivil(int y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+bool parseHttpDate(const char *date, time_t &out) {
+  static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+  // "Sun, 06 Nov 1994 08:49:37 GMT"
+  if (!date || strlen(date) < 29 || date[3] != ',')
+    return false;
+
+  char mon[4] = {date[8], date[9], date[10], '\0'};
+  const char *pos = strstr(MONTHS, mon);
+  if (!pos || (pos - MONTHS) % 3 != 0)
+    return false;
+  int month = (pos - MONTHS) / 3 + 1;
+
+  int day, year, hour, minute, second;
+  if (sscanf(date + 5, "%2d", &day) != 1 ||
+      sscanf(date + 12, "%4d %2d:%2d:%2d", &year, &hour, &minute, &second) !=
+          4)
+    return false;
+  if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60 ||
+      strncmp(date + 26, "GMT", 3) != 0)
+    return false;
+
+  out = (time_t)(daysFromCivil(year, month, day) * 86400LL + hour * 3600 +
+                 minute * 60 + second);
+  return true;
+}
+
+// =================================================================
+// CLOCK DISCIPLINE
+// =================================================================
+
+int64_t timeSourceMonoUs() { return esp_timer_get_time(); }
+
+/**
+ * @brief Keeps the system clock (used by TLS and time()) within a second
+ * of the disciplined clock; the display never reads it.
+ */
+static void alignSystemClock() {
+  int64_t target = clockUtcNow();
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  int64_t system = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+  if (llabs(target - system) > 1000000LL) {
+    tv.tv_sec = (time_t)(target / 1000000LL);
+    tv.tv_usec = (suseconds_t)(target % 1000000LL);
+    settimeofday(&tv, NULL);
+  }
+}
+
+void timeSourceFromHttpDate(const char *date, int64_t sentUs,
+                            int64_t receivedUs) {
+  time_t serverSec;
+  if (!parseHttpDate(date, serverSec)) {
+    LOG_W("Unparsable Date header: %s", date ? date : "(none)");
+    return;
+  }
+
+  // Il server ha generato la risposta tra l'invio e la ricezione, e il
+  // Date è troncato al secondo: centro e semi-ampiezza della finestra
+  int64_t midMono = sentUs + (receivedUs - sentUs) / 2;
+  int64_t utc = (int64_t)serverSec * 1000000LL + 500000LL;
+  int64_t uncertainty = 500000LL + (receivedUs - sentUs) / 2;
+
+  uint32_t stepsBefore = wallClock.stepCount();
+  clockSync(midMono, utc, uncertainty);
+  alignSystemClock();
+
+  if (wallClock.stepCount() != stepsBefore)
+    LOG_W("Clock stepped (offset > %lld ms)", TIME_STEP_THRESHOLD_US / 1000);
+  LOG_D("Clock synced from Date header, drift %.2f ppm, slewing %lld ms",
+        wallClock.driftPpm(), wallClock.pendingSlewUs(midMono) / 1000);
+}
+
+void timeSourceFromReference(int64_t utcUs, int64_t monoUs,
+                             int64_t uncertaintyUs) {
+  if (utcUs <= 0)
+    return;
+  clockSync(monoUs, utcUs, uncertaintyUs);
+  alignSystemClock();
+  LOG_D("Clock synced from reference, drift %.2f ppm",
+        wallClock.driftPpm());
+}
+
+// =================================================================
+// SETUP
+// =================================================================
+
+#if USE_NTP
+static void onNtpSync(struct timeval *tv) {
+  // SNTP ha già impostato l'ora di sistema: la usiamo come misura
+  int64_t utc = (int64_t)tv->tv_sec * 1000000LL + tv->tv_usec;
+  clockSync(timeSourceMonoUs(), utc, 50000);
+  LOG_I("NTP time synchronized, drift %.2f ppm", wallClock.driftPpm());
+}
+#endif
+
+void timeSourceInit(const char *tz) {
+  setenv("TZ", tz, 1);
+  tzset();
+
+#if USE_NTP
+  // Opzionale: SNTP in background, nessuna attesa al boot
+  sntp_set_time_sync_notification_cb(onNtpSync);
+  configTime(0, 0, NTP_SERVER);
+  setenv("TZ", tz, 1); // configTime() resetta il fuso orario
+  tzset();
+#endif
+}
+
+bool timeSourceSynced() { return wallClock.synced(); }
+
+uint32_t timeSourceMsToNextSecond() {
+  if (!wallClock.synced())
+    return 1000;
+  // +1 ms: risvegliati appena dopo il cambio di secondo, non appena prima
+  return 1000 - (uint32_t)((clockUtcNow() / 1000) % 1000) + 1;
+}
+
+float timeSourceDriftPpm() { return wallClock.driftPpm(); }
+
+int64_t timeSourceUtcUs() {
+  return wallClock.synced() ? clockUtcNow() : 0;
+}
+
+bool timeSourceLocalTime(struct tm *info) {
+  if (!wallClock.synced())
+    return false;
+  time_t now = (time_t)(clockUtcNow() / 1000000LL);
+  localtime_r(&now, info);
+  return true;
+}
@@ -0,0 +1,114 @@
+#include "timetable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(sizeof(DepartureRecord::type) > sizeof(TimetableEntry::type),
+              "type field must fit with its terminator");
+
+#define INDEX_SLOTS (TIMETABLE_MINUTES + 1) // L'ultimo vale count
+
+size_t timetableImageSize(size_t count) {
+  return sizeof(TimetableHeader) + INDEX_SLOTS * sizeof(uint16_t) +
+         count * sizeof(TimetableEntry);
+}
+
+// Il codice stazione occupa 8 byte, senza terminatore se è lungo 8
+static bool sameStation(const char *field, const char *stationCode) {
+  return strncmp(field, stationCode, sizeof(TimetableHeader::station)) == 0;
+}
+
+Timetable::Timetable() : index(nullptr), entries(nullptr), entryCount(0) {}
+
+bool Timetable::attach(const uint8_t *data, size_t size,
+                       const char *stationCode) {
+  index = nullptr;
+  entries = nullptr;
+  entryCount = 0;
+  if (!data || size < timetableImageSize(0))
+    return false;
+
+  const TimetableHeader *header = (const TimetableHeader *)data;
+  if (memcmp(header->magic, TIMETABLE_MAGIC, 4) != 0 ||
+      header->version != TIMETABLE_VERSION ||
+      header->count > TIMETABLE_MAX_ENTRIES ||
+      !sameStation(header->station, stationCode))
+    return false;
+  size_t length = timetableImageSize(header->count);
+  if (size < length)
+    return false;
+  const uint8_t *body = data + sizeof(TimetableHeader);
+  if (snapshotCrc32(body, length - sizeof(TimetableHeader)) != header->crc)
+    return false;
+
+  index = (const uint16_t *)body;
+  if (index[TIMETABLE_MINUTES] != header->count) {
+    index = nullptr;
+    return false;
+  }
+  entries = (const TimetableEntry *)(body + INDEX_SLOTS * sizeof(uint16_t));
+  entryCount = header->count;
+  return true;
+}
+
+uint8_t Timetable::upcoming(uint16_t minute, Snapshot &snap) const {
+  snap.count = 0;
+  if (!entryCount || minute >= TIMETABLE_MINUTES)
+    return 0;
+
+  size_t i = index[minute];
+  while (snap.count < SNAPSHOT_MAX_DEPARTURES && snap.count < entryCount) {
+    if (i == entryCount)
+      i = 0; // Dopo l'ultimo treno del giorno, i primi di domani
+    const TimetableEntry &e = entries[i++];
+    DepartureRecord &d = snap.departures[snap.count++];
+    // I campi dell'entry non hanno terminatore se sono pieni
+    snapshotCopyField(d.type, sizeof(e.type) + 1, e.type);
+    snprintf(d.destination, sizeof(d.destination), "-> %.*s",
+             (int)sizeof(e.destination), e.destination);
+    snprintf(d.departureTime, sizeof(d.departureTime), "%02u:%02u",
+             (unsigned)(e.minute / 60), (unsigned)(e.minute % 60));
+    d.delay[0] = '\0';
+  }
+  return snap.count;
+}
+
+static int byMinute(const void *a, const void *b) {
+  return (int)((const TimetableEntry *)a)->minute -
+         (int)((const TimetableEntry *)b)->minute;
+}
+
+size_t timetableBuild(const char *stationCode, TimetableEntry *entries,
+                      size_t count, uint8_t *out, size_t size) {
+  size_t length = timetableImageSize(count);
+  if (count > TIMETABLE_MAX_ENTRIES || size < length)
+    return 0;
+  for (size_t i = 0; i < count; i++)
+    if (entries[i].minute >= TIMETABLE_MINUTES)
+      return 0;
+  qsort(entries, count, sizeof(TimetableEntry), byMinute);
+
+  memset(out, 0, length);
+  TimetableHeader *header = (TimetableHeader *)out;
+  memcpy(header->magic, TIMETABLE_MAGIC, 4);
+  header->version = TIMETABLE_VERSION;
+  header->count = (uint16_t)count;
+  memcpy(header->station, stationCode,
+         strnlen(stationCode, sizeof(header->station)));
+
+  // index[m] = prima entry con minute >= m
+  uint16_t *index = (uint16_t *)(out + sizeof(TimetableHeader));
+  size_t next = 0;
+  for (uint16_t m = 0; m <= TIMETABLE_MINUTES; m++) {
+    while (next < count && entries[next].minute < m)
+      next++;
+    index[m] = (uint16_t)next;
+  }
+  memcpy((uint8_t *)(index + INDEX_SLOTS), entries,
+         count * sizeof(TimetableEntry));
+
+  header->crc = snapshotCrc32(out + sizeof(TimetableHeader),
+                              length - sizeof(TimetableHeader));
+  return length;
+}
@@ -0,0 +1,39 @@
+#include "timetable.h"
+
+#include <esp_partition.h>
+
+#include "log.h"
+
+// Sottotipo "custom" della partizione, vedi partitions.csv
+#define TIMETABLE_PARTITION_SUBTYPE ((esp_partition_subtype_t)0x40)
+
+const Timetable &timetableFlash(const char *stationCode) {
+  static Timetable table;
+  static bool mapped = false;
+  if (mapped)
+    return table;
+  mapped = true; // Un solo tentativo: la partizione non cambia a runtime
+
+  const esp_partition_t *partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, TIMETABLE_PARTITION_SUBTYPE, "timetable");
+  if (!partition) {
+    LOG_W("Timetable partition missing");
+    return table;
+  }
+
+  // Mappata nella cache dati: letta in place, nessuna copia in RAM
+  const void *data = nullptr;
+  esp_partition_mmap_handle_t handle;
+  if (esp_partition_mmap(partition, 0, partition->size,
+                         ESP_PARTITION_MMAP_DATA, &data, &handle) != ESP_OK) {
+    LOG_W("Timetable partition mmap failed");
+    return table;
+  }
+  if (!table.attach((const uint8_t *)data, partition->size, stationCode)) {
+    LOG_W("Timetable partition empty or not for %s", stationCode);
+    esp_partition_munmap(handle);
+    return table;
+  }
+  LOG_I("Timetable: %u departures for %s", table.count(), stationCode);
+  return table;
+}
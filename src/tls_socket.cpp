@@ -0,0 +1,365 @@
+#include <secrets.h> // Prima di tls_socket.h: può definire i pin
+
+#include "tls_socket.h"
+
+#include <Arduino.h>
+#include <errno.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+#include <sdkconfig.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "net_connect.h"
+
+#if TLS_MAX_FRAGMENT && defined(CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN) &&     \
+    CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN < TLS_MAX_FRAGMENT
+#error "TLS_MAX_FRAGMENT exceeds CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN"
+#endif
+
+#if TLS_MAX_FRAGMENT && !defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+#error "TLS_MAX_FRAGMENT needs CONFIG_MBEDTLS_SSL_MAX_FRAGMENT_LENGTH=y"
+#endif
+
+static TlsStats stats = {};
+
+#if TLS_MAX_FRAGMENT
+static unsigned char fragmentCode() {
+  switch (TLS_MAX_FRAGMENT) {
+  case 512:
+    return MBEDTLS_SSL_MAX_FRAG_LEN_512;
+  case 1024:
+    return MBEDTLS_SSL_MAX_FRAG_LEN_1024;
+  case 2048:
+    return MBEDTLS_SSL_MAX_FRAG_LEN_2048;
+  default:
+    return MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+  }
+}
+#endif
+
+// =================================================================
+// PINNING
+// =================================================================
+#define PIN_SIZE 32
+#define SPKI_MAX 600 // Basta per una chiave RSA 4096
+
+static uint8_t pins[2][PIN_SIZE];
+static int pinCount = 0;
+
+static void addPin(const char *base64) {
+  if (!base64[0])
+    return;
+  size_t length = 0;
+  int ret = mbedtls_base64_decode(pins[pinCount], PIN_SIZE, &length,
+                                  (const unsigned char *)base64,
+                                  strlen(base64));
+  if (ret != 0 || length != PIN_SIZE) {
+    LOG_E("TLS pin \"%s\" is not a base64 SHA-256", base64);
+    return;
+  }
+  pinCount++;
+}
+
+/**
+ * @brief Hashes the certificate's SubjectPublicKeyInfo and compares it
+ * with the pins.
+ */
+static bool spkiPinned(mbedtls_x509_crt *crt) {
+  static unsigned char der[SPKI_MAX];
+  // Scrive in fondo al buffer e restituisce la lunghezza
+  int length = mbedtls_pk_write_pubkey_der(&crt->pk, der, sizeof(der));
+  if (length <= 0)
+    return false;
+  uint8_t hash[PIN_SIZE];
+  if (mbedtls_sha256(der + sizeof(der) - length, length, hash, 0) != 0)
+    return false;
+  for (int i = 0; i < pinCount; i++)
+    if (memcmp(hash, pins[i], PIN_SIZE) == 0)
+      return true;
+  return false;
+}
+
+// =================================================================
+// TIMING
+// Il tempo passato ad aspettare la rete, tolto dal tempo totale,
+// dà il costo di calcolo dell'handshake.
+// =================================================================
+static int64_t waitUs = 0;
+
+static int timedSend(void *context, const unsigned char *data, size_t length) {
+  int64_t start = esp_timer_get_time();
+  int ret = mbedtls_net_send(context, data, length);
+  waitUs += esp_timer_get_time() - start;
+  return ret;
+}
+
+static int timedRecv(void *context, unsigned char *buf, size_t length,
+                     uint32_t timeoutMs) {
+  int64_t start = esp_timer_get_time();
+  int ret = mbedtls_net_recv_timeout(context, buf, length, timeoutMs);
+  waitUs += esp_timer_get_time() - start;
+  return ret;
+}
+
+class MbedTlsSocket : public HttpSocket {
+public:
+  MbedTlsSocket()
+      : ready(false), isOpen(false), haveSession(false), ioTimeoutMs(0) {}
+
+  bool connect(const char *host, uint16_t port, uint32_t timeoutMs) override {
+    stop();
+    if (!ready && !setup())
+      return false;
+
+    uint32_t start = millis();
+    // Riusa i buffer già allocati invece di rifare mbedtls_ssl_setup()
+    int ret = mbedtls_ssl_session_reset(&ssl);
+    if (ret == 0)
+      ret = mbedtls_ssl_set_hostname(&ssl, host); // SNI
+    if (ret != 0)
+      return fail(ret);
+    bool offered = haveSession && strcmp(sessionHost, host) == 0;
+    if (offered && mbedtls_ssl_set_session(&ssl, &session) != 0)
+      offered = false;
+
+    // DNS e SYN rientrano nel timeout, come l'handshake
+    ret = netConnect(&net, host, port, timeoutMs);
+    if (ret != 0)
+      return fail(ret);
+    isOpen = true;
+    ioTimeoutMs = timeoutMs;
+
+    leafSeen = false;
+    leafPinned = false;
+    waitUs = 0;
+    int64_t handshakeStart = esp_timer_get_time();
+    ret = tlsHandshakeWithin(start, timeoutMs, nowMs, handshakeStep, this,
+                             MBEDTLS_ERR_SSL_TIMEOUT);
+    if (ret != 0) {
+      stop();
+      forgetSession();
+      return fail(ret);
+    }
+    int64_t handshakeUs = esp_timer_get_time() - handshakeStart;
+
+    // Senza certificato il server ha accettato la sessione offerta, che
+    // era stata aperta con un handshake completo e verificato
+    bool resumed = offered && !leafSeen;
+    if (pinCount && !resumed && !leafPinned) {
+      stop();
+      forgetSession();
+      stats.pinFailures++;
+      LOG_E("TLS: %s public key matches no pin", host);
+      return fail(MBEDTLS_ERR_X509_CERT_VERIFY_FAILED);
+    }
+    if (!resumed)
+      saveSession(host);
+
+    stats.handshakes++;
+    if (resumed)
+      stats.resumed++;
+    stats.lastResumed = resumed;
+    stats.lastHandshakeMs = millis() - start;
+    stats.lastHandshakeCpuUs =
+        handshakeUs > waitUs ? (uint32_t)(handshakeUs - waitUs) : 0;
+    stats.lastError = 0;
+#if TLS_MAX_FRAGMENT
+    stats.fragmentLimit = mbedtls_ssl_get_input_max_frag_len(&ssl);
+#endif
+    return true;
+  }
+
+  void forgetSession() {
+    if (!haveSession)
+      return;
+    mbedtls_ssl_session_free(&session);
+    haveSession = false;
+  }
+
+  bool connected() override {
+    if (!isOpen)
+      return false;
+    // Il server chiude le connessioni inattive: un recv non bloccante
+    // che restituisce 0 lo rivela senza consumare dati
+    uint8_t probe;
+    int n = recv(net.fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      stop();
+      return false;
+    }
+    return true;
+  }
+
+  int write(const uint8_t *data, size_t length) override {
+    uint32_t start = millis();
+    size_t sent = 0;
+    while (sent < length) {
+      int ret = mbedtls_ssl_write(&ssl, data + sent, length - sent);
+      if (ret == MBEDTLS_ERR_SSL_WANT_READ ||
+          ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        // Un server che non legge non tiene fermo il loop
+        if (millis() - start >= ioTimeoutMs) {
+          stats.lastError = MBEDTLS_ERR_SSL_TIMEOUT;
+          return -1;
+        }
+        continue;
+      }
+      if (ret <= 0) {
+        stats.lastError = ret;
+        return -1;
+      }
+      sent += ret;
+    }
+    return (int)sent;
+  }
+
+  int read(uint8_t *buf, size_t size, uint32_t timeoutMs) override {
+    if (!isOpen)
+      return 0;
+    mbedtls_ssl_conf_read_timeout(&conf, timeoutMs);
+    while (true) {
+      int ret = mbedtls_ssl_read(&ssl, buf, size);
+      if (ret > 0)
+        return ret;
+      if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+        continue;
+      if (ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
+        return 0;
+      if (ret == MBEDTLS_ERR_SSL_TIMEOUT)
+        return HTTP_TRANSPORT_TIMEOUT;
+      stats.lastError = ret;
+      return HTTP_TRANSPORT_CONNECTION_LOST;
+    }
+  }
+
+  void stop() override {
+    if (!isOpen)
+      return;
+    mbedtls_ssl_close_notify(&ssl);
+    mbedtls_net_free(&net);
+    isOpen = false;
+  }
+
+private:
+  bool setup() {
+    mbedtls_net_init(&net);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+
+    int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                    NULL, 0);
+    if (ret == 0)
+      ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT,
+                                        MBEDTLS_SSL_TRANSPORT_STREAM,
+                                        MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0)
+      return fail(ret);
+
+    addPin(TLS_PIN_SHA256);
+    addPin(TLS_PIN_SHA256_BACKUP);
+    if (pinCount) {
+      // Niente CA: la catena non viene validata, decide il pin. OPTIONAL
+      // fa arrivare l'handshake in fondo, il controllo è in connect()
+      mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+      mbedtls_ssl_conf_verify(&conf, verifyCertificate, this);
+    } else {
+      LOG_W("TLS: no pin configured, server certificate not verified");
+      mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    }
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+#if TLS_MAX_FRAGMENT
+    mbedtls_ssl_conf_max_frag_len(&conf, fragmentCode());
+#endif
+
+    // Alloca qui, una volta sola, i buffer dei record
+    ret = mbedtls_ssl_setup(&ssl, &conf);
+    if (ret != 0)
+      return fail(ret);
+    mbedtls_ssl_set_bio(&ssl, &net, timedSend, NULL, timedRecv);
+    ready = true;
+    LOG_I("TLS buffers allocated (max fragment %d, %d pins)",
+          TLS_MAX_FRAGMENT, pinCount);
+    return true;
+  }
+
+  static uint32_t nowMs() { return millis(); }
+
+  // Un passo dell'handshake, con il tempo rimasto come timeout di lettura
+  static int handshakeStep(void *context, uint32_t leftMs) {
+    MbedTlsSocket &self = *(MbedTlsSocket *)context;
+    mbedtls_ssl_conf_read_timeout(&self.conf, leftMs);
+    int ret = mbedtls_ssl_handshake_step(&self.ssl);
+    if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ &&
+        ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+      return ret;
+    return mbedtls_ssl_is_handshake_over(&self.ssl) ? 0 : 1;
+  }
+
+  static int verifyCertificate(void *context, mbedtls_x509_crt *crt,
+                               int depth, uint32_t *flags) {
+    MbedTlsSocket &self = *(MbedTlsSocket *)context;
+    if (depth == 0) {
+      int64_t start = esp_timer_get_time();
+      self.leafSeen = true;
+      self.leafPinned = spkiPinned(crt);
+      stats.lastPinCheckUs = (uint32_t)(esp_timer_get_time() - start);
+    }
+    *flags = 0; // Catena ignorata: conta solo il pin della foglia
+    return 0;
+  }
+
+  void saveSession(const char *host) {
+    forgetSession();
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&ssl, &session) != 0) {
+      mbedtls_ssl_session_free(&session);
+      return;
+    }
+    snprintf(sessionHost, sizeof(sessionHost), "%s", host);
+    haveSession = true;
+  }
+
+  bool fail(int ret) {
+    stats.failures++;
+    stats.lastError = ret;
+    LOG_W("TLS error -0x%04x", (unsigned)-ret);
+    return false;
+  }
+
+  mbedtls_net_context net;
+  mbedtls_ssl_context ssl;
+  mbedtls_ssl_config conf;
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_ssl_session session;
+  char sessionHost[LEAN_HTTP_HOST_MAX];
+  bool ready;
+  bool isOpen;
+  bool haveSession;
+  bool leafSeen;   // Il server ha mandato il certificato
+  bool leafPinned; // e la sua chiave corrisponde a un pin
+  uint32_t ioTimeoutMs; // Quello di connect(), anche per write()
+};
+
+static MbedTlsSocket &socketInstance() {
+  static MbedTlsSocket socket;
+  return socket;
+}
+
+HttpSocket &tlsSocket() { return socketInstance(); }
+
+const TlsStats &tlsSocketStats() { return stats; }
+
+void tlsSocketForgetSession() { socketInstance().forgetSession(); }